@@ -0,0 +1,303 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2022 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+// Measures how quickly FfmpegInput decodes files into the float buffer that TrackScanner passes to
+// libebur128. Loudness is not calculated, so that only decoding and sample conversion are timed.
+// Before that, the conversion of decoded frames into that buffer is timed on its own - as FfmpegInput
+// used to do it (per-sample loops, and a list of copies), and as it does now (swresample).
+
+extern "C" {
+#include <libavutil/channel_layout.h>
+#include <libavutil/frame.h>
+#include <libavutil/mem.h>
+#include <libswresample/swresample.h>
+}
+#include "replaygain/ffmpeginput.h"
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QList>
+#include <QString>
+#include <climits>
+#include <stdio.h>
+#include <string.h>
+
+static const int constSampleRate = 44100;
+static const int constChannels = 2;
+static const int constFrameSamples = 4608;// Usual FLAC block size
+static const int constConversionSeconds = 300;
+
+// Buffer sizes FfmpegInput used to have
+static const size_t constOldMaxFrameSize = 192000;
+static const size_t constOldBufferSize = (((constOldMaxFrameSize * 3) / 2) * sizeof(int16_t)) + 64;
+
+// Stops the compiler from dropping the conversions, as nothing else reads their output
+static volatile float sink = 0.0f;
+
+static QList<AVFrame*> createFrames(AVSampleFormat format)
+{
+	QList<AVFrame*> frames;
+	int total = constSampleRate * constConversionSeconds;
+	for (int pos = 0; pos < total; pos += constFrameSamples) {
+		AVFrame* frame = av_frame_alloc();
+		frame->format = format;
+		frame->sample_rate = constSampleRate;
+		frame->nb_samples = qMin(constFrameSamples, total - pos);
+		av_channel_layout_default(&frame->ch_layout, constChannels);
+		if (av_frame_get_buffer(frame, 0) < 0) {
+			av_frame_free(&frame);
+			break;
+		}
+		// Any values will do, as long as they are not all the same
+		int planes = av_sample_fmt_is_planar(format) ? constChannels : 1;
+		int bytes = frame->nb_samples * av_get_bytes_per_sample(format) * (planes > 1 ? 1 : constChannels);
+		for (int p = 0; p < planes; ++p) {
+			for (int b = 0; b < bytes; ++b) {
+				frame->extended_data[p][b] = (uint8_t)((pos + b) * 7 + p);
+			}
+		}
+		if (AV_SAMPLE_FMT_FLTP == format) {
+			for (int p = 0; p < planes; ++p) {
+				for (int i = 0; i < frame->nb_samples; ++i) {
+					((float*)frame->extended_data[p])[i] = ((pos + i) % 200) / 100.0f - 1.0f;
+				}
+			}
+		}
+		frames.append(frame);
+	}
+	return frames;
+}
+
+// As FfmpegInput::readOnePacket() used to convert a decoded frame
+static size_t oldConvertFrame(const AVFrame* frame, float* buffer)
+{
+	int numChannels = frame->ch_layout.nb_channels;
+	switch (frame->format) {
+	case AV_SAMPLE_FMT_S16: {
+		int16_t* dataShort = (int16_t*)frame->extended_data[0];
+		for (int i = 0; i < frame->nb_samples * numChannels; ++i) {
+			buffer[i] = ((float)dataShort[i]) / qMax(-(float)SHRT_MIN, (float)SHRT_MAX);
+		}
+		break;
+	}
+	case AV_SAMPLE_FMT_S16P: {
+		uint8_t** ed = frame->extended_data;
+		for (int i = 0; i < frame->nb_samples * numChannels; ++i) {
+			int currentChannel = i / frame->nb_samples;
+			int currentSample = i % frame->nb_samples;
+			buffer[currentSample * numChannels + currentChannel] = ((float)((int16_t*)ed[currentChannel])[currentSample]) / qMax(-(float)SHRT_MIN, (float)SHRT_MAX);
+		}
+		break;
+	}
+	case AV_SAMPLE_FMT_S32P: {
+		uint8_t** ed = frame->extended_data;
+		for (int i = 0; i < frame->nb_samples * numChannels; ++i) {
+			int currentChannel = i / frame->nb_samples;
+			int currentSample = i % frame->nb_samples;
+			buffer[currentSample * numChannels + currentChannel] = ((float)((int32_t*)ed[currentChannel])[currentSample]) / qMax(-(float)INT_MIN, (float)INT_MAX);
+		}
+		break;
+	}
+	case AV_SAMPLE_FMT_FLTP: {
+		uint8_t** ed = frame->extended_data;
+		for (int i = 0; i < frame->nb_samples * numChannels; ++i) {
+			int currentChannel = i / frame->nb_samples;
+			int currentSample = i % frame->nb_samples;
+			buffer[currentSample * numChannels + currentChannel] = ((float*)ed[currentChannel])[currentSample];
+		}
+		break;
+	}
+	default:
+		return 0;
+	}
+	return frame->nb_samples;
+}
+
+// As FfmpegInput::readFrames() used to fill its buffer - each converted frame copied into a list, then
+// copied again into the buffer. Returns the number of frames output.
+static qint64 oldConvert(const QList<AVFrame*>& frames, float& sum)
+{
+	float* scratch = new float[constOldBufferSize / 2 + 1];
+	float* buffer = new float[constOldBufferSize / 2 + 1];
+	QList<QByteArray> bufferList;
+	size_t currentBytes = 0;
+	int next = 0;
+	qint64 total = 0;
+	for (;;) {
+		size_t bufferPosition = 0;
+		while (currentBytes < constOldBufferSize && next < frames.count()) {
+			size_t numberRead = oldConvertFrame(frames.at(next++), scratch);
+			size_t bufferSize = numberRead * constChannels * sizeof(float);
+			bufferList.append(QByteArray(reinterpret_cast<const char*>(scratch), bufferSize));
+			currentBytes += bufferSize;
+		}
+		while (bufferList.count() && bufferList.first().size() + bufferPosition <= constOldBufferSize) {
+			QByteArray b = bufferList.takeAt(0);
+			memcpy((char*)buffer + bufferPosition, b.constData(), b.size());
+			bufferPosition += b.size();
+			currentBytes -= b.size();
+		}
+		if (!bufferPosition) {
+			break;
+		}
+		sum += buffer[0];
+		total += bufferPosition / sizeof(float) / constChannels;
+	}
+	delete[] scratch;
+	delete[] buffer;
+	return total;
+}
+
+// As FfmpegInput::readFrames() now fills its buffer - swresample converts straight into it
+static qint64 newConvert(const QList<AVFrame*>& frames, float& sum)
+{
+	const AVFrame* first = frames.first();
+	SwrContext* swrContext = 0;
+	if (swr_alloc_set_opts2(&swrContext, &first->ch_layout, AV_SAMPLE_FMT_FLT, first->sample_rate,
+	                        &first->ch_layout, (AVSampleFormat)first->format, first->sample_rate, 0, NULL) < 0 ||
+	    swr_init(swrContext) < 0) {
+		swr_free(&swrContext);
+		return 0;
+	}
+	size_t bufferFrames = constSampleRate;
+	float* buffer = (float*)av_malloc(bufferFrames * constChannels * sizeof(float));
+	int next = 0;
+	qint64 total = 0;
+	for (;;) {
+		size_t numberRead = 0;
+		while (numberRead < bufferFrames) {
+			uint8_t* out = (uint8_t*)(buffer + (numberRead * constChannels));
+			int space = (int)(bufferFrames - numberRead);
+			int converted = 0;
+			if (swr_get_out_samples(swrContext, 0) > 0) {
+				converted = swr_convert(swrContext, &out, space, NULL, 0);
+			}
+			if (0 == converted) {
+				if (next >= frames.count()) {
+					break;
+				}
+				const AVFrame* frame = frames.at(next++);
+				converted = swr_convert(swrContext, &out, space, (const uint8_t**)frame->extended_data, frame->nb_samples);
+			}
+			if (converted < 0) {
+				break;
+			}
+			numberRead += converted;
+		}
+		if (!numberRead) {
+			break;
+		}
+		sum += buffer[0];
+		total += numberRead;
+	}
+	av_free(buffer);
+	swr_free(&swrContext);
+	return total;
+}
+
+static void timeConversion(const char* name, AVSampleFormat format)
+{
+	QList<AVFrame*> frames = createFrames(format);
+	if (frames.isEmpty()) {
+		return;
+	}
+	printf("%s:", name);
+	for (int i = 0; i < 2; ++i) {
+		float sum = 0.0f;
+		QElapsedTimer timer;
+		timer.start();
+		qint64 total = 0 == i ? oldConvert(frames, sum) : newConvert(frames, sum);
+		qint64 ms = qMax(timer.elapsed(), (qint64)1);
+		sink = sum;
+		if (total != (qint64)constSampleRate * constConversionSeconds) {
+			printf(" %s produced %lld frames, not %lld", 0 == i ? "before" : "after", (long long)total,
+			       (long long)constSampleRate * constConversionSeconds);
+		}
+		printf(" %s %lld ms (%.1f MB/s of float samples)%s", 0 == i ? "before" : "after", (long long)ms,
+		       ((total * constChannels * sizeof(float)) / (1024.0 * 1024.0)) / (ms / 1000.0), 0 == i ? "," : "\n");
+	}
+	for (AVFrame* frame : frames) {
+		av_frame_free(&frame);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		printf("Usage: %s <file 1..N>\n", argv[0]);
+		return -1;
+	}
+
+	printf("Converting %d minutes of %dHz stereo to float\n", constConversionSeconds / 60, constSampleRate);
+	timeConversion("16-bit planar", AV_SAMPLE_FMT_S16P);
+	timeConversion("32-bit planar", AV_SAMPLE_FMT_S32P);
+	timeConversion("float planar", AV_SAMPLE_FMT_FLTP);
+	timeConversion("16-bit interleaved", AV_SAMPLE_FMT_S16);
+	printf("\n");
+
+	FfmpegInput::init();
+	qint64 totalFileBytes = 0;
+	qint64 totalSamples = 0;
+	qint64 totalSeconds = 0;
+	qint64 totalMs = 0;
+	for (int i = 1; i < argc; ++i) {
+		QString fileName = QString::fromLocal8Bit(argv[i]);
+		qint64 fileBytes = QFileInfo(fileName).size();
+		// Read the whole file first, so that the disk is not timed
+		QFile file(fileName);
+		if (file.open(QIODevice::ReadOnly)) {
+			while (!file.read(1024 * 1024).isEmpty()) {
+			}
+		}
+
+		QElapsedTimer timer;
+		timer.start();
+		FfmpegInput input(fileName);
+		if (!input || !input.allocateBuffer()) {
+			printf("%s: failed to open\n", argv[i]);
+			continue;
+		}
+		qint64 frames = 0;
+		size_t read = 0;
+		while ((read = input.readFrames())) {
+			frames += read;
+		}
+		qint64 ms = qMax(timer.elapsed(), (qint64)1);
+		qint64 seconds = frames / (qint64)qMax(input.sampleRate(), 1ul);
+
+		printf("%s: %.1f MB in %lld ms - %.1f MB/s, %lldx realtime\n", argv[i], fileBytes / (1024.0 * 1024.0), (long long)ms,
+		       (fileBytes / (1024.0 * 1024.0)) / (ms / 1000.0), (long long)((seconds * 1000) / ms));
+		totalFileBytes += fileBytes;
+		totalSamples += frames * input.channels();
+		totalSeconds += seconds;
+		totalMs += ms;
+	}
+
+	if (totalMs > 0) {
+		printf("Total: %.1f MB of input at %.1f MB/s (%.1f MB/s of float samples), %lldx realtime\n",
+		       totalFileBytes / (1024.0 * 1024.0), (totalFileBytes / (1024.0 * 1024.0)) / (totalMs / 1000.0),
+		       ((totalSamples * sizeof(float)) / (1024.0 * 1024.0)) / (totalMs / 1000.0), (long long)((totalSeconds * 1000) / totalMs));
+	}
+	return 0;
+}
@@ -0,0 +1,200 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2022 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+// Compares the ways CopyJob can copy a file to a device: the userspace loop it used to use (32kB chunks),
+// its current fallback loop (1MB chunks), and the kernel copies it now tries first. The same step sizes,
+// and fallbacks, as devices/filejob.cpp are used. The time includes fsync(), so that data still in the
+// page cache is not counted as written.
+
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+static const size_t constOldChunkSize = 32 * 1024;
+static const size_t constChunkSize = 1024 * 1024;
+static const size_t constKernelChunkSize = 8 * 1024 * 1024;
+
+enum Method {
+	M_OldLoop,
+	M_Loop,
+	M_CopyFileRange,
+	M_Sendfile,
+	M_Clone,
+
+	M_Count
+};
+
+static const char* methodName(int m)
+{
+	switch (m) {
+	case M_OldLoop: return "read/write, 32kB";
+	case M_Loop: return "read/write, 1MB";
+	case M_CopyFileRange: return "copy_file_range";
+	case M_Sendfile: return "sendfile";
+	case M_Clone: return "FICLONE";
+	default: return "";
+	}
+}
+
+static bool userspaceCopy(int srcFd, int destFd, size_t chunkSize)
+{
+	std::vector<char> buffer(chunkSize);
+	for (;;) {
+		ssize_t bytesRead = read(srcFd, buffer.data(), chunkSize);
+		if (bytesRead < 0) {
+			if (EINTR == errno) {
+				continue;
+			}
+			return false;
+		}
+		if (0 == bytesRead) {
+			return true;
+		}
+		ssize_t writePos = 0;
+		while (writePos < bytesRead) {
+			ssize_t bytesWritten = write(destFd, buffer.data() + writePos, bytesRead - writePos);
+			if (bytesWritten < 0) {
+				if (EINTR == errno) {
+					continue;
+				}
+				return false;
+			}
+			writePos += bytesWritten;
+		}
+	}
+}
+
+static bool kernelCopy(int srcFd, int destFd, bool useCopyRange, off_t size)
+{
+	off_t copied = 0;
+	for (;;) {
+		ssize_t rv = useCopyRange
+		                     ? copy_file_range(srcFd, nullptr, destFd, nullptr, constKernelChunkSize, 0)
+		                     : sendfile(destFd, srcFd, nullptr, constKernelChunkSize);
+		if (rv < 0) {
+			if (EINTR == errno) {
+				continue;
+			}
+			return false;
+		}
+		if (0 == rv) {
+			// As per CopyJob, nothing copied is treated as not supported, and a short copy as a failure
+			errno = 0 == copied ? EOPNOTSUPP : EIO;
+			return copied == size;
+		}
+		copied += rv;
+	}
+}
+
+// Returns the time taken in seconds, or a negative value (with error set) if the method cannot be used for these files.
+static double copy(int method, const std::string& src, off_t size, const std::string& dest, int& error)
+{
+	error = 0;
+	int srcFd = open(src.c_str(), O_RDONLY);
+	if (srcFd < 0) {
+		error = errno;
+		return -1.0;
+	}
+	int destFd = open(dest.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (destFd < 0) {
+		error = errno;
+		close(srcFd);
+		return -1.0;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	bool ok = false;
+	switch (method) {
+	case M_OldLoop: ok = userspaceCopy(srcFd, destFd, constOldChunkSize); break;
+	case M_Loop: ok = userspaceCopy(srcFd, destFd, constChunkSize); break;
+	case M_CopyFileRange: ok = kernelCopy(srcFd, destFd, true, size); break;
+	case M_Sendfile: ok = kernelCopy(srcFd, destFd, false, size); break;
+#ifdef FICLONE
+	case M_Clone: ok = 0 == ioctl(destFd, FICLONE, srcFd); break;
+#endif
+	default: errno = EOPNOTSUPP; break;
+	}
+	if (ok) {
+		ok = 0 == fsync(destFd);
+	}
+	if (!ok) {
+		error = errno;
+	}
+	std::chrono::duration<double> taken = std::chrono::steady_clock::now() - start;
+
+	close(srcFd);
+	close(destFd);
+	unlink(dest.c_str());
+	return ok ? taken.count() : -1.0;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3) {
+		printf("Usage: %s <source file> <destination folder> [runs]\n", argv[0]);
+		return -1;
+	}
+
+	std::string src(argv[1]);
+	std::string dest = std::string(argv[2]) + "/cantata-bench-filecopy.tmp";
+	int runs = argc > 3 ? atoi(argv[3]) : 3;
+	struct stat info;
+	if (0 != stat(src.c_str(), &info) || 0 == info.st_size || runs < 1) {
+		printf("Invalid source file, or number of runs\n");
+		return -1;
+	}
+
+	double mb = info.st_size / (1024.0 * 1024.0);
+	printf("%s, %.1f MB, best of %d runs\n", src.c_str(), mb, runs);
+	for (int m = 0; m < M_Count; ++m) {
+		double best = -1.0;
+		int error = 0;
+		for (int r = 0; r < runs; ++r) {
+			double taken = copy(m, src, info.st_size, dest, error);
+			if (taken < 0.0) {
+				best = -1.0;
+				break;
+			}
+			if (best < 0.0 || taken < best) {
+				best = taken;
+			}
+		}
+		if (best < 0.0) {
+			printf("%-20s not supported for these files (%s)\n", methodName(m), strerror(error));
+		}
+		else {
+			printf("%-20s %8.1f MB/s\n", methodName(m), mb / best);
+		}
+	}
+	return 0;
+}
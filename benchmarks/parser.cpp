@@ -0,0 +1,317 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2022 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+// Compares the previous MPD song parser - which split the response into a list of lines, and matched each
+// line against every key in turn - with the current one, which walks the response in place. Replies are
+// generated in the form of "playlistinfo" (play queue) and "listallinfo" (library, with directory entries).
+// The per-song finalisation (guessing tags, stream names, etc.) is the same for both, so is not timed.
+
+#include "mpd-interface/mpdparselines.h"
+#include "mpd-interface/song.h"
+#include "support/utils.h"
+#include <QByteArray>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QList>
+#include <QStringList>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace MPDParseUtils;
+
+static const int constDefaultSongs = 100000;
+static const int constTracksPerAlbum = 12;
+static const int constAlbumsPerArtist = 8;
+
+static QByteArray generate(int count, bool library)
+{
+	QByteArray data;
+	data.reserve(count * 400);
+	int lastAlbum = -1;
+	for (int i = 0; i < count; ++i) {
+		int album = i / constTracksPerAlbum;
+		int artist = album / constAlbumsPerArtist;
+		int track = (i % constTracksPerAlbum) + 1;
+		QByteArray dir = "Artist " + QByteArray::number(artist) + "/Album " + QByteArray::number(album);
+		if (library && album != lastAlbum) {
+			if (0 == album % constAlbumsPerArtist) {
+				data += "directory: Artist " + QByteArray::number(artist) + "\nLast-Modified: 2021-03-04T05:06:07Z\n";
+			}
+			data += "directory: " + dir + "\nLast-Modified: 2021-03-04T05:06:07Z\n";
+			lastAlbum = album;
+		}
+		data += "file: " + dir + '/' + QByteArray::number(track) + " - Track " + QByteArray::number(track) + ".flac\n";
+		data += "Last-Modified: 2021-03-04T05:06:07Z\n";
+		data += "Format: 44100:16:2\n";
+		data += "Artist: Artist " + QByteArray::number(artist) + '\n';
+		data += "AlbumArtist: Artist " + QByteArray::number(artist) + '\n';
+		data += "Title: Track " + QByteArray::number(track) + " of album " + QByteArray::number(album) + '\n';
+		data += "Album: Album " + QByteArray::number(album) + '\n';
+		data += "Track: " + QByteArray::number(track) + '/' + QByteArray::number(constTracksPerAlbum) + '\n';
+		data += "Date: " + QByteArray::number(1960 + (album % 60)) + "-01-01\n";
+		data += "Genre: Genre " + QByteArray::number(artist % 40) + '\n';
+		data += "Disc: 1/1\n";
+		data += "MUSICBRAINZ_ALBUMID: 5a1e" + QByteArray::number(album) + "-0000-4000-8000-000000000000\n";
+		data += "Time: " + QByteArray::number(180 + (i % 240)) + '\n';
+		data += "duration: " + QByteArray::number(180 + (i % 240)) + ".000\n";
+		if (!library) {
+			data += "Pos: " + QByteArray::number(i) + "\nId: " + QByteArray::number(i + 1) + '\n';
+		}
+	}
+	data += "OK\n";
+	return data;
+}
+
+// Previous parser, as it was before being changed to walk the response in place
+static const QByteArray constOkValue("OK");
+static const QByteArray constFileKey("file: ");
+static const QByteArray constPlaylistKey("playlist: ");
+static const QByteArray constDirectoryKey("directory: ");
+static const QByteArray constTimeKey("Time: ");
+static const QByteArray constAlbumKey("Album: ");
+static const QByteArray constArtistKey("Artist: ");
+static const QByteArray constAlbumArtistKey("AlbumArtist: ");
+static const QByteArray constGroupingKey("Grouping: ");
+static const QByteArray constAlbumSortKey("AlbumSort: ");
+static const QByteArray constArtistSortKey("ArtistSort: ");
+static const QByteArray constAlbumArtistSortKey("AlbumArtistSort: ");
+static const QByteArray constComposerKey("Composer: ");
+static const QByteArray constPerformerKey("Performer: ");
+static const QByteArray constCommentKey("Comment: ");
+static const QByteArray constTitleKey("Title: ");
+static const QByteArray constTrackKey("Track: ");
+static const QByteArray constIdKey("Id: ");
+static const QByteArray constDiscKey("Disc: ");
+static const QByteArray constDateKey("Date: ");
+static const QByteArray constOriginalDateKey("OriginalDate: ");
+static const QByteArray constGenreKey("Genre: ");
+static const QByteArray constNameKey("Name: ");
+static const QByteArray constPriorityKey("Prio: ");
+static const QByteArray constAlbumId("MUSICBRAINZ_ALBUMID: ");
+static const QByteArray constLastModifiedKey("Last-Modified: ");
+
+static Song oldParseSong(const QList<QByteArray>& lines, Location location)
+{
+	Song song;
+	for (const QByteArray& line : lines) {
+		if (line.startsWith(constFileKey)) {
+			song.file = QString::fromUtf8(line.mid(constFileKey.length()));
+		}
+		else if (line.startsWith(constTimeKey)) {
+			song.time = line.mid(constTimeKey.length()).toUInt();
+		}
+		else if (line.startsWith(constAlbumKey)) {
+			song.album = QString::fromUtf8(line.mid(constAlbumKey.length()));
+		}
+		else if (line.startsWith(constArtistKey)) {
+			song.artist = QString::fromUtf8(line.mid(constArtistKey.length()));
+		}
+		else if (line.startsWith(constAlbumArtistKey)) {
+			song.albumartist = QString::fromUtf8(line.mid(constAlbumArtistKey.length()));
+		}
+		else if (line.startsWith(constGroupingKey)) {
+			song.setGrouping(QString::fromUtf8(line.mid(constGroupingKey.length())));
+		}
+		else if (line.startsWith(constComposerKey)) {
+			song.setComposer(QString::fromUtf8(line.mid(constComposerKey.length())));
+		}
+		else if (line.startsWith(constTitleKey)) {
+			song.title = QString::fromUtf8(line.mid(constTitleKey.length()));
+		}
+		else if (line.startsWith(constTrackKey)) {
+			int v = line.mid(constTrackKey.length()).split('/').at(0).toInt();
+			song.track = v < 0 ? 0 : v;
+		}
+		else if (Loc_Library != location && Loc_Search != location && line.startsWith(constIdKey)) {
+			song.id = line.mid(constIdKey.length()).toUInt();
+		}
+		else if (line.startsWith(constDiscKey)) {
+			int v = line.mid(constDiscKey.length()).split('/').at(0).toInt();
+			song.disc = v < 0 ? 0 : v;
+		}
+		else if (line.startsWith(constDateKey)) {
+			QByteArray value = line.mid(constDateKey.length());
+			int v = value.length() > 4 ? value.left(4).toUInt() : value.toUInt();
+			song.year = v < 0 ? 0 : v;
+		}
+		else if (line.startsWith(constOriginalDateKey)) {
+			QByteArray value = line.mid(constOriginalDateKey.length());
+			int v = value.length() > 4 ? value.left(4).toUInt() : value.toUInt();
+			song.origYear = v < 0 ? 0 : v;
+		}
+		else if (line.startsWith(constGenreKey)) {
+			song.addGenre(QString::fromUtf8(line.mid(constGenreKey.length())));
+		}
+		else if (line.startsWith(constNameKey)) {
+			song.setName(QString::fromUtf8(line.mid(constNameKey.length())));
+		}
+		else if (line.startsWith(constPlaylistKey)) {
+			song.file = QString::fromUtf8(line.mid(constPlaylistKey.length()));
+			song.title = Utils::getFile(song.file);
+			song.type = Song::Playlist;
+		}
+		else if (line.startsWith(constAlbumId)) {
+			song.setMbAlbumId(QString::fromUtf8(line.mid(constAlbumId.length())));
+		}
+		else if ((Loc_Search == location || Loc_Library == location) && line.startsWith(constLastModifiedKey)) {
+			song.lastModified = QDateTime::fromString(QString::fromUtf8(line.mid(constLastModifiedKey.length())), Qt::ISODate).toSecsSinceEpoch();
+		}
+		else if ((Loc_Search == location || Loc_Playlists == location || Loc_PlayQueue == location) && line.startsWith(constPerformerKey)) {
+			if (song.hasPerformer()) {
+				song.setPerformer(song.performer() + QLatin1String(", ") + QString::fromUtf8(line.mid(constPerformerKey.length())));
+			}
+			else {
+				song.setPerformer(QString::fromUtf8(line.mid(constPerformerKey.length())));
+			}
+		}
+		else if (Loc_PlayQueue == location) {
+			if (line.startsWith(constPriorityKey)) {
+				song.priority = line.mid(constPriorityKey.length()).toUInt();
+			}
+			else if (line.startsWith(constCommentKey)) {
+				song.setComment(QString::fromUtf8(line.mid(constCommentKey.length())));
+			}
+		}
+		else if (Loc_Library == location) {
+			if (line.startsWith(constAlbumSortKey)) {
+				song.setAlbumSort(QString::fromUtf8(line.mid(constAlbumSortKey.length())));
+			}
+			else if (line.startsWith(constArtistSortKey)) {
+				song.setArtistSort(QString::fromUtf8(line.mid(constArtistSortKey.length())));
+			}
+			else if (line.startsWith(constAlbumArtistSortKey)) {
+				song.setAlbumArtistSort(QString::fromUtf8(line.mid(constAlbumArtistSortKey.length())));
+			}
+		}
+	}
+	return song;
+}
+
+// As the previous parseSongs(), and parseDirItems() - which also collected "directory:" entries
+static QList<Song> oldParse(const QByteArray& data, Location location, QStringList& dirs)
+{
+	QList<Song> songs;
+	QList<QByteArray> currentItem;
+	QList<QByteArray> lines = data.split('\n');
+	int amountOfLines = lines.size();
+
+	for (int i = 0; i < amountOfLines; i++) {
+		const QByteArray& line = lines.at(i);
+		if (constOkValue == line) {
+			continue;
+		}
+		if (line.startsWith(constDirectoryKey)) {
+			dirs.append(QString::fromUtf8(line.mid(constDirectoryKey.length())));
+		}
+		if (!line.isEmpty()) {
+			currentItem.append(line);
+		}
+		if (i == amountOfLines - 1 || lines.at(i + 1).startsWith(constFileKey) || lines.at(i + 1).startsWith(constPlaylistKey)) {
+			Song song = oldParseSong(currentItem, location);
+			if (!song.file.isEmpty()) {
+				songs.append(song);
+			}
+			currentItem.clear();
+		}
+	}
+	return songs;
+}
+
+// As SongReader, and parseDirItems(), now do
+static QList<Song> newParse(const QByteArray& data, Location location, QStringList& dirs)
+{
+	QList<Song> songs;
+	Song current;
+	bool haveItem = false;
+	qsizetype pos = 0;
+	QByteArrayView line;
+	QByteArrayView key;
+	QByteArrayView value;
+	while (nextLine(data, pos, line)) {
+		if (!splitLine(line, key, value)) {
+			continue;
+		}
+		if (isKey(key, "directory")) {
+			dirs.append(QString::fromUtf8(value));
+			continue;
+		}
+		if (haveItem && (isKey(key, "file") || isKey(key, "playlist"))) {
+			if (!current.file.isEmpty()) {
+				songs.append(std::move(current));
+			}
+			current = Song();
+			haveItem = false;
+		}
+		parseSongLine(current, key, value, location);
+		haveItem = true;
+	}
+	if (haveItem && !current.file.isEmpty()) {
+		songs.append(std::move(current));
+	}
+	return songs;
+}
+
+typedef QList<Song> (*ParseFunc)(const QByteArray&, Location, QStringList&);
+
+// Best of runs, in ms
+static qint64 time(ParseFunc func, const QByteArray& data, Location location, int runs, int& songCount)
+{
+	qint64 best = -1;
+	for (int r = 0; r < runs; ++r) {
+		QStringList dirs;
+		QElapsedTimer timer;
+		timer.start();
+		QList<Song> songs = func(data, location, dirs);
+		qint64 ms = timer.elapsed();
+		songCount = songs.count();
+		if (best < 0 || ms < best) {
+			best = ms;
+		}
+	}
+	return qMax(best, (qint64)1);
+}
+
+int main(int argc, char* argv[])
+{
+	int count = argc > 1 ? atoi(argv[1]) : constDefaultSongs;
+	int runs = argc > 2 ? atoi(argv[2]) : 5;
+	if (count <= 0 || runs <= 0) {
+		printf("Usage: %s [number of songs] [runs]\n", argv[0]);
+		return -1;
+	}
+
+	printf("%d songs, best of %d runs\n", count, runs);
+	for (int library = 0; library < 2; ++library) {
+		QByteArray data = generate(count, library);
+		Location location = library ? Loc_Library : Loc_PlayQueue;
+		int oldSongs = 0;
+		int newSongs = 0;
+		qint64 oldMs = time(oldParse, data, location, runs, oldSongs);
+		qint64 newMs = time(newParse, data, location, runs, newSongs);
+		printf("%-13s %.1f MB  old: %5lld ms (%.2f us/song)  new: %5lld ms (%.2f us/song)  %.1fx%s\n",
+		       library ? "listallinfo" : "playlistinfo", data.size() / (1024.0 * 1024.0),
+		       (long long)oldMs, (oldMs * 1000.0) / count, (long long)newMs, (newMs * 1000.0) / count, (double)oldMs / newMs,
+		       oldSongs == newSongs && newSongs == count ? "" : "  SONG COUNT MISMATCH");
+	}
+	return 0;
+}
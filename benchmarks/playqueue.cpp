@@ -0,0 +1,260 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2022 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+// Times the play queue diff in PlayQueueModel::update() - which turns the previous queue into the one just
+// received from MPD with row removals, inserts, and moves - as it was, and as it is now. Qt's model signals
+// are not emitted, so only the diff itself is timed. The rows here hold just the fields update() reads or
+// copies, so neither version depends on the rest of Cantata. Keep in step with models/playqueuemodel.cpp.
+// MPD's changes are only diffed while there are no more than MPDConnection::constMaxPqChanges of them - more
+// than that, and the whole queue is reloaded and the model reset - so each change here stays within that.
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct Row {
+	int id;
+	unsigned int time;
+	unsigned char rating;
+	std::string file;
+};
+
+typedef std::vector<Row> Rows;
+typedef std::unordered_set<int> Ids;
+
+static Ids idsOf(const Rows& rows)
+{
+	Ids ids;
+	ids.reserve(rows.size());
+	for (const Row& r : rows) {
+		ids.insert(r.id);
+	}
+	return ids;
+}
+
+// As update() was - a linear search of the queue for each removed, moved, or inserted song
+static int oldRowById(const Rows& songs, int id)
+{
+	for (size_t i = 0; i < songs.size(); ++i) {
+		if (songs[i].id == id) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static void oldUpdate(Rows& songs, Ids& ids, const Rows& songList)
+{
+	Ids newIds = idsOf(songList);
+	for (int id : ids) {
+		if (!newIds.count(id)) {
+			int row = oldRowById(songs, id);
+			if (-1 != row) {
+				songs.erase(songs.begin() + row);
+			}
+		}
+	}
+	for (size_t i = 0; i < songList.size(); ++i) {
+		Row s = songList[i];
+		bool newSong = i >= songs.size();
+		if (newSong || s.id != songs[i].id) {
+			int existingPos = newSong ? -1 : oldRowById(songs, s.id);
+			if (-1 == existingPos) {
+				songs.insert(songs.begin() + i, s);
+			}
+			else {
+				Row old = songs[existingPos];
+				songs.erase(songs.begin() + existingPos);
+				s.rating = old.rating;
+				s.time = old.time;
+				songs.insert(songs.begin() + i, s);
+			}
+		}
+		else {
+			s.rating = songs[i].rating;
+			songs[i] = s;
+		}
+	}
+	songs.resize(songList.size());
+	ids = newIds;
+}
+
+// As update() is now - removals in one backwards pass, and moved songs found by scanning forward
+static void newUpdate(Rows& songs, Ids& ids, const Rows& songList)
+{
+	Ids newIds = idsOf(songList);
+	Ids removed;
+	for (int id : ids) {
+		if (!newIds.count(id)) {
+			removed.insert(id);
+		}
+	}
+	if (!removed.empty()) {
+		for (int row = songs.size() - 1; row >= 0; --row) {
+			if (removed.count(songs[row].id)) {
+				int last = row;
+				while (row > 0 && removed.count(songs[row - 1].id)) {
+					--row;
+				}
+				songs.erase(songs.begin() + row, songs.begin() + last + 1);
+			}
+		}
+	}
+	for (size_t i = 0; i < songList.size(); ++i) {
+		Row s = songList[i];
+		bool newSong = i >= songs.size();
+		if (newSong || s.id != songs[i].id) {
+			int existingPos = -1;
+			if (!newSong && ids.count(s.id)) {
+				for (size_t row = i + 1; row < songs.size() && -1 == existingPos; ++row) {
+					if (songs[row].id == s.id) {
+						existingPos = row;
+					}
+				}
+			}
+			if (-1 == existingPos) {
+				songs.insert(songs.begin() + i, s);
+			}
+			else {
+				Row old = songs[existingPos];
+				songs.erase(songs.begin() + existingPos);
+				s.rating = old.rating;
+				s.time = old.time;
+				songs.insert(songs.begin() + i, s);
+			}
+		}
+		else {
+			s.rating = songs[i].rating;
+			songs[i] = s;
+		}
+	}
+	songs.resize(songList.size());
+	ids = newIds;
+}
+
+static Rows queue(int count, int firstId)
+{
+	Rows rows;
+	rows.reserve(count);
+	for (int i = 0; i < count; ++i) {
+		int id = firstId + i;
+		rows.push_back({id, 180u + (id % 240), 0, "Artist " + std::to_string(id / 96) + "/Album " + std::to_string(id / 12) + "/" + std::to_string(id) + ".flac"});
+	}
+	return rows;
+}
+
+typedef void (*UpdateFunc)(Rows&, Ids&, const Rows&);
+
+// Best of runs, in microseconds
+static long long time(UpdateFunc func, const Rows& before, const Rows& after, int runs)
+{
+	long long best = -1;
+	for (int r = 0; r < runs; ++r) {
+		Rows songs = before;
+		Ids ids = idsOf(before);
+		auto start = std::chrono::steady_clock::now();
+		func(songs, ids, after);
+		long long us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+		bool ok = songs.size() == after.size();
+		for (size_t i = 0; ok && i < songs.size(); ++i) {
+			ok = songs[i].id == after[i].id;
+		}
+		if (!ok) {
+			printf("Update produced the wrong queue!\n");
+			exit(-1);
+		}
+		if (best < 0 || us < best) {
+			best = us;
+		}
+	}
+	return best;
+}
+
+int main(int argc, char* argv[])
+{
+	int runs = argc > 1 ? atoi(argv[1]) : 5;
+	if (runs < 1) {
+		printf("Usage: %s [runs]\n", argv[0]);
+		return -1;
+	}
+
+	const int sizes[] = {1000, 10000, 50000};
+	printf("Best of %d runs, times in ms\n", runs);
+	printf("%-32s %7s %10s %10s\n", "change", "size", "before", "after");
+	for (int size : sizes) {
+		Rows before = queue(size, 1);
+		std::mt19937 rng(size);
+
+		struct Case {
+			const char* name;
+			Rows after;
+		};
+		std::vector<Case> cases;
+
+		// 100 songs removed, spread across the queue
+		Rows removed;
+		for (const Row& r : before) {
+			if (0 != r.id % (size / 100)) {
+				removed.push_back(r);
+			}
+		}
+		cases.push_back({"remove 100 (scattered)", removed});
+
+		// Last 100 songs moved to the start
+		Rows moved(before.end() - 100, before.end());
+		moved.insert(moved.end(), before.begin(), before.end() - 100);
+		cases.push_back({"move 100 from end to start", moved});
+
+		// 100 new songs inserted at the start
+		Rows inserted = queue(100, size + 1);
+		inserted.insert(inserted.end(), before.begin(), before.end());
+		cases.push_back({"insert 100 at start", inserted});
+
+		// 1000 new songs appended
+		Rows appended = before;
+		Rows extra = queue(1000, size + 1);
+		appended.insert(appended.end(), extra.begin(), extra.end());
+		cases.push_back({"append 1000", appended});
+
+		// 100 pairs of songs swapped
+		Rows swapped = before;
+		std::uniform_int_distribution<int> dist(0, size - 1);
+		for (int i = 0; i < 100; ++i) {
+			std::swap(swapped[dist(rng)], swapped[dist(rng)]);
+		}
+		cases.push_back({"swap 100 pairs", swapped});
+
+		for (const Case& c : cases) {
+			long long oldUs = time(oldUpdate, before, c.after, runs);
+			long long newUs = time(newUpdate, before, c.after, runs);
+			printf("%-32s %7d %10.2f %10.2f\n", c.name, size, oldUs / 1000.0, newUs / 1000.0);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,199 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2022 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+// Measures the heap used per Song when a large library is held in memory - with each string
+// allocated separately (as when parsed from an MPD response), and once the songs have been interned.
+// The same library is also held in Song's previous layout, so that one run gives both figures.
+
+#include "mpd-interface/song.h"
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined __GLIBC_PREREQ
+#if __GLIBC_PREREQ(2, 33)
+#define HAVE_MALLINFO2
+#endif
+#endif
+
+static const int constDefaultSongs = 200000;
+static const int constTracksPerAlbum = 12;
+static const int constAlbumsPerArtist = 8;
+static const int constNumGenres = 40;
+
+static qint64 heapInUse()
+{
+#ifdef HAVE_MALLINFO2
+	struct mallinfo2 mi = mallinfo2();
+#else
+	struct mallinfo mi = mallinfo();
+#endif
+	// Small allocations, plus those large enough to have been mmap'ed
+	return (qint64)mi.uordblks + (qint64)mi.hblkhd;
+}
+
+// Each value is converted from UTF-8, so has its own buffer - as happens when parsing.
+static QString str(const char* fmt, int a, int b = 0)
+{
+	return QString::fromUtf8(QByteArray(fmt).replace("%1", QByteArray::number(a)).replace("%2", QByteArray::number(b)));
+}
+
+// Song's data members as they were before extra fields were held in a flat list, and strings interned
+struct OldSong {
+	virtual ~OldSong() {}
+	void setExtraField(quint32 f, const QString& v)
+	{
+		extra[f] = v;
+		extraFields |= f;
+	}
+
+	QString file;
+	QString album;
+	QString artist;
+	QString albumartist;
+	QString title;
+	QString genres[Song::constNumGenres];
+	QHash<quint32, QString> extra;
+	quint32 extraFields = 0;
+	mutable quint8 priority = 0;
+	quint8 disc : 5;
+	quint8 blank : 3;
+	quint16 time = 0;
+	quint16 track = 0;
+	quint16 origYear = 0;
+	quint16 year = 0;
+	mutable Song::Type type : 7;
+	mutable bool guessed : 1;
+	qint32 id = -1;
+	qint32 size = 0;
+	mutable quint8 rating = 0;
+	uint lastModified = 0;
+	quint16 key = 0;
+};
+
+static OldSong createOldSong(int index)
+{
+	int album = index / constTracksPerAlbum;
+	int artist = album / constAlbumsPerArtist;
+	int track = (index % constTracksPerAlbum) + 1;
+	OldSong s;
+	s.file = str("Artist %1/Album %2/", artist, album) + str("%1 - Track %1.flac", track);
+	s.artist = str("Artist %1", artist);
+	s.albumartist = str("Artist %1", artist);
+	s.album = str("Album %1 by artist %2", album, artist);
+	s.title = str("Track %1 of album %2", track, album);
+	s.genres[0] = str("Genre %1", artist % constNumGenres);
+	if (0 == album % 3) {
+		s.genres[1] = str("Genre %1", (artist + 1) % constNumGenres);
+	}
+	if (0 == artist % 5) {
+		s.setExtraField(Song::Composer, str("Composer %1", artist));
+	}
+	if (0 == artist % 4) {
+		s.setExtraField(Song::ArtistSort, str("Artist %1, The", artist));
+	}
+	s.setExtraField(Song::MusicBrainzAlbumId, str("5a1e%1-0000-4000-8000-%2", album, artist));
+	s.track = track;
+	s.disc = 1;
+	s.blank = 0;
+	s.type = Song::Standard;
+	s.guessed = false;
+	s.year = 1960 + (album % 60);
+	s.time = 180 + (index % 240);
+	s.lastModified = 1600000000 + index;
+	return s;
+}
+
+static Song createSong(int index)
+{
+	int album = index / constTracksPerAlbum;
+	int artist = album / constAlbumsPerArtist;
+	int track = (index % constTracksPerAlbum) + 1;
+	Song s;
+	s.file = str("Artist %1/Album %2/", artist, album) + str("%1 - Track %1.flac", track);
+	s.artist = str("Artist %1", artist);
+	s.albumartist = str("Artist %1", artist);
+	s.album = str("Album %1 by artist %2", album, artist);
+	s.title = str("Track %1 of album %2", track, album);
+	s.genres[0] = str("Genre %1", artist % constNumGenres);
+	if (0 == album % 3) {
+		s.genres[1] = str("Genre %1", (artist + 1) % constNumGenres);
+	}
+	if (0 == artist % 5) {
+		s.setComposer(str("Composer %1", artist));
+	}
+	if (0 == artist % 4) {
+		s.setArtistSort(str("Artist %1, The", artist));
+	}
+	s.setMbAlbumId(str("5a1e%1-0000-4000-8000-%2", album, artist));
+	s.track = track;
+	s.disc = 1;
+	s.year = 1960 + (album % 60);
+	s.time = 180 + (index % 240);
+	s.lastModified = 1600000000 + index;
+	return s;
+}
+
+int main(int argc, char* argv[])
+{
+	int count = argc > 1 ? atoi(argv[1]) : constDefaultSongs;
+	if (count <= 0) {
+		printf("Usage: %s [number of songs]\n", argv[0]);
+		return -1;
+	}
+
+	// Library chunks are passed around as lists, so size the list as the whole library would be
+	qint64 base = heapInUse();
+	QList<OldSong>* oldSongs = new QList<OldSong>();
+	oldSongs->reserve(count);
+	for (int i = 0; i < count; ++i) {
+		oldSongs->append(createOldSong(i));
+	}
+	qint64 previous = heapInUse() - base;
+	delete oldSongs;
+
+	base = heapInUse();
+	QList<Song>* songs = new QList<Song>();
+	songs->reserve(count);
+	for (int i = 0; i < count; ++i) {
+		songs->append(createSong(i));
+	}
+	qint64 separate = heapInUse() - base;
+
+	for (Song& s : *songs) {
+		s.intern();
+	}
+	qint64 interned = heapInUse() - base;
+
+	printf("songs:              %d\n", count);
+	printf("sizeof(Song):       %d bytes (previously %d)\n", (int)sizeof(Song), (int)sizeof(OldSong));
+	printf("previous layout:    %lld bytes total, %.1f bytes/song\n", (long long)previous, (double)previous / count);
+	printf("separate strings:   %lld bytes total, %.1f bytes/song\n", (long long)separate, (double)separate / count);
+	printf("interned strings:   %lld bytes total, %.1f bytes/song\n", (long long)interned, (double)interned / count);
+
+	delete songs;
+	return 0;
+}
@@ -33,7 +33,7 @@
 #include <QSqlQuery>
 #include <algorithm>
 
-static const int constSchemaVersion = 5;
+static const int constSchemaVersion = 6;
 
 bool LibraryDb::dbgEnabled = false;
 #define DBUG \
@@ -496,7 +496,7 @@ private:
 };
 
 LibraryDb::LibraryDb(QObject* p, const QString& name)
-	: QObject(p), dbName(name), currentVersion(0), newVersion(0), db(nullptr), insertSongQuery(nullptr)
+	: QObject(p), dbName(name), currentVersion(0), newVersion(0), db(nullptr), insertSongQuery(nullptr), removeSongQuery(nullptr), removeFtsQuery(nullptr), songAlbumQuery(nullptr), incrementalUpdates(false), isIncrementalUpdate(false)
 {
 	DBUG;
 }
@@ -516,12 +516,26 @@ void LibraryDb::clear()
 	}
 }
 
+// Remove a database, and the write-ahead log and shared-memory index SQLite creates alongside it in WAL mode.
+// All connections to the database must have been closed - otherwise a stale log could be applied to a new file.
+void LibraryDb::removeFiles(const QString& dbFile)
+{
+	if (dbFile.isEmpty()) {
+		return;
+	}
+	for (const QString& f : QStringList() << dbFile << dbFile + "-wal" << dbFile + "-shm") {
+		if (QFile::exists(f)) {
+			QFile::remove(f);
+		}
+	}
+}
+
 void LibraryDb::erase()
 {
+	// Close this connection first. Callers must ensure any other connection to the file is closed too -
+	// e.g. MpdLibraryDb closes the reader before the writer erases.
 	reset();
-	if (!dbFileName.isEmpty() && QFile::exists(dbFileName)) {
-		QFile::remove(dbFileName);
-	}
+	removeFiles(dbFileName);
 }
 
 enum SongFields {
@@ -545,9 +559,15 @@ enum SongFields {
 	SF_year,
 	SF_origYear,
 	SF_type,
-	SF_lastModified
+	SF_lastModified,
+	// Not a column of songs - only present when selected via constSongColumnsWithRowId
+	SF_rowid
 };
 
+// Columns of songs, in SongFields order, followed by the rowid
+static const QLatin1String constSongColumnsWithRowId("file, artist, artistId, albumArtist, artistSort, composer, album, albumId, albumSort, title, "
+                                                     "genre1, genre2, genre3, genre4, track, disc, time, year, origYear, type, lastModified, rowid");
+
 bool LibraryDb::init(const QString& dbFile)
 {
 	if (dbFile != dbFileName) {
@@ -573,6 +593,9 @@ bool LibraryDb::init(const QString& dbFile)
 		DBUG << "Failed to open";
 		return false;
 	}
+	// Use write-ahead logging, so that readers are not blocked by (and do not see) an update until it is committed.
+	QSqlQuery(*db).exec("pragma journal_mode=wal");
+	QSqlQuery(*db).exec("pragma busy_timeout=5000");
 
 	if (!createTable("versions(collection integer, schema integer)")) {
 		DBUG << "Failed to create versions table";
@@ -632,6 +655,28 @@ bool LibraryDb::init(const QString& dbFile)
 		DBUG << "Failed to create songs table";
 		return false;
 	}
+	// Per album, and per artist, totals - so that the top levels of the library can be listed without scanning every song.
+	if (!createTable("albums ("
+	                 "artistId text, "
+	                 "albumId text, "
+	                 "album text, "
+	                 "albumSort text, "
+	                 "artistSort text, "
+	                 "year integer, "
+	                 "origYear integer, "
+	                 "trackCount integer, "
+	                 "duration integer, "
+	                 "lastModified integer, "
+	                 "primary key (artistId, albumId))")
+	    || !createTable("artists ("
+	                    "artistId text, "
+	                    "artistSort text, "
+	                    "albumCount integer, "
+	                    "primary key (artistId))")) {
+		DBUG << "Failed to create albums/artists tables";
+		return false;
+	}
+	createIndexes();
 	emit libraryUpdated();
 	DBUG << "Created";
 	return true;
@@ -642,6 +687,17 @@ void LibraryDb::insertSong(const Song& s)
 	if (!db) {
 		return;
 	}
+	if (isIncrementalUpdate) {
+		QHash<QString, uint>::Iterator it = staleFiles.find(s.file);
+		if (it != staleFiles.end()) {
+			bool unchanged = 0 != s.lastModified && s.lastModified == it.value();
+			staleFiles.erase(it);
+			if (unchanged) {
+				return;
+			}
+			removeSong(s.file);
+		}
+	}
 	if (!insertSongQuery) {
 		insertSongQuery = new QSqlQuery(*db);
 		insertSongQuery->prepare("insert into songs(file, artist, artistId, albumArtist, artistSort, composer, album, albumId, albumSort, title, genre1, genre2, genre3, genre4, track, disc, time, year, origYear, type, lastModified) "
@@ -671,6 +727,9 @@ void LibraryDb::insertSong(const Song& s)
 	if (!insertSongQuery->exec()) {
 		qWarning() << "insert failed" << insertSongQuery->lastError().text() << newVersion << s.file;
 	}
+	else if (isIncrementalUpdate) {
+		dirtyAlbums.insert(qMakePair(s.albumArtistOrComposer(), albumId));
+	}
 }
 
 QList<LibraryDb::Genre> LibraryDb::getGenres()
@@ -721,7 +780,14 @@ QList<LibraryDb::Artist> LibraryDb::getArtists(const QString& genre)
 	}
 	QMap<QString, QString> sortMap;
 	QMap<QString, int> albumMap;
-	if (0 != currentVersion && db) {
+	if (0 != currentVersion && db && genre.isEmpty() && !isFiltered()) {
+		QSqlQuery query("select artistId, artistSort, albumCount from artists", *db);
+		while (query.next()) {
+			artists.append(Artist(query.value(0).toString(), query.value(1).toString(), query.value(2).toInt()));
+		}
+		DBUG << "from totals" << artists.count();
+	}
+	else if (0 != currentVersion && db) {
 		SqlQuery query("distinct artistId, albumId, artistSort", *db);
 		query.setFilter(filter, yearFilter);
 		if (!genre.isEmpty()) {
@@ -749,6 +815,31 @@ QList<LibraryDb::Artist> LibraryDb::getArtists(const QString& genre)
 	return artists;
 }
 
+static void addAlbum(QMap<QString, LibraryDb::Album>& entries, QMap<QString, QSet<QString>>& albumIdArtists, const QString& key, const LibraryDb::Album& album)
+{
+	QMap<QString, LibraryDb::Album>::iterator it = entries.find(key);
+
+	if (it == entries.end()) {
+		entries.insert(key, album);
+	}
+	else {
+		LibraryDb::Album& al = it.value();
+		al.lastModified = qMax(al.lastModified, album.lastModified);
+		al.year = qMax(al.year, album.year);
+		al.duration += album.duration;
+		al.trackCount += album.trackCount;
+	}
+	if (album.identifyById) {
+		QMap<QString, QSet<QString>>::iterator aIt = albumIdArtists.find(key);
+		if (aIt == albumIdArtists.end()) {
+			albumIdArtists.insert(key, QSet<QString>() << album.artist);
+		}
+		else {
+			aIt.value().insert(album.artist);
+		}
+	}
+}
+
 QList<LibraryDb::Album> LibraryDb::getAlbums(const QString& artistId, const QString& genre, AlbumSort sort)
 {
 	timer.start();
@@ -760,90 +851,94 @@ QList<LibraryDb::Album> LibraryDb::getAlbums(const QString& artistId, const QStr
 	if (0 != currentVersion && db) {
 		bool wantModified = AS_Modified == sort;
 		bool wantArtist = artistId.isEmpty();
-		QString queryString = "album, albumId, albumSort, artist, albumArtist, composer";
-		for (int i = 0; i < Song::constNumGenres; ++i) {
-			queryString += ", genre" + QString::number(i + 1);
-		}
-		queryString += ", type, year, origYear, time";
-		if (wantModified) {
-			queryString += ", lastModified";
-		}
-		if (wantArtist) {
-			queryString += ", artistId, artistSort";
-		}
-		SqlQuery query(queryString, *db);
-		query.setFilter(filter, yearFilter);
-		if (!artistId.isEmpty()) {
-			query.addWhere("artistId", artistId);
-		}
-		if (!genre.isEmpty()) {
-			query.addWhere("genre", genre);
-		}
-		else if (!genreFilter.isEmpty()) {
-			query.addWhere("genre", genreFilter);
-		}
-		query.exec();
 		int count = 0;
 		QMap<QString, Album> entries;
 		QMap<QString, QSet<QString>> albumIdArtists;// Map of albumId -> albumartists/composers
-		while (query.next()) {
-			count++;
-			int col = 0;
-			QString album = query.value(col++).toString();
-			QString albumId = query.value(col++).toString();
-			QString albumSort = query.value(col++).toString();
-
-			Song s;
-			s.artist = query.value(col++).toString();
-			s.albumartist = query.value(col++).toString();
-			s.setComposer(query.value(col++).toString());
-			s.album = album.isEmpty() ? albumId : album;
+
+		if (genre.isEmpty() && !isFiltered()) {
+			QSqlQuery query(*db);
+			query.prepare(QLatin1String("select artistId, albumId, album, albumSort, artistSort, year, origYear, trackCount, duration, lastModified from albums")
+			              + (wantArtist ? QString() : QLatin1String(" where artistId=:artistId")));
+			if (!wantArtist) {
+				query.bindValue(":artistId", artistId);
+			}
+			query.exec();
+			bool useOrigYear = Song::useOriginalYear();
+			while (query.next()) {
+				count++;
+				QString artist = query.value(0).toString();
+				QString albumId = query.value(1).toString();
+				QString album = query.value(2).toString();
+				bool haveUniqueId = wantArtist && !albumId.isEmpty() && !album.isEmpty() && albumId != album;
+				QString key = haveUniqueId ? albumId : ('{' + albumId + "}{" + artist + '}');
+				addAlbum(entries, albumIdArtists, key,
+				         Album(album, albumId, query.value(3).toString(), wantArtist ? artist : QString(), wantArtist ? query.value(4).toString() : QString(),
+				               query.value(useOrigYear ? 6 : 5).toInt(), query.value(7).toInt(), query.value(8).toInt(),
+				               wantModified ? query.value(9).toInt() : 0, haveUniqueId));
+			}
+		}
+		else {
+			QString queryString = "album, albumId, albumSort, artist, albumArtist, composer";
 			for (int i = 0; i < Song::constNumGenres; ++i) {
-				QString genre = query.value(col++).toString();
-				if (genre != constNullGenre) {
-					s.addGenre(genre);
-				}
+				queryString += ", genre" + QString::number(i + 1);
 			}
-			s.type = (Song::Type)query.value(col++).toInt();
-			s.year = query.value(col++).toInt();
-			s.origYear = query.value(col++).toInt();
-			if (Song::SingleTracks == s.type) {
-				s.album = Song::singleTracks();
-				s.albumartist = Song::variousArtists();
-				s.year = s.origYear = 0;
+			queryString += ", type, year, origYear, time";
+			if (wantModified) {
+				queryString += ", lastModified";
 			}
-			album = s.albumName();
-			int time = query.value(col++).toInt();
-			int lastModified = wantModified ? query.value(col++).toInt() : 0;
-			QString artist = wantArtist ? query.value(col++).toString() : QString();
-			QString artistSort = wantArtist ? query.value(col++).toString() : QString();
-			// If listing albums not filtered on artist, then if we have a unqique id for the album use that.
-			// This will allow us to grouup albums with different composers when the composer tweak is set
-			// Issue #1025
-			bool haveUniqueId = wantArtist && !albumId.isEmpty() && !album.isEmpty() && albumId != album;
-			QString key = haveUniqueId ? albumId : ('{' + albumId + "}{" + (wantArtist ? artist : artistId) + '}');
-			QMap<QString, Album>::iterator it = entries.find(key);
-
-			if (it == entries.end()) {
-				entries.insert(key, Album(album.isEmpty() ? albumId : album, albumId, albumSort, artist, artistSort, s.displayYear(), 1, time, lastModified, haveUniqueId));
+			if (wantArtist) {
+				queryString += ", artistId, artistSort";
 			}
-			else {
-				Album& al = it.value();
-				if (wantModified) {
-					al.lastModified = qMax(al.lastModified, lastModified);
-				}
-				al.year = qMax(al.year, (int)s.displayYear());
-				al.duration += time;
-				al.trackCount++;
+			SqlQuery query(queryString, *db);
+			query.setFilter(filter, yearFilter);
+			if (!artistId.isEmpty()) {
+				query.addWhere("artistId", artistId);
+			}
+			if (!genre.isEmpty()) {
+				query.addWhere("genre", genre);
 			}
-			if (haveUniqueId) {
-				QMap<QString, QSet<QString>>::iterator aIt = albumIdArtists.find(key);
-				if (aIt == albumIdArtists.end()) {
-					albumIdArtists.insert(key, QSet<QString>() << artist);
+			else if (!genreFilter.isEmpty()) {
+				query.addWhere("genre", genreFilter);
+			}
+			query.exec();
+			while (query.next()) {
+				count++;
+				int col = 0;
+				QString album = query.value(col++).toString();
+				QString albumId = query.value(col++).toString();
+				QString albumSort = query.value(col++).toString();
+
+				Song s;
+				s.artist = query.value(col++).toString();
+				s.albumartist = query.value(col++).toString();
+				s.setComposer(query.value(col++).toString());
+				s.album = album.isEmpty() ? albumId : album;
+				for (int i = 0; i < Song::constNumGenres; ++i) {
+					QString genre = query.value(col++).toString();
+					if (genre != constNullGenre) {
+						s.addGenre(genre);
+					}
 				}
-				else {
-					aIt.value().insert(artist);
+				s.type = (Song::Type)query.value(col++).toInt();
+				s.year = query.value(col++).toInt();
+				s.origYear = query.value(col++).toInt();
+				if (Song::SingleTracks == s.type) {
+					s.album = Song::singleTracks();
+					s.albumartist = Song::variousArtists();
+					s.year = s.origYear = 0;
 				}
+				album = s.albumName();
+				int time = query.value(col++).toInt();
+				int lastModified = wantModified ? query.value(col++).toInt() : 0;
+				QString artist = wantArtist ? query.value(col++).toString() : QString();
+				QString artistSort = wantArtist ? query.value(col++).toString() : QString();
+				// If listing albums not filtered on artist, then if we have a unqique id for the album use that.
+				// This will allow us to grouup albums with different composers when the composer tweak is set
+				// Issue #1025
+				bool haveUniqueId = wantArtist && !albumId.isEmpty() && !album.isEmpty() && albumId != album;
+				QString key = haveUniqueId ? albumId : ('{' + albumId + "}{" + (wantArtist ? artist : artistId) + '}');
+				addAlbum(entries, albumIdArtists, key,
+				         Album(album.isEmpty() ? albumId : album, albumId, albumSort, artist, artistSort, s.displayYear(), 1, time, lastModified, haveUniqueId));
 			}
 		}
 
@@ -947,18 +1042,22 @@ QList<Song> LibraryDb::getTracks(const QString& artistId, const QString& albumId
 	return songs;
 }
 
-QList<Song> LibraryDb::getTracks(int rowFrom, int count)
+QList<Song> LibraryDb::getTracks(int afterRowId, int count, int& lastRowId)
 {
 	QList<Song> songList;
+	lastRowId = afterRowId;
 	if (db) {
-		SqlQuery query("*", *db);
-		query.addWhere("rowid", rowFrom, ">");
-		query.addWhere("rowid", rowFrom + count, "<=");
+		// rowids are not contiguous once songs have been removed, so page on the last one seen
+		SqlQuery query(constSongColumnsWithRowId, *db);
+		query.addWhere("rowid", afterRowId, ">");
 		query.addWhere("type", 0);
+		query.setOrder("rowid");
+		query.setLimit(count);
 		query.exec();
 		DBUG << query.executedQuery();
 		while (query.next()) {
 			songList.append(getSong(query.realQuery()));
+			lastRowId = query.value(SF_rowid).toInt();
 		}
 	}
 	return songList;
@@ -1240,8 +1339,27 @@ void LibraryDb::updateStarted(time_t ver)
 	newVersion = ver;
 	timer.start();
 	db->transaction();
+	staleFiles.clear();
+	isIncrementalUpdate = false;
 	if (currentVersion > 0) {
-		clearSongs(false);
+		if (incrementalUpdates) {
+			// Remember what we currently have, so that only new or modified songs are written. Anything
+			// left in staleFiles when the update finishes is no longer in the collection.
+			QSqlQuery query("select file, lastModified from songs", *db);
+			while (query.next()) {
+				staleFiles.insert(query.value(0).toString(), query.value(1).toUInt());
+			}
+			isIncrementalUpdate = true;
+			detailsCache.clear();
+			DBUG << "incremental, existing songs:" << staleFiles.count() << timer.elapsed();
+		}
+		else {
+			clearSongs(false);
+		}
+	}
+	if (!isIncrementalUpdate) {
+		// Quicker to re-create the indexes once all songs have been inserted
+		dropIndexes();
 	}
 }
 
@@ -1264,9 +1382,30 @@ void LibraryDb::updateFinished()
 		return;
 	}
 	DBUG << timer.elapsed();
-	DBUG << "update fts" << timer.elapsed();
-	QSqlQuery(*db).exec("insert into songs_fts(fts_artist, fts_artistId, fts_album, fts_albumId, fts_title) "
-	                    "select artist, artistId, album, albumId, title from songs");
+	if (isIncrementalUpdate) {
+		DBUG << "remove stale songs" << staleFiles.count();
+		for (QHash<QString, uint>::ConstIterator it = staleFiles.constBegin(), end = staleFiles.constEnd(); it != end; ++it) {
+			removeSong(it.key());
+		}
+		staleFiles.clear();
+		DBUG << "update totals" << dirtyAlbums.count() << timer.elapsed();
+		updateTotals();
+		isIncrementalUpdate = false;
+		// FTS entries of removed, or modified, songs have already been deleted - so only need to add entries
+		// for songs that do not yet have one.
+		DBUG << "update fts" << timer.elapsed();
+		QSqlQuery(*db).exec("insert into songs_fts(docid, fts_artist, fts_artistId, fts_album, fts_albumId, fts_title) "
+		                    "select rowid, artist, artistId, album, albumId, title from songs where rowid not in (select docid from songs_fts)");
+	}
+	else {
+		DBUG << "create indexes" << timer.elapsed();
+		createIndexes();
+		DBUG << "update totals" << timer.elapsed();
+		updateTotals();
+		DBUG << "update fts" << timer.elapsed();
+		QSqlQuery(*db).exec("insert into songs_fts(docid, fts_artist, fts_artistId, fts_album, fts_albumId, fts_title) "
+		                    "select rowid, artist, artistId, album, albumId, title from songs");
+	}
 	QSqlQuery(*db).exec("update versions set collection =" + QString::number(newVersion));
 	DBUG << "commit" << timer.elapsed();
 	db->commit();
@@ -1277,6 +1416,9 @@ void LibraryDb::updateFinished()
 
 void LibraryDb::abortUpdate()
 {
+	staleFiles.clear();
+	dirtyAlbums.clear();
+	isIncrementalUpdate = false;
 	if (db) {
 		db->rollback();
 	}
@@ -1295,6 +1437,169 @@ bool LibraryDb::createTable(const QString& q)
 	return true;
 }
 
+static const char* constIndexes[] = {
+	"songs_artistId_idx on songs(artistId, albumId)",
+	"songs_albumId_idx on songs(albumId)",
+	"songs_genre1_idx on songs(genre1)",
+	"songs_genre2_idx on songs(genre2)",
+	"songs_genre3_idx on songs(genre3)",
+	"songs_genre4_idx on songs(genre4)",
+	"songs_year_idx on songs(year)",
+	nullptr
+};
+
+void LibraryDb::createIndexes()
+{
+	for (int i = 0; constIndexes[i]; ++i) {
+		QSqlQuery query(*db);
+		if (!query.exec(QLatin1String("create index if not exists ") + QLatin1String(constIndexes[i]))) {
+			qWarning() << "Failed to create index" << query.lastError().text();
+		}
+	}
+}
+
+void LibraryDb::dropIndexes()
+{
+	for (int i = 0; constIndexes[i]; ++i) {
+		QString name = QLatin1String(constIndexes[i]);
+		QSqlQuery(*db).exec("drop index if exists " + name.left(name.indexOf(' ')));
+	}
+}
+
+struct AlbumTotals {
+	QString name;
+	QString sort;
+	QString artistSort;
+	int year = 0;
+	int origYear = 0;
+	int trackCount = 0;
+	int duration = 0;
+	int lastModified = 0;
+};
+
+// Calculate album totals from the songs table, using the same rules as getAlbums() uses for filtered listings
+static void calcAlbumTotals(QSqlQuery& query, QMap<QPair<QString, QString>, AlbumTotals>& totals)
+{
+	while (query.next()) {
+		int col = 0;
+		QString artistId = query.value(col++).toString();
+		QString albumId = query.value(col++).toString();
+		QString album = query.value(col++).toString();
+		QString albumSort = query.value(col++).toString();
+		QString artistSort = query.value(col++).toString();
+
+		Song s;
+		s.artist = query.value(col++).toString();
+		s.albumartist = query.value(col++).toString();
+		s.setComposer(query.value(col++).toString());
+		s.album = album.isEmpty() ? albumId : album;
+		for (int i = 0; i < Song::constNumGenres; ++i) {
+			QString genre = query.value(col++).toString();
+			if (genre != LibraryDb::constNullGenre) {
+				s.addGenre(genre);
+			}
+		}
+		s.type = (Song::Type)query.value(col++).toInt();
+		s.year = query.value(col++).toInt();
+		s.origYear = query.value(col++).toInt();
+		if (Song::SingleTracks == s.type) {
+			s.album = Song::singleTracks();
+			s.albumartist = Song::variousArtists();
+			s.year = s.origYear = 0;
+		}
+		int time = query.value(col++).toInt();
+		int lastModified = query.value(col++).toInt();
+
+		AlbumTotals& t = totals[qMakePair(artistId, albumId)];
+		if (0 == t.trackCount) {
+			album = s.albumName();
+			t.name = album.isEmpty() ? albumId : album;
+			t.sort = albumSort;
+			t.artistSort = artistSort;
+		}
+		t.year = qMax(t.year, (int)s.year);
+		t.origYear = qMax(t.origYear, (int)(s.origYear > 0 ? s.origYear : s.year));
+		t.trackCount++;
+		t.duration += time;
+		t.lastModified = qMax(t.lastModified, lastModified);
+	}
+}
+
+void LibraryDb::updateTotals()
+{
+	QString columns = "artistId, albumId, album, albumSort, artistSort, artist, albumArtist, composer";
+	for (int i = 0; i < Song::constNumGenres; ++i) {
+		columns += ", genre" + QString::number(i + 1);
+	}
+	columns += ", type, year, origYear, time, lastModified";
+
+	QMap<QPair<QString, QString>, AlbumTotals> totals;
+	QSet<QString> dirtyArtists;
+	if (isIncrementalUpdate) {
+		if (dirtyAlbums.isEmpty()) {
+			return;
+		}
+		QSqlQuery removeAlbum(*db);
+		removeAlbum.prepare("delete from albums where artistId=:artistId and albumId=:albumId");
+		QSqlQuery albumSongs(*db);
+		albumSongs.prepare("select " + columns + " from songs where artistId=:artistId and albumId=:albumId");
+		for (const QPair<QString, QString>& album : dirtyAlbums) {
+			removeAlbum.bindValue(":artistId", album.first);
+			removeAlbum.bindValue(":albumId", album.second);
+			removeAlbum.exec();
+			albumSongs.bindValue(":artistId", album.first);
+			albumSongs.bindValue(":albumId", album.second);
+			albumSongs.exec();
+			calcAlbumTotals(albumSongs, totals);
+			dirtyArtists.insert(album.first);
+		}
+		dirtyAlbums.clear();
+	}
+	else {
+		QSqlQuery(*db).exec("delete from albums");
+		QSqlQuery(*db).exec("delete from artists");
+		QSqlQuery allSongs(*db);
+		allSongs.setForwardOnly(true);
+		allSongs.exec("select " + columns + " from songs");
+		calcAlbumTotals(allSongs, totals);
+	}
+
+	QSqlQuery insertAlbum(*db);
+	insertAlbum.prepare("insert into albums(artistId, albumId, album, albumSort, artistSort, year, origYear, trackCount, duration, lastModified) "
+	                    "values(:artistId, :albumId, :album, :albumSort, :artistSort, :year, :origYear, :trackCount, :duration, :lastModified)");
+	for (QMap<QPair<QString, QString>, AlbumTotals>::ConstIterator it = totals.constBegin(), end = totals.constEnd(); it != end; ++it) {
+		insertAlbum.bindValue(":artistId", it.key().first);
+		insertAlbum.bindValue(":albumId", it.key().second);
+		insertAlbum.bindValue(":album", it.value().name);
+		insertAlbum.bindValue(":albumSort", it.value().sort);
+		insertAlbum.bindValue(":artistSort", it.value().artistSort);
+		insertAlbum.bindValue(":year", it.value().year);
+		insertAlbum.bindValue(":origYear", it.value().origYear);
+		insertAlbum.bindValue(":trackCount", it.value().trackCount);
+		insertAlbum.bindValue(":duration", it.value().duration);
+		insertAlbum.bindValue(":lastModified", it.value().lastModified);
+		if (!insertAlbum.exec()) {
+			qWarning() << "album insert failed" << insertAlbum.lastError().text() << it.key().first << it.key().second;
+		}
+	}
+
+	if (dirtyArtists.isEmpty()) {
+		QSqlQuery(*db).exec("insert into artists(artistId, artistSort, albumCount) select artistId, max(artistSort), count() from albums group by artistId");
+	}
+	else {
+		QSqlQuery removeArtist(*db);
+		removeArtist.prepare("delete from artists where artistId=:artistId");
+		QSqlQuery insertArtist(*db);
+		insertArtist.prepare("insert into artists(artistId, artistSort, albumCount) select artistId, max(artistSort), count() from albums where artistId=:artistId group by artistId");
+		for (const QString& artist : dirtyArtists) {
+			removeArtist.bindValue(":artistId", artist);
+			removeArtist.exec();
+			insertArtist.bindValue(":artistId", artist);
+			insertArtist.exec();
+		}
+	}
+}
+
 Song LibraryDb::getSong(const QSqlQuery& query)
 {
 	Song s;
@@ -1333,7 +1638,7 @@ Song LibraryDb::getSong(const QSqlQuery& query)
 		s.setAlbumSort(val);
 	}
 	s.lastModified = query.value(SF_lastModified).toUInt();
-
+	s.intern();
 	return s;
 }
 
@@ -1341,12 +1646,21 @@ void LibraryDb::reset()
 {
 	bool removeDb = nullptr != db;
 	delete insertSongQuery;
+	delete removeSongQuery;
+	delete removeFtsQuery;
+	delete songAlbumQuery;
 	if (db) {
 		db->close();
 	}
 	delete db;
 
 	insertSongQuery = nullptr;
+	removeSongQuery = nullptr;
+	removeFtsQuery = nullptr;
+	songAlbumQuery = nullptr;
+	staleFiles.clear();
+	dirtyAlbums.clear();
+	isIncrementalUpdate = false;
 	db = nullptr;
 	if (removeDb) {
 		QSqlDatabase::removeDatabase(dbName);
@@ -1363,10 +1677,42 @@ void LibraryDb::clearSongs(bool startTransaction)
 	}
 	QSqlQuery(*db).exec("delete from songs");
 	QSqlQuery(*db).exec("delete from songs_fts");
+	QSqlQuery(*db).exec("delete from albums");
+	QSqlQuery(*db).exec("delete from artists");
 	detailsCache.clear();
 	if (startTransaction) {
 		db->commit();
 	}
 }
 
+void LibraryDb::removeSong(const QString& file)
+{
+	if (!db) {
+		return;
+	}
+	if (!removeSongQuery) {
+		removeFtsQuery = new QSqlQuery(*db);
+		removeFtsQuery->prepare("delete from songs_fts where docid in (select rowid from songs where file=:file)");
+		removeSongQuery = new QSqlQuery(*db);
+		removeSongQuery->prepare("delete from songs where file=:file");
+		songAlbumQuery = new QSqlQuery(*db);
+		songAlbumQuery->prepare("select artistId, albumId from songs where file=:file");
+	}
+	if (isIncrementalUpdate) {
+		songAlbumQuery->bindValue(":file", file);
+		if (songAlbumQuery->exec() && songAlbumQuery->next()) {
+			dirtyAlbums.insert(qMakePair(songAlbumQuery->value(0).toString(), songAlbumQuery->value(1).toString()));
+		}
+		songAlbumQuery->finish();
+	}
+	removeFtsQuery->bindValue(":file", file);
+	if (!removeFtsQuery->exec()) {
+		qWarning() << "fts delete failed" << removeFtsQuery->lastError().text() << file;
+	}
+	removeSongQuery->bindValue(":file", file);
+	if (!removeSongQuery->exec()) {
+		qWarning() << "delete failed" << removeSongQuery->lastError().text() << file;
+	}
+}
+
 #include "moc_librarydb.cpp"
@@ -27,9 +27,12 @@
 #include "mpd-interface/song.h"
 #include "support/utils.h"
 #include <QElapsedTimer>
+#include <QHash>
 #include <QList>
 #include <QMap>
 #include <QObject>
+#include <QPair>
+#include <QSet>
 #include <time.h>
 
 class QSqlDatabase;
@@ -41,6 +44,7 @@ class LibraryDb : public QObject {
 public:
 	static void enableDebug() { dbgEnabled = true; }
 	static bool debugEnabled() { return dbgEnabled; }
+	static void removeFiles(const QString& dbFile);
 
 	static const QLatin1String constFileExt;
 	static const QLatin1String constNullGenre;
@@ -111,7 +115,7 @@ public:
 	LibraryDb(QObject* p, const QString& name);
 	~LibraryDb() override;
 
-	void clear();
+	virtual void clear();
 	void erase();
 	virtual bool init(const QString& dbFile);
 	void insertSong(const Song& s);
@@ -119,7 +123,8 @@ public:
 	QList<Artist> getArtists(const QString& genre = QString());
 	QList<Album> getAlbums(const QString& artistId = QString(), const QString& genre = QString(), AlbumSort sort = AS_YrAlAr);
 	QList<Song> getTracks(const QString& artistId, const QString& albumId, const QString& genre = QString(), AlbumSort sort = AS_YrAlAr, bool useFilter = true, int maxTracks = -1);
-	QList<Song> getTracks(int rowFrom, int count);
+	// Up to count tracks, in rowid order, after afterRowId. lastRowId is set to the rowid of the last track returned.
+	QList<Song> getTracks(int afterRowId, int count, int& lastRowId);
 	int trackCount();
 	QList<Song> songs(const QStringList& files, bool allowPlaylists = false) const;
 	QList<Album> getAlbumsWithArtistOrComposer(const QString& artist);
@@ -130,6 +135,7 @@ public:
 	bool songExists(const Song& song);
 	bool setFilter(const QString& f, const QString& genre = QString());
 	const QString& getFilter() const { return filter; }
+	bool isFiltered() const { return !filter.isEmpty() || !yearFilter.isEmpty() || !genreFilter.isEmpty(); }
 	int getCurrentVersion() const { return currentVersion; }
 
 Q_SIGNALS:
@@ -144,11 +150,15 @@ public Q_SLOTS:
 
 protected:
 	bool createTable(const QString& q);
+	void createIndexes();
+	void dropIndexes();
+	void updateTotals();
 	static Song getSong(const QSqlQuery& query);
 
 protected:
 	virtual void reset();
 	void clearSongs(bool startTransaction = true);
+	void removeSong(const QString& file);
 
 protected:
 	static bool dbgEnabled;
@@ -159,6 +169,14 @@ protected:
 	time_t newVersion;
 	QSqlDatabase* db;
 	QSqlQuery* insertSongQuery;
+	QSqlQuery* removeSongQuery;
+	QSqlQuery* removeFtsQuery;
+	QSqlQuery* songAlbumQuery;
+	// If set, updates only touch rows whose lastModified has changed - rather than re-creating the whole table.
+	bool incrementalUpdates;
+	bool isIncrementalUpdate;
+	QHash<QString, uint> staleFiles;// Files in db, and not yet seen during an incremental update
+	QSet<QPair<QString, QString>> dirtyAlbums;// artistId/albumId of songs changed during an incremental update
 	QElapsedTimer timer;
 	QString filter;
 	QString genreFilter;
@@ -25,6 +25,7 @@
 #include "gui/settings.h"
 #include "mpd-interface/mpdconnection.h"
 #include "support/globalstatic.h"
+#include "support/thread.h"
 #include "support/utils.h"
 #include <QCoreApplication>
 #include <QDebug>
@@ -57,20 +58,99 @@ void MpdLibraryDb::removeUnusedDbs()
 		existing.insert(databaseName(conn).mid(dirPath.length()));
 	}
 
-	QFileInfoList files = QDir(dirPath).entryInfoList(QStringList() << "*" + LibraryDb::constFileExt, QDir::Files);
+	// Also match WAL sidecars, in case they were left behind when their database was removed
+	QFileInfoList files = QDir(dirPath).entryInfoList(QStringList() << "*" + LibraryDb::constFileExt << "*" + LibraryDb::constFileExt + "-wal"
+	                                                                << "*" + LibraryDb::constFileExt + "-shm",
+	                                                  QDir::Files);
 	for (const QFileInfo& file : files) {
-		if (!existing.contains(file.fileName())) {
-			QFile::remove(file.absoluteFilePath());
+		QString name = file.fileName();
+		name = name.left(name.lastIndexOf(LibraryDb::constFileExt) + LibraryDb::constFileExt.size());
+		if (!existing.contains(name)) {
+			LibraryDb::removeFiles(dirPath + name);
 		}
 	}
 }
 
+MpdLibraryDbWriter::MpdLibraryDbWriter()
+	: LibraryDb(nullptr, "MPD-Writer"), updating(false)
+{
+	// MPD supplies Last-Modified for each file, so only need to update rows that have changed.
+	incrementalUpdates = true;
+}
+
+MpdLibraryDbWriter::~MpdLibraryDbWriter()
+{
+}
+
+void MpdLibraryDbWriter::open(const QString& dbFile)
+{
+	// Always re-open, as this is called when the reader (re)initialises the database.
+	cancelUpdate();
+	reset();
+	init(dbFile);
+}
+
+void MpdLibraryDbWriter::recreate()
+{
+	// Called once the reader has closed its connection. Done here, rather than by the reader, so that the
+	// file is never removed part way through writing an update.
+	cancelUpdate();
+	clear();
+	emit recreated();
+}
+
+void MpdLibraryDbWriter::startUpdate(time_t ver)
+{
+	updating = true;
+	updateStarted(ver);
+}
+
+void MpdLibraryDbWriter::addSongs(QList<Song>* songs)
+{
+	if (updating) {
+		insertSongs(songs);
+	}
+	else {
+		delete songs;
+	}
+}
+
+void MpdLibraryDbWriter::finishUpdate()
+{
+	if (updating) {
+		updating = false;
+		updateFinished();
+	}
+}
+
+void MpdLibraryDbWriter::cancelUpdate()
+{
+	// The rest of an update that was in progress is for the previous database, so it is ignored.
+	if (updating) {
+		DBUG << "cancel update";
+		updating = false;
+		abortUpdate();
+	}
+}
+
 MpdLibraryDb::MpdLibraryDb(QObject* p)
 	: LibraryDb(p, "MPD"), loading(false), coverQuery(nullptr), albumIdOnlyCoverQuery(nullptr), artistImageQuery(nullptr)
 {
-	connect(MPDConnection::self(), SIGNAL(updatingLibrary(time_t)), this, SLOT(updateStarted(time_t)));
-	connect(MPDConnection::self(), SIGNAL(librarySongs(QList<Song>*)), this, SLOT(insertSongs(QList<Song>*)));
-	connect(MPDConnection::self(), SIGNAL(updatedLibrary()), this, SLOT(updateFinished()));
+	// Updates are written by writer, in its own thread, so that the GUI is not blocked whilst a large library
+	// is stored. As the database uses WAL mode, this connection continues to read the previous version until
+	// the update is committed.
+	writerThread = new Thread(metaObject()->className() + QLatin1String("::Writer"));
+	writer = new MpdLibraryDbWriter();
+	writer->moveToThread(writerThread);
+	writerThread->start();
+	connect(this, SIGNAL(openWriter(QString)), writer, SLOT(open(QString)));
+	connect(this, SIGNAL(recreateWriter()), writer, SLOT(recreate()));
+	connect(writer, SIGNAL(libraryUpdated()), this, SLOT(writerUpdated()));
+	connect(writer, SIGNAL(recreated()), this, SLOT(writerRecreated()));
+	connect(writer, SIGNAL(error(QString)), this, SIGNAL(error(QString)));
+	connect(MPDConnection::self(), SIGNAL(updatingLibrary(time_t)), writer, SLOT(startUpdate(time_t)));
+	connect(MPDConnection::self(), SIGNAL(librarySongs(QList<Song>*)), writer, SLOT(addSongs(QList<Song>*)));
+	connect(MPDConnection::self(), SIGNAL(updatedLibrary()), writer, SLOT(finishUpdate()));
 	connect(MPDConnection::self(), SIGNAL(statsUpdated(MPDStatsValues)), this, SLOT(statsUpdated(MPDStatsValues)));
 	connect(this, SIGNAL(loadLibrary()), MPDConnection::self(), SLOT(loadLibrary()));
 	connect(MPDConnection::self(), SIGNAL(connectionChanged(MPDConnectionDetails)), this, SLOT(connectionChanged(MPDConnectionDetails)));
@@ -79,6 +159,33 @@ MpdLibraryDb::MpdLibraryDb(QObject* p)
 
 MpdLibraryDb::~MpdLibraryDb()
 {
+	// Writer is deleted, and so closes its connection, in its own thread once that has finished.
+	writer->deleteLater();
+	writerThread->stop();
+}
+
+void MpdLibraryDb::clear()
+{
+	if (db) {
+		DBUG;
+		// Close this connection, and have the writer remove and re-create the file. This connection is
+		// re-opened once it has done so.
+		reset();
+		currentVersion = 0;
+		// Any update in progress is cancelled, so allow the next stats update to start another
+		loading = false;
+		detailsCache.clear();
+		emit recreateWriter();
+	}
+}
+
+bool MpdLibraryDb::init(const QString& dbFile)
+{
+	bool rv = LibraryDb::init(dbFile);
+	// Writer drops any update in progress when it is re-opened
+	loading = false;
+	emit openWriter(dbFile);
+	return rv;
 }
 
 Song MpdLibraryDb::getCoverSong(const QString& artistId, const QString& albumId)
@@ -143,10 +250,29 @@ void MpdLibraryDb::reset()
 	LibraryDb::reset();
 }
 
-void MpdLibraryDb::updateFinished()
+void MpdLibraryDb::writerUpdated()
 {
+	if (!db) {
+		return;
+	}
+	QSqlQuery query("select collection from versions", *db);
+	time_t version = query.next() ? query.value(0).toUInt() : 0;
+	DBUG << currentVersion << version << loading;
+	if (version == currentVersion && !loading) {
+		// Writer has just (re)opened the database, nothing has changed
+		return;
+	}
 	loading = false;
-	LibraryDb::updateFinished();
+	currentVersion = version;
+	detailsCache.clear();
+	emit libraryUpdated();
+}
+
+void MpdLibraryDb::writerRecreated()
+{
+	if (!db && !dbFileName.isEmpty()) {
+		LibraryDb::init(dbFileName);
+	}
 }
 
 void MpdLibraryDb::statsUpdated(const MPDStatsValues& stats)
@@ -37,6 +37,32 @@ struct MPDConnectionDetails;
 class QSqlDatabase;
 class QSqlQuery;
 class QSettings;
+class Thread;
+
+// Writes library updates from MPD to the database, using its own connection in its own thread.
+class MpdLibraryDbWriter : public LibraryDb {
+	Q_OBJECT
+
+public:
+	MpdLibraryDbWriter();
+	~MpdLibraryDbWriter() override;
+
+Q_SIGNALS:
+	void recreated();
+
+public Q_SLOTS:
+	void open(const QString& dbFile);
+	void recreate();
+	void startUpdate(time_t ver);
+	void addSongs(QList<Song>* songs);
+	void finishUpdate();
+
+private:
+	void cancelUpdate();
+
+private:
+	bool updating;
+};
 
 class MpdLibraryDb : public LibraryDb {
 	Q_OBJECT
@@ -47,21 +73,30 @@ public:
 	MpdLibraryDb(QObject* p = nullptr);
 	~MpdLibraryDb() override;
 
+	void clear() override;
+	bool init(const QString& dbFile) override;
 	Song getCoverSong(const QString& artistId, const QString& albumId = QString());
 
 Q_SIGNALS:
 	void loadLibrary();
+	void openWriter(const QString& dbFile);
+	void recreateWriter();
 
 public Q_SLOTS:
 	void connectionChanged(const MPDConnectionDetails& details);
 	void statsUpdated(const MPDStatsValues& stats);
 
+private Q_SLOTS:
+	void writerUpdated();
+	void writerRecreated();
+
 private:
 	void reset() override;
-	void updateFinished() override;
 
 private:
 	bool loading;
+	Thread* writerThread;
+	MpdLibraryDbWriter* writer;
 	QSqlQuery* coverQuery;
 	QSqlQuery* albumIdOnlyCoverQuery;
 	QSqlQuery* artistImageQuery;
@@ -393,6 +393,9 @@ void ActionDialog::init(const QString& srcUdi, const QString& dstUdi, const QLis
 	skippedSongs.clear();
 	currentPercent = 0;
 	currentDev = nullptr;
+	maxJobs = 1;
+	activeJobs.clear();
+	pendingStatus.clear();
 	count = 0;
 #ifdef ENABLE_REPLAYGAIN_SUPPORT
 	albumsWithoutRgTags.clear();
@@ -449,16 +452,22 @@ void ActionDialog::slotButtonClicked(int button)
 		case User1:
 			skippedSongs.append(currentSong);
 			incProgress();
-			doNext();
+			if (!handlePendingStatus()) {
+				doNext();
+			}
 			break;
 		case User2:
 			autoSkip = true;
 			incProgress();
-			doNext();
+			if (!handlePendingStatus()) {
+				doNext();
+			}
 			break;
 		case User3:
 			songsToAction.prepend(origCurrentSong);
-			doNext();
+			if (!handlePendingStatus()) {
+				doNext();
+			}
 			break;
 		default:
 			refreshLibrary();
@@ -498,6 +507,11 @@ void ActionDialog::slotButtonClicked(int button)
 			// Need to call this - if not, when dialog is closed by window X control, it is not deleted!!!!
 			Dialog::slotButtonClicked(button);
 		}
+		else if (maxJobs > 1 && PAGE_PROGRESS == stack->currentIndex()) {
+			// Completed jobs have already been counted
+			paused = false;
+			doNext();
+		}
 		else if (!performingAction && PAGE_PROGRESS == stack->currentIndex()) {
 			paused = false;
 			incProgress();
@@ -550,11 +564,16 @@ Device* ActionDialog::getDevice(const QString& udi, bool logErrors)
 void ActionDialog::doNext()
 {
 	currentPercent = 0;
+	// Wait for songs that are still being copied, before copying back to the library or finishing
+	if ((songsToAction.isEmpty() && !activeJobs.isEmpty()) || (maxJobs > 1 && activeJobs.count() >= maxJobs)) {
+		return;
+	}
 	if (songsToAction.isEmpty() && Sync == mode && !syncSongs.isEmpty()) {
 		songsToAction = syncSongs;
 		syncSongs.clear();
 		sourceUdi = destUdi;
 		destUdi = QString();
+		maxJobs = 1;
 		setCaption(tr("Copy Songs To Library"));
 	}
 
@@ -566,14 +585,18 @@ void ActionDialog::doNext()
 
 			if (dev) {
 				if (!currentDev) {
-					connect(dev, SIGNAL(actionStatus(int, bool)), this, SLOT(actionStatus(int, bool)));
-					connect(dev, SIGNAL(progress(int)), this, SLOT(jobPercent(int)));
+					connect(dev, SIGNAL(actionStatus(int, bool, QString)), this, SLOT(actionStatus(int, bool, QString)));
+					connect(dev, SIGNAL(progress(int, QString)), this, SLOT(jobPercent(int, QString)));
 					currentDev = dev;
 				}
 				performingAction = true;
 				if (copyToDev) {
 					destFile = dev->path() + dev->options().createFilename(currentSong);
 					currentSong.file = currentSong.filePath(MPDConnection::self()->getDetails().dir);
+					maxJobs = dev->maxAddSongJobs();
+					if (maxJobs > 1) {
+						activeJobs.insert(currentSong.file, ActiveJob(origCurrentSong, currentSong, destFile));
+					}
 					dev->addSong(currentSong, overwrite->isChecked(), !copiedCovers.contains(Utils::getDir(destFile)));
 				}
 				else {
@@ -606,6 +629,10 @@ void ActionDialog::doNext()
 			}
 		}
 		progressLabel->setText(formatSong(currentSong, false));
+		// Keep the device busy with as many songs as it can handle
+		if (!activeJobs.isEmpty() && activeJobs.count() < maxJobs && !songsToAction.isEmpty() && !paused && PAGE_PROGRESS == stack->currentIndex()) {
+			doNext();
+		}
 	}
 	else if (Remove == mode && dirsToClean.count()) {
 		Device* dev = sourceUdi.isEmpty() ? nullptr : DevicesModel::self()->device(sourceUdi);
@@ -649,8 +676,22 @@ void ActionDialog::doNext()
 	}
 }
 
-void ActionDialog::actionStatus(int status, bool copiedCover)
+void ActionDialog::actionStatus(int status, bool copiedCover, const QString& file)
 {
+	QHash<QString, ActiveJob>::Iterator job = file.isEmpty() ? activeJobs.end() : activeJobs.find(file);
+	bool wasJob = job != activeJobs.end();
+	if (wasJob) {
+		if (PAGE_PROGRESS != stack->currentIndex()) {
+			// Still waiting on the user to decide what to do about a previous song
+			pendingStatus.append(PendingStatus(status, copiedCover, file));
+			return;
+		}
+		currentSong = job.value().song;
+		origCurrentSong = job.value().orig;
+		destFile = job.value().destFile;
+		activeJobs.erase(job);
+	}
+
 	int origStatus = status;
 	bool wasSkip = false;
 	if (Device::Ok != status && Device::NotConnected != status && autoSkip) {
@@ -660,7 +701,7 @@ void ActionDialog::actionStatus(int status, bool copiedCover)
 	}
 	switch (status) {
 	case Device::Ok:
-		performingAction = false;
+		performingAction = !activeJobs.isEmpty();
 		if (Device::Ok == origStatus) {
 			if (!wasSkip) {
 				actionedSongs.append(currentSong);
@@ -674,7 +715,13 @@ void ActionDialog::actionStatus(int status, bool copiedCover)
 				copiedCovers.insert(Utils::getDir(destFile));
 			}
 		}
-		if (!paused) {
+		if (wasJob) {
+			incProgress();
+			if (!paused) {
+				doNext();
+			}
+		}
+		else if (!paused) {
 			incProgress();
 			doNext();
 		}
@@ -922,8 +969,18 @@ void ActionDialog::cleanDirsResult(int status)
 	actionStatus(status);
 }
 
-void ActionDialog::jobPercent(int percent)
+void ActionDialog::jobPercent(int percent, const QString& file)
 {
+	QHash<QString, ActiveJob>::Iterator job = file.isEmpty() ? activeJobs.end() : activeJobs.find(file);
+	if (job != activeJobs.end()) {
+		if (percent != job.value().percent) {
+			job.value().percent = percent;
+			progressBar->setValue((100 * count) + activePercent());
+			updateUnity(false);
+		}
+		return;
+	}
+
 	if (percent != currentPercent) {
 		progressBar->setValue((100 * count) + percent);
 		updateUnity(false);
@@ -937,10 +994,29 @@ void ActionDialog::jobPercent(int percent)
 void ActionDialog::incProgress()
 {
 	count++;
-	progressBar->setValue(100 * count);
+	progressBar->setValue((100 * count) + activePercent());
 	updateUnity(false);
 }
 
+int ActionDialog::activePercent() const
+{
+	int pc = 0;
+	for (const ActiveJob& job : activeJobs) {
+		pc += job.percent;
+	}
+	return pc;
+}
+
+// Handle results that arrived whilst an error was shown. Returns true if another error is now shown.
+bool ActionDialog::handlePendingStatus()
+{
+	while (!pendingStatus.isEmpty() && PAGE_PROGRESS == stack->currentIndex()) {
+		PendingStatus ps = pendingStatus.takeFirst();
+		actionStatus(ps.status, ps.copiedCover, ps.file);
+	}
+	return PAGE_PROGRESS != stack->currentIndex();
+}
+
 void ActionDialog::updateUnity(bool finished)
 {
 #ifdef QT_QTDBUS_FOUND
@@ -30,6 +30,7 @@
 #include "support/dialog.h"
 #include "ui_actiondialog.h"
 #include <QElapsedTimer>
+#include <QHash>
 #ifdef QT_QTDBUS_FOUND
 #include <QDBusMessage>
 #endif
@@ -59,6 +60,24 @@ class ActionDialog : public Dialog, Ui::ActionDialog {
 	typedef QPair<QString, QString> StringPair;
 	typedef QList<StringPair> StringPairList;
 
+	// A song being copied, when the device can copy more than one at once
+	struct ActiveJob {
+		ActiveJob(const Song& o = Song(), const Song& s = Song(), const QString& d = QString())
+			: orig(o), song(s), destFile(d), percent(0) {}
+		Song orig;
+		Song song;
+		QString destFile;
+		int percent;
+	};
+
+	struct PendingStatus {
+		PendingStatus(int s = 0, bool c = false, const QString& f = QString())
+			: status(s), copiedCover(c), file(f) {}
+		int status;
+		bool copiedCover;
+		QString file;
+	};
+
 public:
 	static int instanceCount();
 
@@ -81,11 +100,11 @@ private Q_SLOTS:
 	void configureDest();
 	void saveProperties(const QString& path, const DeviceOptions& opts);
 	void saveProperties();
-	void actionStatus(int status, bool copiedCover = false);
+	void actionStatus(int status, bool copiedCover = false, const QString& file = QString());
 	void doNext();
 	void removeSongResult(int status);
 	void cleanDirsResult(int status);
-	void jobPercent(int percent);
+	void jobPercent(int percent, const QString& file = QString());
 	void cacheSaved();
 	void controlInfoLabel();
 	void deviceRenamed();
@@ -103,6 +122,8 @@ private:
 	void removeSong(const Song& s);
 	void cleanDirs();
 	void incProgress();
+	int activePercent() const;
+	bool handlePendingStatus();
 	void updateUnity(bool finished);
 
 private:
@@ -120,6 +141,9 @@ private:
 	QSet<QString> copiedCovers;
 	unsigned long count;
 	int currentPercent;// Percentage of current song
+	int maxJobs;
+	QHash<QString, ActiveJob> activeJobs;// Key is source file
+	QList<PendingStatus> pendingStatus;  // Results that arrived whilst an error was being shown
 	Song origCurrentSong;
 	Song currentSong;
 	bool autoSkip;
@@ -374,9 +374,14 @@ void Device::updateStatus()
 	emit m_model->dataChanged(modelIndex, modelIndex);
 }
 
-void Device::songCount(int c)
+void Device::songCount(int c, int rate)
 {
-	setStatusMessage(tr("Updating (%1)...").arg(c));
+	if (rate > 0) {
+		setStatusMessage(tr("Updating (%1, %2 files/s)...").arg(c).arg(rate));
+	}
+	else {
+		setStatusMessage(tr("Updating (%1)...").arg(c));
+	}
 }
 
 void Device::updatePercentage(int pc)
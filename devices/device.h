@@ -146,6 +146,9 @@ public:
 	bool isConfigured() { return configured; }
 	virtual void abortJob() { jobAbortRequested = true; }
 	bool abortRequested() const { return jobAbortRequested; }
+	// Number of addSong() calls that may be in progress at once. If more than 1, then actionStatus()
+	// and progress() are emitted with the file of the song passed to addSong().
+	virtual int maxAddSongJobs() const { return 1; }
 	bool canPlaySongs() const override { return false; }
 	virtual bool supportsDisconnect() const { return false; }
 	virtual bool isStdFs() const { return false; }
@@ -155,7 +158,7 @@ public:
 
 public Q_SLOTS:
 	void setStatusMessage(const QString& message);
-	void songCount(int c);
+	void songCount(int c, int rate = 0);
 	void updatePercentage(int pc);
 #endif
 
@@ -163,8 +166,8 @@ Q_SIGNALS:
 	void connected(const QString& id);
 	void disconnected(const QString& id);
 	void updating(const QString& id, bool s);
-	void actionStatus(int status, bool copiedCover = false);
-	void progress(int pc);
+	void actionStatus(int status, bool copiedCover = false, const QString& file = QString());
+	void progress(int pc, const QString& file = QString());
 	void error(const QString&);
 	void cover(const Song& song, const QImage& img);
 	void cacheSaved();
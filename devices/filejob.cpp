@@ -25,19 +25,33 @@
 #include "context/songview.h"
 #include "device.h"
 #include "gui/covers.h"
+#include "gui/settings.h"
 #include "support/globalstatic.h"
 #include "support/thread.h"
 #include "support/utils.h"
 #include <QDebug>
 #include <QFile>
+#include <QMutex>
 #include <QTemporaryFile>
 #include <QTimer>
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+#endif
 
 GLOBAL_STATIC(FileThread, instance)
 
+static QMutex copyThreadsMutex;
+
 FileThread::FileThread()
-	: thread(nullptr)
+	: thread(nullptr), nextCopyThread(0)
 {
+	// Created by the first job's start(), so this is read on the GUI thread - addCopyJob() may
+	// be called from a transcode that is moving itself.
+	writeJobs = Settings::self()->deviceWriteJobs();
 }
 
 FileThread::~FileThread()
@@ -54,18 +68,39 @@ void FileThread::addJob(FileJob* job)
 	job->moveToThread(thread);
 }
 
+void FileThread::addCopyJob(FileJob* job)
+{
+	// May be called from the main thread, or from a job that is moving itself
+	QMutexLocker locker(&copyThreadsMutex);
+	if (copyThreads.isEmpty()) {
+		for (int i = 0; i < writeJobs; ++i) {
+			Thread* t = new Thread(QLatin1String(metaObject()->className()) + QLatin1String("::Copy"));
+			t->start();
+			copyThreads.append(t);
+		}
+	}
+	// Each thread runs its jobs one after another, so jobs are spread over the threads
+	job->moveToThread(copyThreads.at(nextCopyThread));
+	nextCopyThread = (nextCopyThread + 1) % copyThreads.count();
+}
+
 void FileThread::stop()
 {
 	if (thread) {
 		thread->stop();
 		thread = nullptr;
 	}
+	QMutexLocker locker(&copyThreadsMutex);
+	for (Thread* t : copyThreads) {
+		t->stop();
+	}
+	copyThreads.clear();
+	nextCopyThread = 0;
 }
 
 FileJob::FileJob()
 	: stopRequested(false), progressPercent(0)
 {
-	FileThread::self()->addJob(this);
 	// Cant call deleteLater here, as in the device's xxResult() slots "sender()" returns
 	// null. Therefore, xxResult() slots need to call finished()
 	//connect(this, SIGNAL(result(int)), SLOT(deleteLater()));
@@ -73,6 +108,7 @@ FileJob::FileJob()
 
 void FileJob::start()
 {
+	FileThread::self()->addJob(this);
 	QTimer::singleShot(0, this, SLOT(run()));
 }
 
@@ -92,7 +128,16 @@ CopyJob::~CopyJob()
 	}
 }
 
-static const int constChunkSize = 32 * 1024;
+void CopyJob::start()
+{
+	FileThread::self()->addCopyJob(this);
+	QTimer::singleShot(0, this, SLOT(run()));
+}
+
+static const int constChunkSize = 1024 * 1024;
+#ifdef Q_OS_LINUX
+static const qint64 constKernelChunkSize = 8 * 1024 * 1024;
+#endif
 
 QString CopyJob::updateTagsLocal()
 {
@@ -117,14 +162,14 @@ QString CopyJob::updateTagsLocal()
 	return srcFile;
 }
 
-void CopyJob::updateTagsDest()
+void CopyJob::updateTagsDest(const QString& file)
 {
 	if (!stopRequested && !(copyOpts & OptsFixLocal) && (copyOpts & OptsApplyVaFix || copyOpts & OptsUnApplyVaFix || Device::constEmbedCover == deviceOpts.coverName)) {
 		if (copyOpts & OptsApplyVaFix || copyOpts & OptsUnApplyVaFix) {
-			Device::fixVariousArtists(destFile, song, copyOpts & OptsApplyVaFix);
+			Device::fixVariousArtists(file, song, copyOpts & OptsApplyVaFix);
 		}
 		if (!stopRequested && Device::constEmbedCover == deviceOpts.coverName) {
-			Device::embedCover(destFile, song, deviceOpts.coverMaxSize);
+			Device::embedCover(file, song, deviceOpts.coverMaxSize);
 		}
 	}
 }
@@ -145,71 +190,154 @@ void CopyJob::run()
 		return;
 	}
 
-	if (stopRequested) {
-		emit result(Device::Cancelled);
+	int status = copyFile(srcFile);
+	if (Device::Ok != status) {
+		emit result(status);
 		return;
 	}
 
-	QFile src(srcFile);
+	updateTagsDest(destFile);
+	copyCover(origSrcFile);
+	setPercent(100);
+	emit result(Device::Ok);
+}
+
+int CopyJob::copyFile(const QString& from, int startPc)
+{
+	if (stopRequested) {
+		return Device::Cancelled;
+	}
+
+	QFile src(from);
 
 	if (!src.open(QIODevice::ReadOnly)) {
-		emit result(Device::ReadFailed);
-		return;
+		return Device::ReadFailed;
 	}
 
 	QFile dest(destFile);
 	if (!dest.open(QIODevice::WriteOnly)) {
-		emit result(Device::WriteFailed);
-		return;
+		return Device::WriteFailed;
 	}
 
-	char buffer[constChunkSize];
 	qint64 totalBytes = src.size();
+	qint64 adjustTotal = Device::constNoCover != deviceOpts.coverName ? 16384 : 0;
+#ifdef Q_OS_LINUX
+	int status = Device::Ok;
+	if (kernelCopy(src, dest, totalBytes + adjustTotal, startPc, status)) {
+		return status;
+	}
+#endif
+
+	QByteArray buffer(constChunkSize, Qt::Uninitialized);
 	qint64 readPos = 0;
 	qint64 bytesRead = 0;
-	qint64 adjustTotal = Device::constNoCover != deviceOpts.coverName ? 16384 : 0;
 	do {
 		if (stopRequested) {
-			emit result(Device::Cancelled);
-			return;
+			return Device::Cancelled;
 		}
-		bytesRead = src.read(buffer, constChunkSize);
-		readPos += bytesRead;
+		bytesRead = src.read(buffer.data(), constChunkSize);
 		if (bytesRead < 0) {
-			emit result(Device::ReadFailed);
-			return;
+			return Device::ReadFailed;
 		}
+		readPos += bytesRead;
 
 		if (stopRequested) {
-			emit result(Device::Cancelled);
-			return;
+			return Device::Cancelled;
 		}
 
 		qint64 writePos = 0;
 		do {
-			qint64 bytesWritten = dest.write(&buffer[writePos], bytesRead - writePos);
+			qint64 bytesWritten = dest.write(buffer.constData() + writePos, bytesRead - writePos);
 			if (stopRequested) {
-				emit result(Device::Cancelled);
-				return;
+				return Device::Cancelled;
 			}
 			if (-1 == bytesWritten) {
-				emit result(Device::WriteFailed);
-				return;
+				return Device::WriteFailed;
 			}
 			writePos += bytesWritten;
 		} while (writePos < bytesRead);
 
-		setPercent(((readPos + bytesRead) * 100.0) / (totalBytes + adjustTotal));
+		setPercent(startPc + ((readPos * (100.0 - startPc)) / (totalBytes + adjustTotal)));
 		if (src.atEnd()) {
 			break;
 		}
 	} while (readPos < totalBytes);
 
-	updateTagsDest();
-	copyCover(origSrcFile);
-	setPercent(100);
-	emit result(Device::Ok);
+	return Device::Ok;
+}
+
+#ifdef Q_OS_LINUX
+// Copy the file within the kernel - by cloning the data if the filesystem supports this, or with copy_file_range()
+// or sendfile(). Returns false, without having copied anything, if none of these can be used for these files.
+bool CopyJob::kernelCopy(QFile& src, QFile& dest, qint64 progressTotal, int startPc, int& status)
+{
+	int srcFd = src.handle();
+	int destFd = dest.handle();
+	if (srcFd < 0 || destFd < 0) {
+		return false;
+	}
+
+#ifdef FICLONE
+	if (0 == ioctl(destFd, FICLONE, srcFd)) {
+		setPercent(startPc + ((src.size() * (100.0 - startPc)) / progressTotal));
+		status = Device::Ok;
+		return true;
+	}
+#endif
+
+	bool useCopyRange = true;
+	qint64 copied = 0;
+	for (;;) {
+		if (stopRequested) {
+			status = Device::Cancelled;
+			return true;
+		}
+		ssize_t rv = useCopyRange
+		                     ? copy_file_range(srcFd, nullptr, destFd, nullptr, constKernelChunkSize, 0)
+		                     : sendfile(destFd, srcFd, nullptr, constKernelChunkSize);
+		if (rv < 0) {
+			if (EINTR == errno) {
+				continue;
+			}
+			if (0 == copied) {
+				// copy_file_range() is not supported between all filesystems, so try sendfile() before giving up
+				if (useCopyRange && (ENOSYS == errno || EXDEV == errno || EINVAL == errno || EOPNOTSUPP == errno)) {
+					useCopyRange = false;
+					continue;
+				}
+				if (ENOSYS == errno || EXDEV == errno || EINVAL == errno || EOPNOTSUPP == errno) {
+					return false;
+				}
+			}
+			status = ENOSPC == errno ? Device::NoSpace : Device::WriteFailed;
+			return true;
+		}
+		if (0 == rv) {
+			// Some filesystems (e.g. FUSE, procfs) report end-of-file straight away rather than failing, so
+			// treat this as not supported and try the next method.
+			if (0 == copied && src.size() > 0) {
+				if (useCopyRange) {
+					useCopyRange = false;
+					continue;
+				}
+				return false;
+			}
+			break;
+		}
+		copied += rv;
+		setPercent(startPc + ((copied * (100.0 - startPc)) / progressTotal));
+	}
+
+	if (copied != src.size()) {
+		dest.close();
+		QFile::remove(destFile);
+		status = Device::WriteFailed;
+		return true;
+	}
+	status = Device::Ok;
+	return true;
 }
+#endif
 
 void DeleteJob::run()
 {
@@ -26,9 +26,11 @@
 
 #include "deviceoptions.h"
 #include "mpd-interface/song.h"
+#include <QList>
 #include <QObject>
 #include <QSet>
 
+class QFile;
 class QTemporaryFile;
 class Thread;
 class FileJob;
@@ -41,10 +43,16 @@ public:
 	FileThread();
 	~FileThread() override;
 	void addJob(FileJob* job);
+	// Jobs that write whole files to a device are run on their own threads, so that they do not
+	// hold up (e.g.) transcodes. The number of these threads limits the concurrent writes.
+	void addCopyJob(FileJob* job);
 	void stop();
 
 private:
 	Thread* thread;
+	QList<Thread*> copyThreads;
+	int nextCopyThread;
+	int writeJobs;
 };
 
 class FileJob : public QObject {
@@ -88,7 +96,8 @@ public:
 		OptsNone = 0x00,
 		OptsApplyVaFix = 0x01,
 		OptsUnApplyVaFix = 0x02,
-		OptsFixLocal = 0x04// Apply any fixes to a local temp file before sending...
+		OptsFixLocal = 0x04,       // Apply any fixes to a local temp file before sending...
+		OptsTranscodeToTemp = 0x08// Transcode to a local temp file, and then copy this to the device
 	};
 
 	CopyJob(const QString& src, const QString& dest, const DeviceOptions& d, int co, const Song& s)
@@ -98,13 +107,19 @@ public:
 	~CopyJob() override;
 
 	bool coverCopied() const { return copiedCover; }
+	const QString& destination() const { return destFile; }
+	void start() override;
 
 protected:
 	QString updateTagsLocal();
-	void updateTagsDest();
+	void updateTagsDest(const QString& file);
 	void copyCover(const QString& origSrcFile);
+	int copyFile(const QString& from, int startPc = 0);
 
 private:
+#ifdef Q_OS_LINUX
+	bool kernelCopy(QFile& src, QFile& dest, qint64 progressTotal, int startPc, int& status);
+#endif
 	void run() override;
 
 protected:
@@ -26,6 +26,7 @@
 #include "devicepropertieswidget.h"
 #include "encoders.h"
 #include "gui/covers.h"
+#include "gui/settings.h"
 #include "models/mpdlibrarymodel.h"
 #include "models/musiclibraryitemalbum.h"
 #include "models/musiclibraryitemartist.h"
@@ -43,6 +44,7 @@
 #include <QFileInfo>
 #include <QTextStream>
 #include <QTimer>
+#include <QtConcurrent/QtConcurrentMap>
 
 const QLatin1String FsDevice::constCantataCacheFile("/.cache");
 const QLatin1String FsDevice::constCantataSettingsFile("/.cantata");
@@ -60,7 +62,7 @@ const QLatin1String FsDevice::constDefCoverFileName("cover.jpg");
 const QLatin1String FsDevice::constAutoScanKey("auto_scan");// Cantata extension!
 
 MusicScanner::MusicScanner(const QString& id)
-	: QObject(nullptr), stopRequested(false), count(0)
+	: QObject(nullptr), count(0)
 {
 	thread = new Thread(metaObject()->className() + QLatin1String("::") + id);
 	moveToThread(thread);
@@ -78,7 +80,7 @@ void MusicScanner::scan(const QString& folder, const QString& cacheFile, bool re
 		MusicLibraryItemRoot* lib = new MusicLibraryItemRoot;
 		readProgress(0.0);
 		if (lib->fromXML(cacheFile, folder)) {
-			if (!stopRequested) {
+			if (!wasStopped()) {
 				emit libraryUpdated(lib);
 			}
 			else {
@@ -91,7 +93,7 @@ void MusicScanner::scan(const QString& folder, const QString& cacheFile, bool re
 		}
 	}
 
-	if (stopRequested) {
+	if (wasStopped()) {
 		return;
 	}
 	count = 0;
@@ -99,9 +101,9 @@ void MusicScanner::scan(const QString& folder, const QString& cacheFile, bool re
 	QString topLevel = Utils::fixPath(QDir(folder).absolutePath());
 	QSet<FileOnlySong> existing = existingSongs;
 	timer.start();
-	scanFolder(library, topLevel, topLevel, existing, 0);
+	scanFolder(library, topLevel, existing);
 
-	if (!stopRequested) {
+	if (!wasStopped()) {
 		if (!cacheFile.isEmpty()) {
 			writeProgress(0.0);
 			library->toXML(cacheFile, this);
@@ -122,67 +124,135 @@ void MusicScanner::saveCache(const QString& cache, MusicLibraryItemRoot* lib)
 
 void MusicScanner::stop()
 {
-	stopRequested = true;
+	stopRequested.storeRelaxed(1);
 	thread->stop();
 	thread = nullptr;
 }
 
-void MusicScanner::scanFolder(MusicLibraryItemRoot* library, const QString& topLevel, const QString& f,
-                              QSet<FileOnlySong>& existing, int level)
+static const int constMaxFolderLevel = 4;
+
+static inline bool isAudioFile(const QString& fname)
 {
-	if (stopRequested) {
+	return !fname.endsWith(".jpg", Qt::CaseInsensitive) && !fname.endsWith(".png", Qt::CaseInsensitive) && !fname.endsWith(".lyrics", Qt::CaseInsensitive) && !fname.endsWith(".pamp", Qt::CaseInsensitive);
+}
+
+static void listFolder(const QString& f, int level, const QAtomicInt& stop, QFileInfoList& files, QStringList* subDirs = nullptr)
+{
+	if (level >= constMaxFolderLevel || stop.loadRelaxed()) {
 		return;
 	}
-	if (level < 4) {
-		QDir d(f);
-		QFileInfoList entries = d.entryInfoList(QDir::Files | QDir::NoSymLinks | QDir::Dirs | QDir::NoDotAndDotDot);
-		MusicLibraryItemArtist* artistItem = nullptr;
-		MusicLibraryItemAlbum* albumItem = nullptr;
-		for (const QFileInfo& info : entries) {
-			if (stopRequested) {
-				return;
+	QDir d(f);
+	QFileInfoList entries = d.entryInfoList(QDir::Files | QDir::NoSymLinks | QDir::Dirs | QDir::NoDotAndDotDot);
+	for (const QFileInfo& info : entries) {
+		if (stop.loadRelaxed()) {
+			return;
+		}
+		if (info.isDir()) {
+			if (subDirs) {
+				subDirs->append(info.absoluteFilePath());
 			}
-			if (info.isDir()) {
-				scanFolder(library, topLevel, info.absoluteFilePath(), existing, level + 1);
+			else {
+				listFolder(info.absoluteFilePath(), level + 1, stop, files);
 			}
-			else if (info.isReadable()) {
-				Song song;
-				QString fname = info.absoluteFilePath().mid(topLevel.length());
+		}
+		else if (info.isReadable() && isAudioFile(info.fileName())) {
+			files.append(info);
+		}
+	}
+}
 
-				if (fname.endsWith(".jpg", Qt::CaseInsensitive) || fname.endsWith(".png", Qt::CaseInsensitive) || fname.endsWith(".lyrics", Qt::CaseInsensitive) || fname.endsWith(".pamp", Qt::CaseInsensitive)) {
-					continue;
-				}
-				song.file = fname;
-				QSet<FileOnlySong>::iterator it = existing.find(song);
-				if (existing.end() == it) {
-					song = Tags::read(info.absoluteFilePath());
-					song.file = fname;
-				}
-				else {
-					song = *it;
-					existing.erase(it);
-				}
-				if (song.isEmpty()) {
-					continue;
-				}
-				count++;
-				if (timer.elapsed() >= 1500 || 0 == (count % 5)) {
-					timer.restart();
-					emit songCount(count);
-				}
+static const int constReadBatchSize = 64;
 
-				song.fillEmptyFields();
-				song.populateSorts();
-				song.size = info.size();
-				if (!artistItem || song.albumArtistOrComposer() != artistItem->data()) {
-					artistItem = library->artist(song);
-				}
-				if (!albumItem || albumItem->parentItem() != artistItem || song.albumName() != albumItem->data()) {
-					albumItem = artistItem->album(song);
+static bool isUnchanged(const QFileInfo& info, const QString& topLevel, const QSet<FileOnlySong>& existing)
+{
+	Song song;
+	song.file = info.absoluteFilePath().mid(topLevel.length());
+	QSet<FileOnlySong>::const_iterator it = existing.constFind(song);
+	return existing.constEnd() != it && it->size == static_cast<qint32>(info.size()) && 0 != it->lastModified && it->lastModified == static_cast<uint>(info.lastModified().toSecsSinceEpoch());
+}
+
+void MusicScanner::scanFolder(MusicLibraryItemRoot* library, const QString& topLevel, QSet<FileOnlySong>& existing)
+{
+	QElapsedTimer scanTimer;
+	scanTimer.start();
+
+	// List top-level files, and then walk each top-level folder in the thread pool
+	QFileInfoList files;
+	QStringList subDirs;
+	listFolder(topLevel, 0, stopRequested, files, &subDirs);
+	const QAtomicInt& stop = stopRequested;
+	QList<QFileInfoList> subFiles = QtConcurrent::blockingMapped<QList<QFileInfoList>>(subDirs, [&stop](const QString& dir) {
+		QFileInfoList dirFiles;
+		listFolder(dir, 1, stop, dirFiles);
+		return dirFiles;
+	});
+	for (const QFileInfoList& f : subFiles) {
+		files += f;
+	}
+
+	MusicLibraryItemArtist* artistItem = nullptr;
+	MusicLibraryItemAlbum* albumItem = nullptr;
+	int processed = 0;
+	QList<Song> readSongs;
+	int readIndex = 0;
+	for (int i = 0; i < files.count(); ++i) {
+		if (wasStopped()) {
+			return;
+		}
+		// Tags are read in batches, so that the helper can read several files at once
+		if (0 == (i % constReadBatchSize)) {
+			QStringList toRead;
+			for (int j = i; j < files.count() && j < i + constReadBatchSize; ++j) {
+				if (!isUnchanged(files.at(j), topLevel, existing)) {
+					toRead.append(files.at(j).absoluteFilePath());
 				}
-				albumItem->append(new MusicLibraryItemSong(song, albumItem));
 			}
+			readSongs = Tags::read(toRead);
+			readIndex = 0;
+		}
+		const QFileInfo& info = files.at(i);
+		Song song;
+		QString fname = info.absoluteFilePath().mid(topLevel.length());
+		qint32 size = static_cast<qint32>(info.size());
+		uint modified = static_cast<uint>(info.lastModified().toSecsSinceEpoch());
+
+		song.file = fname;
+		QSet<FileOnlySong>::iterator it = existing.find(song);
+		// Only re-read tags if the file is new, or its size or modification time has changed.
+		if (isUnchanged(info, topLevel, existing)) {
+			song = *it;
+			existing.erase(it);
+		}
+		else {
+			if (existing.end() != it) {
+				existing.erase(it);
+			}
+			song = readIndex < readSongs.count() ? readSongs.at(readIndex) : Song();
+			readIndex++;
+			song.file = fname;
+		}
+		processed++;
+		if (song.isEmpty()) {
+			continue;
+		}
+		count++;
+		if (timer.elapsed() >= 1500 || 0 == (count % 5)) {
+			timer.restart();
+			qint64 elapsed = scanTimer.elapsed();
+			emit songCount(count, elapsed > 0 ? static_cast<int>((processed * 1000) / elapsed) : 0);
+		}
+
+		song.fillEmptyFields();
+		song.populateSorts();
+		song.size = size;
+		song.lastModified = modified;
+		if (!artistItem || song.albumArtistOrComposer() != artistItem->data()) {
+			artistItem = library->artist(song);
 		}
+		if (!albumItem || albumItem->parentItem() != artistItem || song.albumName() != albumItem->data()) {
+			albumItem = artistItem->album(song);
+		}
+		albumItem->append(new MusicLibraryItemSong(song, albumItem));
 	}
 }
 
@@ -377,79 +447,99 @@ void FsDevice::stop()
 	}
 }
 
+int FsDevice::maxAddSongJobs() const
+{
+	return Settings::self()->deviceTranscodeJobs();
+}
+
+void FsDevice::abortJob()
+{
+	Device::abortJob();
+	// Stop queued jobs too, not just those reporting progress, so that none continue once
+	// the dialog has gone
+	QHash<QObject*, AddJob>::ConstIterator it = addJobs.constBegin();
+	QHash<QObject*, AddJob>::ConstIterator end = addJobs.constEnd();
+	for (; it != end; ++it) {
+		FileJob* job = qobject_cast<FileJob*>(it.key());
+		if (job) {
+			job->stop();
+		}
+		abortedJobs.insert(it.key());
+	}
+	addJobs.clear();
+}
+
 void FsDevice::addSong(const Song& s, bool overwrite, bool copyCover)
 {
+	// Jobs from an aborted dialog are tracked in abortedJobs, so this can be reset for each song
 	jobAbortRequested = false;
 	if (!isConnected()) {
-		emit actionStatus(NotConnected);
+		emit actionStatus(NotConnected, false, s.file);
 		return;
 	}
 
-	needToFixVa = opts.fixVariousArtists && s.isVariousArtists();
+	bool fixVa = opts.fixVariousArtists && s.isVariousArtists();
 
 	if (!overwrite) {
 		Song check = s;
 
-		if (needToFixVa) {
+		if (fixVa) {
 			Device::fixVariousArtists(QString(), check, true);
 		}
 		if (songExists(check)) {
-			emit actionStatus(SongExists);
+			emit actionStatus(SongExists, false, s.file);
 			return;
 		}
 	}
 
 	if (!QFile::exists(s.file)) {
-		emit actionStatus(SourceFileDoesNotExist);
+		emit actionStatus(SourceFileDoesNotExist, false, s.file);
 		return;
 	}
 
-	currentDestFile = audioFolder + opts.createFilename(s);
+	QString destFile = audioFolder + opts.createFilename(s);
 	Encoders::Encoder encoder;
 
-	transcoding = false;
+	bool transcode = false;
 	if (!opts.transcoderCodec.isEmpty()) {
 		encoder = Encoders::getEncoder(opts.transcoderCodec);
 		if (encoder.codec.isEmpty()) {
-			emit actionStatus(CodecNotAvailable);
+			emit actionStatus(CodecNotAvailable, false, s.file);
 			return;
 		}
 
-		transcoding = !opts.transcoderCodec.isEmpty() && (DeviceOptions::TW_IfDifferent != opts.transcoderWhen || encoder.isDifferent(s.file)) && (DeviceOptions::TW_IfLossess != opts.transcoderWhen || Device::isLossless(s.file));
+		transcode = !opts.transcoderCodec.isEmpty() && (DeviceOptions::TW_IfDifferent != opts.transcoderWhen || encoder.isDifferent(s.file)) && (DeviceOptions::TW_IfLossess != opts.transcoderWhen || Device::isLossless(s.file));
 
-		if (transcoding) {
-			currentDestFile = encoder.changeExtension(currentDestFile);
+		if (transcode) {
+			destFile = encoder.changeExtension(destFile);
 		}
 	}
 
-	if (!overwrite && QFile::exists(currentDestFile)) {
-		emit actionStatus(FileExists);
+	if (!overwrite && QFile::exists(destFile)) {
+		emit actionStatus(FileExists, false, s.file);
 		return;
 	}
 
-	QDir dir(Utils::getDir(currentDestFile));
+	QDir dir(Utils::getDir(destFile));
 	if (!dir.exists() && !Utils::createWorldReadableDir(dir.absolutePath(), QString())) {
-		emit actionStatus(DirCreationFaild);
+		emit actionStatus(DirCreationFaild, false, s.file);
 		return;
 	}
-	currentSong = s;
 
-	if (transcoding) {
-		TranscodingJob* job = new TranscodingJob(encoder, opts.transcoderValue, s.file, currentDestFile, copyCover ? opts : DeviceOptions(Device::constNoCover),
-		                                         (needToFixVa ? CopyJob::OptsApplyVaFix : CopyJob::OptsNone) | (Device::RemoteFs == devType() ? CopyJob::OptsFixLocal : CopyJob::OptsNone),
-		                                         currentSong);
-		connect(job, SIGNAL(result(int)), SLOT(addSongResult(int)));
-		connect(job, SIGNAL(percent(int)), SLOT(percent(int)));
-		job->start();
+	int copyOpts = (fixVa ? CopyJob::OptsApplyVaFix : CopyJob::OptsNone) | (Device::RemoteFs == devType() ? CopyJob::OptsFixLocal : CopyJob::OptsNone);
+	CopyJob* job = nullptr;
+	if (transcode) {
+		// Transcode locally, so that the device is only written to by the (limited number of) copy threads
+		job = new TranscodingJob(encoder, opts.transcoderValue, s.file, destFile, copyCover ? opts : DeviceOptions(Device::constNoCover),
+		                         copyOpts | CopyJob::OptsTranscodeToTemp, s);
 	}
 	else {
-		CopyJob* job = new CopyJob(s.file, currentDestFile, copyCover ? opts : DeviceOptions(Device::constNoCover),
-		                           (needToFixVa ? CopyJob::OptsApplyVaFix : CopyJob::OptsNone) | (Device::RemoteFs == devType() ? CopyJob::OptsFixLocal : CopyJob::OptsNone),
-		                           currentSong);
-		connect(job, SIGNAL(result(int)), SLOT(addSongResult(int)));
-		connect(job, SIGNAL(percent(int)), SLOT(percent(int)));
-		job->start();
+		job = new CopyJob(s.file, destFile, copyCover ? opts : DeviceOptions(Device::constNoCover), copyOpts, s);
 	}
+	addJobs.insert(job, AddJob(s, fixVa));
+	connect(job, SIGNAL(result(int)), SLOT(addSongResult(int)));
+	connect(job, SIGNAL(percent(int)), SLOT(percent(int)));
+	job->start();
 }
 
 void FsDevice::copySongTo(const Song& s, const QString& musicPath, bool overwrite, bool copyCover)
@@ -558,14 +648,20 @@ Covers::Image FsDevice::requestCover(const Song& s)
 
 void FsDevice::percent(int pc)
 {
-	if (jobAbortRequested && 100 != pc) {
+	if ((jobAbortRequested || abortedJobs.contains(sender())) && 100 != pc) {
 		FileJob* job = qobject_cast<FileJob*>(sender());
 		if (job) {
 			job->stop();
 		}
 		return;
 	}
-	emit progress(pc);
+	QHash<QObject*, AddJob>::ConstIterator it = addJobs.constFind(sender());
+	if (it != addJobs.constEnd()) {
+		emit progress(pc, it.value().song.file);
+	}
+	else {
+		emit progress(pc);
+	}
 }
 
 void FsDevice::addSongResult(int status)
@@ -573,23 +669,29 @@ void FsDevice::addSongResult(int status)
 	CopyJob* job = qobject_cast<CopyJob*>(sender());
 	FileJob::finished(job);
 	spaceInfo.setDirty();
+	AddJob details = addJobs.take(sender());
 
-	if (jobAbortRequested) {
-		if (job && job->wasStarted() && QFile::exists(currentDestFile)) {
-			QFile::remove(currentDestFile);
+	if (abortedJobs.remove(sender()) || jobAbortRequested) {
+		if (job && job->wasStarted() && QFile::exists(job->destination())) {
+			QFile::remove(job->destination());
 		}
 		return;
 	}
+	if (!job) {
+		return;
+	}
+	QString srcFile = details.song.file;
 	if (Ok != status) {
-		emit actionStatus(status);
+		emit actionStatus(status, false, srcFile);
 	}
 	else {
-		currentSong.file = currentDestFile.mid(audioFolder.length());
-		if (needToFixVa) {
-			currentSong.fixVariousArtists();
+		Song song = details.song;
+		song.file = job->destination().mid(audioFolder.length());
+		if (details.fixVa) {
+			song.fixVariousArtists();
 		}
-		addSongToList(currentSong);
-		emit actionStatus(Ok, job && job->coverCopied());
+		addSongToList(song);
+		emit actionStatus(Ok, job->coverCopied(), srcFile);
 	}
 }
 
@@ -662,7 +764,7 @@ void FsDevice::initScaner()
 		}
 		scanner = new MusicScanner(data());
 		connect(scanner, SIGNAL(libraryUpdated(MusicLibraryItemRoot*)), this, SLOT(libraryUpdated(MusicLibraryItemRoot*)));
-		connect(scanner, SIGNAL(songCount(int)), this, SLOT(songCount(int)));
+		connect(scanner, SIGNAL(songCount(int, int)), this, SLOT(songCount(int, int)));
 		connect(scanner, SIGNAL(cacheSaved()), this, SLOT(savedCache()));
 		connect(scanner, SIGNAL(savingCache(int)), this, SLOT(savingCache(int)));
 		connect(scanner, SIGNAL(readingCache(int)), this, SLOT(readingCache(int)));
@@ -696,7 +798,7 @@ void FsDevice::stopScanner()
 		return;
 	}
 	disconnect(scanner, SIGNAL(libraryUpdated(MusicLibraryItemRoot*)), this, SLOT(libraryUpdated(MusicLibraryItemRoot*)));
-	disconnect(scanner, SIGNAL(songCount(int)), this, SLOT(songCount(int)));
+	disconnect(scanner, SIGNAL(songCount(int, int)), this, SLOT(songCount(int, int)));
 	disconnect(scanner, SIGNAL(cacheSaved()), this, SLOT(savedCache()));
 	disconnect(scanner, SIGNAL(savingCache(int)), this, SLOT(savingCache(int)));
 	disconnect(scanner, SIGNAL(readingCache(int)), this, SLOT(readingCache(int)));
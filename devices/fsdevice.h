@@ -30,7 +30,10 @@
 #include "models/musiclibraryitemroot.h"
 #include "mpd-interface/song.h"
 #include "support/utils.h"
+#include <QAtomicInt>
 #include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
 #include <QStringList>
 
 class Thread;
@@ -55,7 +58,7 @@ public:
 	~MusicScanner() override;
 
 	void stop();
-	bool wasStopped() const override { return stopRequested; }
+	bool wasStopped() const override { return stopRequested.loadRelaxed(); }
 	void readProgress(double pc) override;
 	void writeProgress(double pc) override;
 
@@ -64,18 +67,18 @@ public Q_SLOTS:
 	void saveCache(const QString& cache, MusicLibraryItemRoot* lib);
 
 Q_SIGNALS:
-	void songCount(int c);
+	void songCount(int c, int rate);
 	void libraryUpdated(MusicLibraryItemRoot*);
 	void cacheSaved();
 	void readingCache(int pc);
 	void savingCache(int pc);
 
 private:
-	void scanFolder(MusicLibraryItemRoot* library, const QString& topLevel, const QString& f, QSet<FileOnlySong>& existing, int level);
+	void scanFolder(MusicLibraryItemRoot* library, const QString& topLevel, QSet<FileOnlySong>& existing);
 
 private:
 	Thread* thread;
-	bool stopRequested;
+	QAtomicInt stopRequested;
 	int count;
 	QElapsedTimer timer;
 };
@@ -128,6 +131,8 @@ public:
 	void removeCache() override;
 	bool isStdFs() const override { return true; }
 	bool canPlaySongs() const override { return HttpServer::self()->isAlive(); }
+	int maxAddSongJobs() const override;
+	void abortJob() override;
 
 Q_SIGNALS:
 	// For talking to scanner...
@@ -154,7 +159,18 @@ protected Q_SLOTS:
 private:
 	void cacheStatus(const QString& msg, int prog);
 
+private:
+	struct AddJob {
+		AddJob(const Song& s = Song(), bool va = false)
+			: song(s), fixVa(va) {}
+		Song song;
+		bool fixVa;
+	};
+
 protected:
+	QHash<QObject*, AddJob> addJobs;
+	// Jobs stopped by abortJob(), whose results are still to come
+	QSet<QObject*> abortedJobs;
 	State state;
 	bool scanned;
 	int cacheProgress;
@@ -22,17 +22,28 @@
 
 #include "transcodingjob.h"
 #include "device.h"
+#include <QDir>
 #include <QRegularExpression>
 #include <QStringList>
 
 TranscodingJob::TranscodingJob(const Encoders::Encoder& enc, int val, const QString& src, const QString& dest, const DeviceOptions& d, int co, const Song& s)
-	: CopyJob(src, dest, d, co, s), encoder(enc), value(val), process(nullptr), duration(-1)
+	: CopyJob(src, dest, d, co, s), encoder(enc), value(val), process(nullptr), transcoded(nullptr), duration(-1)
 {
 }
 
 TranscodingJob::~TranscodingJob()
 {
 	delete process;
+	delete transcoded;
+}
+
+// Percentage of progress used for transcoding, when the transcoded file then needs to be copied
+static const int constTranscodePercent = 90;
+
+void TranscodingJob::start()
+{
+	// Transcoding is driven by QProcess signals, so does not need a thread of its own
+	FileJob::start();
 }
 
 void TranscodingJob::run()
@@ -46,7 +57,19 @@ void TranscodingJob::run()
 		emit result(Device::Cancelled);
 	}
 	else {
-		QStringList parameters = encoder.params(value, src, destFile);
+		QString output = destFile;
+		if (copyOpts & OptsTranscodeToTemp) {
+			transcoded = new QTemporaryFile(QDir::tempPath() + QLatin1String("/cantata_XXXXXX.") + encoder.extension, this);
+			if (!transcoded->open()) {
+				emit result(Device::FailedToCreateTempFile);
+				return;
+			}
+			output = transcoded->fileName();
+			transcoded->close();
+			// Encoder will not overwrite an existing file
+			QFile::remove(output);
+		}
+		QStringList parameters = encoder.params(value, src, output);
 		process = new QProcess;
 		process->setProcessChannelMode(QProcess::MergedChannels);
 		process->setReadChannel(QProcess::StandardOutput);
@@ -58,11 +81,20 @@ void TranscodingJob::run()
 }
 
 void TranscodingJob::stop()
+{
+	// May be called from the GUI thread, whilst the job is queued, transcoding, or copying.
+	// The process belongs to the job's thread, so it is stopped there.
+	CopyJob::stop();
+	QMetaObject::invokeMethod(this, "stopProcess", Qt::QueuedConnection);
+}
+
+void TranscodingJob::stopProcess()
 {
 	if (process) {
-		process->close();
-		process->deleteLater();
+		QProcess* p = process;
 		process = nullptr;
+		p->close();
+		p->deleteLater();
 		emit result(Device::Cancelled);
 	}
 }
@@ -77,17 +109,39 @@ void TranscodingJob::finished(int exitCode, QProcess::ExitStatus exitStatus)
 		emit result(Device::Cancelled);
 		return;
 	}
+	if (0 == exitCode && transcoded) {
+		// Fix tags of the local file, and then copy to the device on one of the copy threads. Once the
+		// job has moved, this thread is free for further transcodes.
+		updateTagsDest(transcoded->fileName());
+		process->deleteLater();
+		process = nullptr;
+		FileThread::self()->addCopyJob(this);
+		QMetaObject::invokeMethod(this, "copyTranscoded", Qt::QueuedConnection);
+		return;
+	}
 	if (0 == exitCode) {
-		updateTagsDest();
+		updateTagsDest(destFile);
 		copyCover(srcFile);
 	}
 	emit result(0 == exitCode ? Device::Ok : Device::TranscodeFailed);
 }
 
+void TranscodingJob::copyTranscoded()
+{
+	int status = copyFile(transcoded->fileName(), constTranscodePercent);
+	delete transcoded;
+	transcoded = nullptr;
+	if (Device::Ok == status) {
+		copyCover(srcFile);
+		setPercent(100);
+	}
+	emit result(status);
+}
+
 void TranscodingJob::processOutput()
 {
 	if (stopRequested) {
-		emit result(Device::Cancelled);
+		stopProcess();
 		return;
 	}
 	QString output = process->readAllStandardOutput().data();
@@ -105,7 +159,7 @@ void TranscodingJob::processOutput()
 	if (duration > 0) {
 		qint64 prog = computeProgress(output);
 		if (prog > -1) {
-			setPercent((prog * 100) / duration);
+			setPercent((prog * (transcoded ? constTranscodePercent : 100)) / duration);
 		}
 	}
 
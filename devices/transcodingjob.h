@@ -25,6 +25,7 @@
 #include "encoders.h"
 #include "filejob.h"
 #include <QProcess>
+#include <QTemporaryFile>
 
 class TranscodingJob : public CopyJob {
 	Q_OBJECT
@@ -33,6 +34,7 @@ public:
 	                        const DeviceOptions& d = DeviceOptions(), int co = 0, const Song& s = Song());
 	~TranscodingJob() override;
 
+	void start() override;
 	void stop() override;
 
 private:
@@ -41,6 +43,8 @@ private:
 private Q_SLOTS:
 	void processOutput();
 	void finished(int exitCode, QProcess::ExitStatus exitStatus);
+	void copyTranscoded();
+	void stopProcess();
 
 private:
 	inline qint64 computeDuration(const QString& output);
@@ -50,6 +54,7 @@ private:
 	Encoders::Encoder encoder;
 	int value;
 	QProcess* process;
+	QTemporaryFile* transcoded;
 	qint64 duration;//in csec
 	QString data;
 };
@@ -107,6 +107,8 @@ CacheItemCounter::~CacheItemCounter()
 {
 	if (thread) {
 		thread->stop();
+		// Let any delete in progress finish before this object goes
+		thread->wait();
 	}
 }
 
@@ -121,21 +123,27 @@ void CacheItemCounter::getCount()
 void CacheItemCounter::deleteAll()
 {
 	::deleteAll(dir, types);
+	emit deleted();
 	getCount();
 }
 
 CacheItem::CacheItem(const QString& title, const QString& d, const QStringList& t, QTreeWidget* p, Type ty)
-	: QTreeWidgetItem(p, QStringList() << title), counter(new CacheItemCounter(title, d, t)), empty(true), usedSpace(0), type(ty)
+	: QTreeWidgetItem(p, QStringList() << title), counter(new CacheItemCounter(title, d, t)), empty(true), usedSpace(0), type(ty), pendingDeletes(0)
 {
 	connect(this, SIGNAL(getCount()), counter, SLOT(getCount()), Qt::QueuedConnection);
 	connect(this, SIGNAL(deleteAll()), counter, SLOT(deleteAll()), Qt::QueuedConnection);
 	connect(counter, SIGNAL(count(int, quint64)), this, SLOT(update(int, quint64)), Qt::QueuedConnection);
+	connect(counter, SIGNAL(deleted()), this, SLOT(deleted()), Qt::QueuedConnection);
 	connect(this, SIGNAL(updated()), p, SIGNAL(itemSelectionChanged()));
 }
 
 CacheItem::~CacheItem()
 {
 	delete counter;
+	// Deletes that were queued, but never run, will not report back
+	for (; pendingDeletes > 0; --pendingDeletes) {
+		Covers::self()->scaleCacheCleared();
+	}
 }
 
 void CacheItem::update(int itemCount, quint64 space)
@@ -164,11 +172,22 @@ void CacheItem::setStatus(const QString& str)
 void CacheItem::clean()
 {
 	setStatus(tr("Deleting..."));
+	// Stores must be closed before their files are deleted
+	if (Type_ScaledCovers == type) {
+		Covers::self()->clearScaleCache();
+		pendingDeletes++;
+	}
 	emit deleteAll();
-	switch (type) {
-	case Type_Covers: Covers::self()->clearNameCache(); break;
-	case Type_ScaledCovers: Covers::self()->clearScaleCache(); break;
-	default: break;
+	if (Type_Covers == type) {
+		Covers::self()->clearNameCache();
+	}
+}
+
+void CacheItem::deleted()
+{
+	if (Type_ScaledCovers == type && pendingDeletes > 0) {
+		pendingDeletes--;
+		Covers::self()->scaleCacheCleared();
 	}
 }
 
@@ -261,7 +280,8 @@ CacheSettings::CacheSettings(QWidget* parent)
 	              tree,
 	              CacheItem::Type_Covers);
 	new CacheItem(tr("Scaled Covers"), Utils::cacheDir(Covers::constScaledCoverDir, false), QStringList() << "*.jpg"
-	                                                                                                      << "*.png",
+	                                                                                                      << "*.png"
+	                                                                                                      << "*.dat",
 	              tree,
 	              CacheItem::Type_ScaledCovers);
 	new CacheItem(tr("Backdrops"), Utils::cacheDir(ContextWidget::constCacheDir, false), QStringList() << "*.jpg"
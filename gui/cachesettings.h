@@ -52,6 +52,7 @@ public:
 
 Q_SIGNALS:
 	void count(int num, quint64 space);
+	void deleted();
 
 public Q_SLOTS:
 	void getCount();
@@ -90,6 +91,7 @@ Q_SIGNALS:
 
 private Q_SLOTS:
 	void update(int itemCount, quint64 space);
+	void deleted();
 
 private:
 	void setStatus(const QString& str = QString());
@@ -99,6 +101,7 @@ private:
 	bool empty;
 	quint64 usedSpace;
 	Type type;
+	int pendingDeletes;
 };
 
 class CacheTree : public QTreeWidget {
@@ -29,6 +29,7 @@
 #include "mpd-interface/song.h"
 #include "network/networkaccessmanager.h"
 #include "online/onlineservice.h"
+#include "scaledcoverstore.h"
 #include "settings.h"
 #include "support/thread.h"
 #include "support/utils.h"
@@ -42,13 +43,18 @@
 #include "support/globalstatic.h"
 #include "widgets/icons.h"
 #include <QApplication>
+#include <QAtomicInt>
+#include <QBuffer>
+#include <QDataStream>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QFont>
 #include <QIcon>
 #include <QImage>
 #include <QJsonDocument>
 #include <QJsonParseError>
+#include <QMutex>
 #include <QPainter>
 #include <QScreen>
 #include <QTextStream>
@@ -56,6 +62,7 @@
 #include <QUrl>
 #include <QUrlQuery>
 #include <QXmlStreamReader>
+#include <QtConcurrent/QtConcurrentMap>
 #include <qglobal.h>
 
 GLOBAL_STATIC(Covers, instance)
@@ -110,6 +117,20 @@ static const QLatin1String constScaledPrevExtension(".jpg");
 static const char* constScaledFormat = "PNG";
 #endif
 
+// Minimum size of the in-memory cache - this must be able to hold the largest scaled cover
+static const int constMinCacheSize = 15 * 1024 * 1024;
+// Approximate overhead of each cache entry, so that dummy 1x1 pixmaps are not free
+static const int constMinPixmapCost = 256;
+// Log cache statistics after this many lookups
+static const int constStatsInterval = 1000;
+static QAtomicInt diskHits(0);
+static QAtomicInt diskMisses(0);
+
+static inline int pixmapCost(const QPixmap* pix)
+{
+	return qMax(pix->width() * pix->height() * (pix->depth() / 8), constMinPixmapCost);
+}
+
 static QImage scale(const Song& song, const QImage& img, int size)
 {
 	if (song.isArtistImageRequest() || song.isComposerImageRequest()) {
@@ -334,16 +355,39 @@ static void clearScaledCache(const Song& song)
 			}
 		}
 	}
+
+	QString key = songKey(song);
+	const QList<int> sizes = ScaledCoverStore::existingSizes();
+	for (int size : sizes) {
+		ScaledCoverStore::get(size)->remove(key);
+	}
 }
 
 static QImage loadScaledCover(const Song& song, int size)
 {
+	ScaledCoverStore* store = ScaledCoverStore::get(size);
+	QString key = songKey(song);
+	QImage img = store->load(key, constScaledFormat);
+	if (!img.isNull() && (img.width() == size || img.height() == size)) {
+		VERBOSE_DBUG_CLASS("Covers") << song.albumArtist() << song.albumId() << size << "scaled cover found in store";
+		diskHits.fetchAndAddRelaxed(1);
+		return img;
+	}
+
 	QString fileName = getScaledCoverName(song, size, false);
 	if (!fileName.isEmpty()) {
 		if (QFile::exists(fileName)) {
-			QImage img(fileName, constScaledFormat);
+			// Scaled cover saved before covers were stored in a single file, move it into the store.
+			QFile f(fileName);
+			QByteArray data = f.open(QIODevice::ReadOnly) ? f.readAll() : QByteArray();
+			f.close();
+			img = QImage::fromData(data, constScaledFormat);
 			if (!img.isNull() && (img.width() == size || img.height() == size)) {
 				DBUG_CLASS("Covers") << song.albumArtist() << song.albumId() << size << "scaled cover found" << fileName;
+				if (store->save(key, data)) {
+					QFile::remove(fileName);
+				}
+				diskHits.fetchAndAddRelaxed(1);
 				return img;
 			}
 		}
@@ -355,10 +399,16 @@ static QImage loadScaledCover(const Song& song, int size)
 		}
 	}
 	VERBOSE_DBUG_CLASS("Covers") << song.albumArtist() << song.albumId() << size << "scaled cover NOT found";
+	diskMisses.fetchAndAddRelaxed(1);
 
 	return QImage();
 }
 
+bool Covers::sameCover(const Song& a, const Song& b)
+{
+	return cacheKey(a, 0) == cacheKey(b, 0);
+}
+
 bool Covers::isJpg(const QByteArray& data)
 {
 	return data.size() > 9 && /*data[0]==0xFF && data[1]==0xD8 && data[2]==0xFF*/ data[6] == 'J' && data[7] == 'F' && data[8] == 'I' && data[9] == 'F';
@@ -1248,47 +1298,48 @@ void CoverLoader::load(const Song& song)
 	startTimer(0);
 }
 
+void CoverLoader::preload(const Song& song)
+{
+	preloadQueue.append(LoadedCover(song));
+	startTimer(0);
+}
+
+static LoadedCover loadCover(const LoadedCover& s)
+{
+	DBUG_CLASS("CoverLoader") << s.song.albumArtist() << s.song.albumId() << s.song.size;
+	int size = s.song.size;
+	if (size < constRetinaScaleMaxSize) {
+		size *= devicePixelRatio;
+	}
+	return LoadedCover(s.song, loadScaledCover(s.song, size));
+}
+
 void CoverLoader::load()
 {
 	QList<LoadedCover> toDo;
-	for (int i = 0; i < constMaxCoverUpdatePerIteration && !queue.isEmpty(); ++i) {
-		toDo.append(queue.takeFirst());
+	for (int i = 0; i < constMaxCoverUpdatePerIteration && (!queue.isEmpty() || !preloadQueue.isEmpty()); ++i) {
+		toDo.append(queue.isEmpty() ? preloadQueue.takeFirst() : queue.takeFirst());
 	}
 	if (toDo.isEmpty()) {
 		return;
 	}
-	QList<LoadedCover> covers;
-	for (const LoadedCover& s : toDo) {
-		DBUG << s.song.albumArtist() << s.song.albumId() << s.song.size;
-		int size = s.song.size;
-		if (size < constRetinaScaleMaxSize) {
-			size *= devicePixelRatio;
-		}
-		covers.append(LoadedCover(s.song, loadScaledCover(s.song, size)));
-	}
+	// Decode the images using the global thread pool, so that slow disks do not serialise each load
+	QList<LoadedCover> covers = QtConcurrent::blockingMapped<QList<LoadedCover>>(toDo, loadCover);
 	if (!covers.isEmpty()) {
 		DBUG << "loaded" << covers.count();
 		emit loaded(covers);
 	}
 
-	if (!queue.isEmpty()) {
+	if (!queue.isEmpty() || !preloadQueue.isEmpty()) {
 		startTimer(0);
 	}
 }
 
 Covers::Covers()
-	: downloader(nullptr), locator(nullptr), loader(nullptr)
+	: memHits(0), memMisses(0), memEvictions(0), downloader(nullptr), locator(nullptr), loader(nullptr)
 {
 	devicePixelRatio = qApp->devicePixelRatio();
-
-	// Use screen size to calculate max cost - Issue #1498
-	int maxCost = 0;
-	QScreen* sc = QGuiApplication::primaryScreen();
-	if (sc) {
-		QSize sz = sc->availableGeometry().size();
-		maxCost = sz.width() * sz.height() * 5;// *5 as 32-bit pixmap (so 4 bytes), + some wiggle rooom :-)
-	}
-	cache.setMaxCost(qMax(static_cast<int>(15 * 1024 * 1024 * devicePixelRatio), maxCost));// Ensure at least 15M
+	setCacheSize(0);
 }
 
 void Covers::readConfig()
@@ -1299,6 +1350,70 @@ void Covers::readConfig()
 	if (albumCoverName.isEmpty()) {
 		albumCoverName = constFileName;
 	}
+	setCacheSize(Settings::self()->coverMemoryCacheSize());
+	ScaledCoverStore::setMaxTotalSize(static_cast<qint64>(Settings::self()->coverDiskCacheSize()) * 1024 * 1024);
+}
+
+void Covers::setCacheSize(int mb)
+{
+	int maxCost = 0;
+	if (mb > 0) {
+		maxCost = mb * 1024 * 1024;
+	}
+	else {
+		// Use screen size to calculate max cost - Issue #1498
+		QScreen* sc = QGuiApplication::primaryScreen();
+		if (sc) {
+			QSize sz = sc->availableGeometry().size();
+			maxCost = sz.width() * sz.height() * 5;// *5 as 32-bit pixmap (so 4 bytes), + some wiggle rooom :-)
+		}
+	}
+	maxCost = qMax(static_cast<int>(constMinCacheSize * devicePixelRatio), maxCost);// Ensure at least 15M
+	if (maxCost != cache.maxCost()) {
+		qsizetype before = cache.count();
+		cache.setMaxCost(maxCost);
+		memEvictions += before - cache.count();
+		DBUG << "Memory cache size" << maxCost;
+	}
+}
+
+QPixmap* Covers::cachedPixmap(const QString& key)
+{
+	QPixmap* pix = cache.object(key);
+	if (pix) {
+		memHits++;
+	}
+	else {
+		memMisses++;
+	}
+	if (0 == (memHits + memMisses) % constStatsInterval) {
+		logCacheStats();
+	}
+	return pix;
+}
+
+void Covers::cachePixmap(const QString& key, QPixmap* pix, int size)
+{
+	// Entries are evicted least recently used first, so count how many went to make room
+	qsizetype before = cache.count() - (cache.contains(key) ? 1 : 0);
+	cache.insert(key, pix, pixmapCost(pix));
+	memEvictions += qMax(static_cast<qsizetype>(0), before + 1 - cache.count());
+	cacheSizes.insert(size);
+}
+
+void Covers::logCacheStats()
+{
+	if (!debugEnabled()) {
+		return;
+	}
+	int dHits = diskHits.loadRelaxed();
+	int dMisses = diskMisses.loadRelaxed();
+	DBUG << "memory: hits" << memHits << "misses" << memMisses << "evictions" << memEvictions
+		 << "hit rate" << (memHits + memMisses ? (100.0 * memHits) / (memHits + memMisses) : 0.0) << "%"
+		 << "entries" << cache.count() << "cost" << cache.totalCost() << "of" << cache.maxCost()
+		 << "sizes" << cacheSizes.count();
+	DBUG << "disk: hits" << dHits << "misses" << dMisses << "evictions" << ScaledCoverStore::evictions()
+		 << "hit rate" << (dHits + dMisses ? (100.0 * dHits) / (dHits + dMisses) : 0.0) << "%";
 }
 
 void Covers::stop()
@@ -1336,11 +1451,20 @@ void Covers::clearNameCache()
 	mutex.lock();
 	filenames.clear();
 	mutex.unlock();
+	noCoverDirs.clear();
 }
 
 void Covers::clearScaleCache()
 {
+	logCacheStats();
 	cache.clear();
+	// Keep the stores closed until their files have been deleted
+	ScaledCoverStore::suspend();
+}
+
+void Covers::scaleCacheCleared()
+{
+	ScaledCoverStore::resume();
 }
 
 QPixmap* Covers::getScaledCover(const Song& song, int size)
@@ -1350,21 +1474,17 @@ QPixmap* Covers::getScaledCover(const Song& song, int size)
 	}
 	//    DBUG_CLASS("Covers") << song.albumArtist() << song.album << song.mbAlbumId() << size;
 	QString key = cacheKey(song, size);
-	QPixmap* pix(cache.object(key));
+	QPixmap* pix(cachedPixmap(key));
 	if (!pix) {
 		QImage img = loadScaledCover(song, size);
 		if (!img.isNull()) {
 			pix = new QPixmap(QPixmap::fromImage(img));
 		}
-		if (pix) {
-			cache.insert(key, pix, pix->width() * pix->height() * (pix->depth() / 8));
-		}
 		else {
 			// Create a dummy image so that we dont keep on stating files that do not exist!
 			pix = new QPixmap(1, 1);
-			cache.insert(key, pix, 1);
 		}
-		cacheSizes.insert(size);
+		cachePixmap(key, pix, size);
 	}
 	return pix && pix->width() > 1 ? pix : nullptr;
 }
@@ -1376,13 +1496,13 @@ QPixmap* Covers::saveScaledCover(const QImage& img, const Song& song, int size)
 	}
 
 	if (!isOnlineServiceImage(song)) {
-		QString fileName = getScaledCoverName(song, size, true);
-		bool status = img.save(fileName, constScaledFormat);
-		DBUG_CLASS("Covers") << song.albumArtist() << song.album << song.mbAlbumId() << size << fileName << status;
+		QByteArray data;
+		QBuffer buffer(&data);
+		bool status = buffer.open(QIODevice::WriteOnly) && img.save(&buffer, constScaledFormat) && ScaledCoverStore::get(size)->save(songKey(song), data);
+		DBUG_CLASS("Covers") << song.albumArtist() << song.album << song.mbAlbumId() << size << status;
 	}
 	QPixmap* pix = new QPixmap(QPixmap::fromImage(img));
-	cache.insert(cacheKey(song, size), pix, pix->width() * pix->height() * (pix->depth() / 8));
-	cacheSizes.insert(size);
+	cachePixmap(cacheKey(song, size), pix, size);
 	return pix;
 }
 
@@ -1415,13 +1535,12 @@ QPixmap* Covers::defaultPix(const Song& song, int size, int origSize)
 			pix->setDevicePixelRatio(devicePixelRatio);
 			DBUG << "Set pixel ratio of dummy pixmap" << devicePixelRatio;
 		}
-		cache.insert(key, pix, 1);
-		cacheSizes.insert(size);
+		cachePixmap(key, pix, size);
 	}
 	return pix;
 }
 
-QPixmap* Covers::get(const Song& song, int size, bool urgent)
+QPixmap* Covers::get(const Song& song, int size, bool urgent, bool prefetch)
 {
 	VERBOSE_DBUG_CLASS("Covers") << song.albumArtist() << song.album << song.mbAlbumId() << song.composer() << song.isArtistImageRequest() << song.isComposerImageRequest() << size << urgent << song.type << song.isStandardStream() << isOnlineServiceImage(song);
 	QString key;
@@ -1436,7 +1555,7 @@ QPixmap* Covers::get(const Song& song, int size, bool urgent)
 	}
 	if (!song.isUnknownAlbum() || song.isStandardStream()) {
 		key = cacheKey(song, size);
-		pix = cache.object(key);
+		pix = cachedPixmap(key);
 
 		if (!pix) {
 			/*if (song.isArtistImageRequest() && song.isVariousArtists()) {
@@ -1461,8 +1580,7 @@ QPixmap* Covers::get(const Song& song, int size, bool urgent)
 					pix->setDevicePixelRatio(devicePixelRatio);
 					VERBOSE_DBUG << "Set pixel ratio of cover" << devicePixelRatio;
 				}
-				cache.insert(key, pix, 1);
-				cacheSizes.insert(size);
+				cachePixmap(key, pix, size);
 			}
 		}
 		if (!pix) {
@@ -1488,13 +1606,12 @@ QPixmap* Covers::get(const Song& song, int size, bool urgent)
 						pix->setDevicePixelRatio(devicePixelRatio);
 						VERBOSE_DBUG << "Set pixel ratio of loaded scaled cover" << devicePixelRatio;
 					}
-					cache.insert(key, pix, pix->width() * pix->height() * (pix->depth() / 8));
-					cacheSizes.insert(size);
+					cachePixmap(key, pix, size);
 					return pix;
 				}
 			}
 			VERBOSE_DBUG << "Cached cover not found";
-			tryToLoad(setSizeRequest(song, origSize));
+			tryToLoad(setSizeRequest(song, origSize), prefetch);
 
 			// Create a dummy image so that we dont keep on locating/loading/downloading files that do not exist!
 			pix = new QPixmap(1, 1);
@@ -1502,8 +1619,7 @@ QPixmap* Covers::get(const Song& song, int size, bool urgent)
 				pix->setDevicePixelRatio(devicePixelRatio);
 				VERBOSE_DBUG << "Set pixel ratio of dummy cover" << devicePixelRatio;
 			}
-			cache.insert(key, pix, 1);
-			cacheSizes.insert(size);
+			cachePixmap(key, pix, size);
 		}
 
 		if (pix && pix->width() > 1) {
@@ -1601,7 +1717,7 @@ void Covers::tryToDownload(const Song& song)
 	emit download(song);
 }
 
-void Covers::tryToLoad(const Song& song)
+void Covers::tryToLoad(const Song& song, bool prefetch)
 {
 	if (!loader) {
 		qRegisterMetaType<LoadedCover>("LoadedCover");
@@ -1609,8 +1725,14 @@ void Covers::tryToLoad(const Song& song)
 		loader = new CoverLoader();
 		connect(loader, SIGNAL(loaded(QList<LoadedCover>)), this, SLOT(loaded(QList<LoadedCover>)), Qt::QueuedConnection);
 		connect(this, SIGNAL(load(Song)), loader, SLOT(load(Song)), Qt::QueuedConnection);
+		connect(this, SIGNAL(preload(Song)), loader, SLOT(preload(Song)), Qt::QueuedConnection);
+	}
+	if (prefetch) {
+		emit preload(song);
+	}
+	else {
+		emit load(song);
 	}
-	emit load(song);
 }
 
 Covers::Image Covers::findImage(const Song& song, bool emitResult)
@@ -1630,19 +1752,179 @@ Covers::Image Covers::findImage(const Song& song, bool emitResult)
 	return i;
 }
 
-static Covers::Image findCoverInDir(const Song& song, const QString& dirName, const QStringList& coverFileNames, const QString& songFileName = QString())
+// Contents of a folder, read once - so that looking for cover files does not need to stat() each possible name.
+struct DirListing {
+	QHash<QString, QString> files;// Lower-cased name to name on disk, as cover names are matched case-insensitively
+	QStringList images;// *.jpg and *.png files, in name order
+	QStringList dirs;
+};
+
+static inline bool isImageFile(const QString& fileName)
 {
-	Q_UNUSED(song)
-	for (const QString& fileName : coverFileNames) {
-		DBUG_CLASS("Covers") << "Checking file" << QString(dirName + fileName);
-		if (QFile::exists(dirName + fileName)) {
+	return fileName.endsWith(QLatin1String(".jpg"), Qt::CaseInsensitive) || fileName.endsWith(QLatin1String(".png"), Qt::CaseInsensitive);
+}
+
+// Persistent record of folders that contain no images, keyed on the folder's modification time. Sub-folder
+// names are stored too, as these are needed to search them - and a folder's time changes if these change.
+class NoCoverDirs {
+public:
+	NoCoverDirs()
+		: loaded(false), records(0) {}
+
+	bool get(const QString& dir, qint64 modified, QStringList& dirs)
+	{
+		QMutexLocker locker(&mutex);
+		load();
+		QHash<QString, Entry>::ConstIterator it = entries.constFind(dir);
+		if (it == entries.constEnd() || it.value().modified != modified) {
+			return false;
+		}
+		dirs = it.value().dirs;
+		return true;
+	}
+
+	void insert(const QString& dir, qint64 modified, const QStringList& dirs)
+	{
+		QMutexLocker locker(&mutex);
+		load();
+		entries.insert(dir, Entry(modified, dirs));
+		// Append, rather than re-write the whole file - any previous record for this folder is replaced when loaded.
+		QFile f(fileName());
+		if (f.open(QIODevice::WriteOnly | QIODevice::Append)) {
+			QDataStream stream(&f);
+			stream << dir << modified << dirs;
+			records++;
+		}
+	}
+
+	void clear()
+	{
+		QMutexLocker locker(&mutex);
+		entries.clear();
+		records = 0;
+		loaded = true;
+		QFile::remove(fileName());
+	}
+
+private:
+	struct Entry {
+		Entry(qint64 m = 0, const QStringList& d = QStringList())
+			: modified(m), dirs(d) {}
+		qint64 modified;
+		QStringList dirs;
+	};
+
+	static QString fileName()
+	{
+		return Utils::cacheDir(Covers::constCoverDir, true) + QLatin1String("no-cover-dirs.dat");
+	}
+
+	void load()
+	{
+		if (loaded) {
+			return;
+		}
+		loaded = true;
+		QFile f(fileName());
+		if (!f.open(QIODevice::ReadOnly)) {
+			return;
+		}
+		QDataStream stream(&f);
+		while (!stream.atEnd()) {
+			QString dir;
+			qint64 modified;
+			QStringList dirs;
+			stream >> dir >> modified >> dirs;
+			if (QDataStream::Ok != stream.status()) {
+				break;
+			}
+			entries.insert(dir, Entry(modified, dirs));
+			records++;
+		}
+		f.close();
+		DBUG_CLASS("Covers") << entries.count() << records;
+		if (records > 100 && records > entries.count() * 2) {
+			// Too many out of date records, so re-write file
+			if (f.open(QIODevice::WriteOnly)) {
+				QDataStream out(&f);
+				for (QHash<QString, Entry>::ConstIterator it = entries.constBegin(), end = entries.constEnd(); it != end; ++it) {
+					out << it.key() << it.value().modified << it.value().dirs;
+				}
+				records = entries.count();
+			}
+		}
+	}
+
+private:
+	QMutex mutex;
+	bool loaded;
+	int records;
+	QHash<QString, Entry> entries;
+};
+
+static NoCoverDirs noCoverDirs;
+
+static DirListing listDir(const QString& dirName)
+{
+	DirListing listing;
+	QFileInfo info(dirName);
+	if (!info.isDir()) {
+		return listing;
+	}
+	qint64 modified = info.lastModified().toMSecsSinceEpoch();
+	if (noCoverDirs.get(dirName, modified, listing.dirs)) {
+		DBUG_CLASS("Covers") << "No images in" << dirName;
+		return listing;
+	}
+
+	bool haveImages = false;
+	const QFileInfoList entries = QDir(dirName).entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot);
+	for (const QFileInfo& entry : entries) {
+		QString name = entry.fileName();
+		if (entry.isDir()) {
+			listing.dirs.append(name);
+		}
+		else {
+			listing.files.insert(name.toLower(), name);
+			if (isImageFile(name)) {
+				listing.images.append(name);
+				haveImages = true;
+			}
+			else if (name.endsWith(QLatin1String(".jpeg"), Qt::CaseInsensitive)) {
+				haveImages = true;
+			}
+		}
+	}
+	if (!haveImages) {
+		noCoverDirs.insert(dirName, modified, listing.dirs);
+	}
+	return listing;
+}
+
+static Covers::Image findCoverFile(const QString& dirName, const DirListing& listing, const QStringList& coverFileNames)
+{
+	for (const QString& name : coverFileNames) {
+		QHash<QString, QString>::ConstIterator it = listing.files.constFind(name.toLower());
+		if (it != listing.files.constEnd()) {
+			const QString& fileName = it.value();
+			DBUG_CLASS("Covers") << "Checking file" << QString(dirName + fileName);
 			QImage img = loadImage(dirName + fileName);
 			if (!img.isNull()) {
-				DBUG_CLASS("Covers") << "Got cover image" << QString(dirName + fileName);
+				DBUG_CLASS("Covers") << "Got image" << QString(dirName + fileName);
 				return Covers::Image(img, dirName + fileName);
 			}
 		}
 	}
+	return Covers::Image();
+}
+
+static Covers::Image findCoverInDir(const Song& song, const QString& dirName, const DirListing& listing, const QStringList& coverFileNames, const QString& songFileName = QString())
+{
+	Q_UNUSED(song)
+	Covers::Image coverImg = findCoverFile(dirName, listing, coverFileNames);
+	if (!coverImg.img.isNull()) {
+		return coverImg;
+	}
 
 	if (!songFileName.isEmpty()) {
 #ifdef TagLib_FOUND
@@ -1669,8 +1951,7 @@ static Covers::Image findCoverInDir(const Song& song, const QString& dirName, co
 #endif
 	}
 
-	QStringList files = QDir(dirName).entryList(QStringList() << QLatin1String("*.jpg") << QLatin1String("*.png"), QDir::Files | QDir::Readable);
-	for (const QString& fileName : files) {
+	for (const QString& fileName : listing.images) {
 		DBUG_CLASS("Covers") << "Checking file" << QString(dirName + fileName);
 		QImage img = loadImage(dirName + fileName);
 		if (!img.isNull()) {
@@ -1794,15 +2075,9 @@ Covers::Image Covers::locateImage(const Song& song)
 
 		if (song.isArtistImageRequest() || song.isComposerImageRequest()) {
 			for (int level = 0; level < 2; ++level) {
-				for (const QString& fileName : coverFileNames) {
-					DBUG_CLASS("Covers") << "Checking file" << QString(dirName + fileName);
-					if (QFile::exists(dirName + fileName)) {
-						QImage img = loadImage(dirName + fileName);
-						if (!img.isNull()) {
-							DBUG_CLASS("Covers") << "Got artist/composer image" << QString(dirName + fileName);
-							return Image(img, dirName + fileName);
-						}
-					}
+				Image img = findCoverFile(dirName, listDir(dirName), coverFileNames);
+				if (!img.img.isNull()) {
+					return img;
 				}
 				QDir d(dirName);
 				d.cdUp();
@@ -1816,28 +2091,23 @@ Covers::Image Covers::locateImage(const Song& song)
 				dirName = MPDConnection::self()->getDetails().dirReadable ? MPDConnection::self()->getDetails().dir : QString();
 				if (!dirName.isEmpty() && !dirName.startsWith(QLatin1String("http:/"), Qt::CaseInsensitive) && !dirName.startsWith(QLatin1String("https:/"), Qt::CaseInsensitive)) {
 					dirName += basicArtist + Utils::constDirSep;
-					for (const QString& fileName : coverFileNames) {
-						DBUG_CLASS("Covers") << "Checking file" << QString(dirName + fileName);
-						if (QFile::exists(dirName + fileName)) {
-							QImage img = loadImage(dirName + fileName);
-							if (!img.isNull()) {
-								DBUG_CLASS("Covers") << "Got artist image" << QString(dirName + fileName);
-								return Image(img, dirName + fileName);
-							}
-						}
+					Image img = findCoverFile(dirName, listDir(dirName), coverFileNames);
+					if (!img.img.isNull()) {
+						return img;
 					}
 				}
 			}
 		}
 		else {
-			Covers::Image img = findCoverInDir(song, dirName, coverFileNames, haveAbsPath || song.isCantataStream() ? songFile : (MPDConnection::self()->getDetails().dir + songFile));
+			DirListing listing = listDir(dirName);
+			Covers::Image img = findCoverInDir(song, dirName, listing, coverFileNames, haveAbsPath || song.isCantataStream() ? songFile : (MPDConnection::self()->getDetails().dir + songFile));
 			if (!img.img.isNull()) {
 				return img;
 			}
 
-			QStringList dirs = QDir(dirName).entryList(QDir::Dirs | QDir::Readable | QDir::NoDotAndDotDot);
-			for (const QString& dir : dirs) {
-				img = findCoverInDir(song, dirName + dir + Utils::constDirSep, coverFileNames);
+			for (const QString& dir : listing.dirs) {
+				QString subDir = dirName + dir + Utils::constDirSep;
+				img = findCoverInDir(song, subDir, listDir(subDir), coverFileNames);
 				if (!img.img.isNull()) {
 					return img;
 				}
@@ -1853,17 +2123,9 @@ Covers::Image Covers::locateImage(const Song& song)
 				QString songDir = artistOrComposer + Utils::constDirSep;
 				if (!song.file.startsWith(songDir)) {
 					QString dirName = MPDConnection::self()->getDetails().dir + songDir;
-					if (QDir(dirName).exists()) {
-						for (const QString& fileName : coverFileNames) {
-							DBUG_CLASS("Covers") << "Checking file" << QString(dirName + fileName);
-							if (QFile::exists(dirName + fileName)) {
-								QImage img = loadImage(dirName + fileName);
-								if (!img.isNull()) {
-									DBUG_CLASS("Covers") << "Got artist/composer image" << QString(dirName + fileName);
-									return Image(img, dirName + fileName);
-								}
-							}
-						}
+					Image img = findCoverFile(dirName, listDir(dirName), coverFileNames);
+					if (!img.img.isNull()) {
+						return img;
 					}
 				}
 			}
@@ -1891,17 +2153,9 @@ Covers::Image Covers::locateImage(const Song& song)
 			QString songDir = artist + Utils::constDirSep + album + Utils::constDirSep;
 			if (!song.file.startsWith(songDir)) {
 				QString dirName = MPDConnection::self()->getDetails().dir + songDir;
-				if (QDir(dirName).exists()) {
-					for (const QString& fileName : coverFileNames) {
-						DBUG_CLASS("Covers") << "Checking file" << QString(dirName + fileName);
-						if (QFile::exists(dirName + fileName)) {
-							QImage img = loadImage(dirName + fileName);
-							if (!img.isNull()) {
-								DBUG_CLASS("Covers") << "Got cover image" << QString(dirName + fileName);
-								return Image(img, dirName + fileName);
-							}
-						}
-					}
+				Image img = findCoverFile(dirName, listDir(dirName), coverFileNames);
+				if (!img.img.isNull()) {
+					return img;
 				}
 			}
 		}
@@ -2015,8 +2269,7 @@ void Covers::loaded(const QList<LoadedCover>& covers)
 				pix->setDevicePixelRatio(devicePixelRatio);
 				DBUG << "Set pixel ratio of loaded pixmap" << devicePixelRatio;
 			}
-			cache.insert(cacheKey(cvr.song, size), pix, pix->width() * pix->height() * (pix->depth() / 8));
-			cacheSizes.insert(size);
+			cachePixmap(cacheKey(cvr.song, size), pix, size);
 			emit loaded(cvr.song, cvr.song.size);
 		}
 		else {// Failed to load a scaled cover, try locating non-scaled cover...
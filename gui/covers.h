@@ -156,6 +156,7 @@ Q_SIGNALS:
 
 public Q_SLOTS:
 	void load(const Song& song);
+	void preload(const Song& song);
 	void load();
 
 private:
@@ -165,6 +166,7 @@ private:
 	Thread* thread;
 	QTimer* timer;
 	QList<LoadedCover> queue;
+	QList<LoadedCover> preloadQueue;// Covers not yet visible, only loaded once queue is empty
 };
 
 class Covers : public QObject {
@@ -205,6 +207,7 @@ public:
 	static bool isJpg(const QByteArray& data);
 	static bool isPng(const QByteArray& data);
 	static const char* imageFormat(const QByteArray& data);
+	static bool sameCover(const Song& a, const Song& b);
 
 	Covers();
 	void readConfig();
@@ -212,11 +215,15 @@ public:
 
 	void clearNameCache();
 	void clearScaleCache();
+	void scaleCacheCleared();
 	QPixmap* getScaledCover(const Song& song, int size);
 	QPixmap* saveScaledCover(const QImage& img, const Song& song, int size);
 	// Get cover image of specified size. If this is not found 0 will be returned, and the cover
 	// will be downloaded.
-	QPixmap* get(const Song& song, int size, bool urgent = false);
+	QPixmap* get(const Song& song, int size, bool urgent = false, bool prefetch = false);
+	// Start loading cover, at a lower priority than those requested via get(), so that it is (hopefully)
+	// in the cache by the time it is needed.
+	void prefetch(const Song& song, int size) { get(song, size, false, true); }
 	// Get QImage and filename associated with Song request. If this is not found, then the cover
 	// will NOT be downloaded. 'emitResult' controls whether 'cover()/artistImage()' is emitted if
 	// a cover is found.
@@ -237,6 +244,7 @@ Q_SIGNALS:
 	void download(const Song& s);
 	void locate(const Song& s);
 	void load(const Song& song);
+	void preload(const Song& song);
 	void loaded(const Song& song, int s);
 	void cover(const Song& song, const QImage& img, const QString& file);
 	void coverUpdated(const Song& song, const QImage& img, const QString& file);
@@ -251,10 +259,14 @@ private Q_SLOTS:
 	void composerImageDownloaded(const Song& song, const QImage& img, const QString& file);
 
 private:
+	void setCacheSize(int mb);
+	QPixmap* cachedPixmap(const QString& key);
+	void cachePixmap(const QString& key, QPixmap* pix, int size);
+	void logCacheStats();
 	QPixmap* defaultPix(const Song& song, int size, int origSize);
 	void tryToLocate(const Song& song);
 	void tryToDownload(const Song& song);
-	void tryToLoad(const Song& song);
+	void tryToLoad(const Song& song, bool prefetch = false);
 	Image findImage(const Song& song, bool emitResult);
 	bool updateCache(const Song& song, const QImage& img, bool dummyEntriesOnly);
 	void gotAlbumCover(const Song& song, const QImage& img, const QString& fileName, bool emitResult = true);
@@ -267,6 +279,9 @@ private:
 	QList<Song> queue;
 	QSet<int> cacheSizes;
 	QCache<QString, QPixmap> cache;
+	int memHits;
+	int memMisses;
+	int memEvictions;
 	QMap<QString, QString> filenames;
 	CoverDownloader* downloader;
 	CoverLocator* locator;
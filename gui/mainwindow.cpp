@@ -147,6 +147,9 @@ static Qt::Key nextKey(Qt::Key& key)
 static const char* constRatingKey = "rating";
 static const char* constUserSettingProp = "user-setting-1";
 static const char* constUserSetting2Prop = "user-setting-2";
+// Whilst a stream is starting, MPD reports no time - so poll, backing off each time
+static const int constStreamStatusPoll = 250;
+static const int constMaxStreamStatusPolls = 4;
 
 MainWindow::MainWindow(QWidget* parent)
 	: QMainWindow(parent), prevPage(-1), lastState(MPDState_Inactive), lastSongId(-1), autoScrollPlayQueue(true), singlePane(false), shown(false), currentPage(nullptr)
@@ -2077,11 +2080,12 @@ void MainWindow::updateStatus(MPDStatus* const status)
 			if (!id.isValid() || id.toInt() != current.id) {
 				statusTimer->setProperty("id", current.id);
 				statusTimer->setProperty("count", 0);
-				statusTimer->start(250);
+				statusTimer->start(constStreamStatusPoll);
 			}
-			else if (statusTimer->property("count").toInt() < 12) {
-				statusTimer->setProperty("count", statusTimer->property("count").toInt() + 1);
-				statusTimer->start(250);
+			else if (statusTimer->property("count").toInt() < constMaxStreamStatusPolls) {
+				int count = statusTimer->property("count").toInt() + 1;
+				statusTimer->setProperty("count", count);
+				statusTimer->start(constStreamStatusPoll << count);
 			}
 		}
 		else if (!nowPlaying->isEnabled()) {
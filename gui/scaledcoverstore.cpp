@@ -0,0 +1,505 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2022 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "scaledcoverstore.h"
+#include "covers.h"
+#include "support/utils.h"
+#include <QAtomicInteger>
+#include <QDateTime>
+#include <QDir>
+#include <QMap>
+#include <QReadLocker>
+#include <QWriteLocker>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include <QDebug>
+#define DBUG \
+	if (Covers::debugEnabled()) qWarning() << "ScaledCoverStore" << __FUNCTION__
+
+static const quint32 constFileMagic = 0x43534332;// "CSC2"
+static const quint32 constRecordMagic = 0x52454331;// "REC1"
+static const quint32 constValid = 0x01;
+static const qint64 constFileHeaderSize = 2 * sizeof(quint32);
+static const qint64 constRecordHeaderSize = 5 * sizeof(quint32);
+static const qint64 constMinCompactSize = 1024 * 1024;
+static const QLatin1String constExtension(".dat");
+// Last-used time of a record is only re-written once it is this old, so that showing a cover does not always write
+static const quint32 constUsedResolution = 60 * 60;
+
+struct RecordHeader {
+	quint32 magic;
+	quint32 flags;
+	quint32 keyLength;
+	quint32 dataLength;
+	quint32 used;// Time, in seconds since the epoch, of last load/save
+};
+
+static inline quint32 now()
+{
+	return static_cast<quint32>(QDateTime::currentSecsSinceEpoch());
+}
+
+static inline qint64 recordLength(quint32 keyLength, quint32 dataLength)
+{
+	return (constRecordHeaderSize + keyLength + dataLength + 3) & ~qint64(3);
+}
+
+static QByteArray fileHeader()
+{
+	quint32 header[2] = {constFileMagic, 0};
+	return QByteArray(reinterpret_cast<const char*>(header), sizeof(header));
+}
+
+static QByteArray record(const QByteArray& key, const QByteArray& data, quint32 used)
+{
+	RecordHeader header = {constRecordMagic, constValid, static_cast<quint32>(key.length()), static_cast<quint32>(data.length()), used};
+	QByteArray rec(reinterpret_cast<const char*>(&header), sizeof(header));
+	rec.reserve(recordLength(header.keyLength, header.dataLength));
+	rec += key;
+	rec += data;
+	while (rec.length() % 4) {
+		rec += '\0';
+	}
+	return rec;
+}
+
+static QMutex storesMutex;
+static QMap<int, ScaledCoverStore*> stores;
+static QAtomicInt haveAllStores(0);
+static QAtomicInteger<qint64> maxTotalSize(0);
+static QAtomicInteger<qint64> totalValidBytes(0);// Of all open stores
+static QAtomicInt evictionCount(0);
+static QAtomicInt suspendCount(0);
+
+ScaledCoverStore* ScaledCoverStore::get(int size)
+{
+	QMutexLocker locker(&storesMutex);
+	QMap<int, ScaledCoverStore*>::iterator it = stores.find(size);
+	if (it == stores.end()) {
+		it = stores.insert(size, new ScaledCoverStore(size));
+	}
+	return it.value();
+}
+
+QList<int> ScaledCoverStore::existingSizes()
+{
+	QList<int> sizes;
+	QString dirName = Utils::cacheDir(Covers::constScaledCoverDir, false);
+	if (!dirName.isEmpty()) {
+		QStringList files = QDir(dirName).entryList(QStringList() << QString(QLatin1Char('*')) + constExtension, QDir::Files);
+		for (const QString& f : files) {
+			bool ok = false;
+			int size = f.left(f.length() - constExtension.size()).toInt(&ok);
+			if (ok && size > 0) {
+				sizes.append(size);
+			}
+		}
+	}
+	return sizes;
+}
+
+void ScaledCoverStore::closeAll()
+{
+	QMutexLocker locker(&storesMutex);
+	for (ScaledCoverStore* store : stores) {
+		store->close();
+	}
+	haveAllStores.storeRelaxed(0);
+}
+
+void ScaledCoverStore::suspend()
+{
+	// Set before closing, so that no store can be re-opened once closed
+	suspendCount.ref();
+	closeAll();
+}
+
+void ScaledCoverStore::resume()
+{
+	if (suspendCount.loadRelaxed() > 0) {
+		suspendCount.deref();
+	}
+}
+
+void ScaledCoverStore::setMaxTotalSize(qint64 sz)
+{
+	maxTotalSize.storeRelaxed(sz);
+}
+
+int ScaledCoverStore::evictions()
+{
+	return evictionCount.loadRelaxed();
+}
+
+void ScaledCoverStore::checkTotalSize()
+{
+	QMutexLocker locker(&storesMutex);
+	qint64 maxSize = maxTotalSize.loadRelaxed();
+	if (maxSize <= 0 || suspendCount.loadRelaxed() > 0) {
+		return;
+	}
+	// Sizes no longer displayed still take up space, so make sure these are counted too
+	if (!haveAllStores.loadRelaxed()) {
+		const QList<int> sizes = existingSizes();
+		for (int size : sizes) {
+			if (!stores.contains(size)) {
+				stores.insert(size, new ScaledCoverStore(size));
+			}
+		}
+		for (ScaledCoverStore* store : stores) {
+			QMutexLocker storeLocker(&store->mutex);
+			store->open();
+		}
+		haveAllStores.storeRelaxed(1);
+	}
+
+	qint64 total = totalValidBytes.loadRelaxed();
+	if (total <= maxSize) {
+		return;
+	}
+
+	struct Candidate {
+		ScaledCoverStore* store;
+		QString key;
+		Entry entry;
+	};
+	QList<Candidate> candidates;
+	for (ScaledCoverStore* store : stores) {
+		QMutexLocker storeLocker(&store->mutex);
+		for (QHash<QString, Entry>::ConstIterator it = store->index.constBegin(), end = store->index.constEnd(); it != end; ++it) {
+			candidates.append({store, it.key(), it.value()});
+		}
+	}
+	// Last-used times are only kept to within constUsedResolution, so for entries with the same time use the
+	// file position - as older covers will have been written first.
+	std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+		return a.entry.used < b.entry.used || (a.entry.used == b.entry.used && a.entry.offset < b.entry.offset);
+	});
+
+	// Remove down to 90% of the limit, so that we are not doing this on every save
+	qint64 target = (maxSize / 10) * 9;
+	int removed = 0;
+	for (const Candidate& c : candidates) {
+		if (total <= target) {
+			break;
+		}
+		QMutexLocker storeLocker(&c.store->mutex);
+		QHash<QString, Entry>::Iterator it = c.store->index.find(c.key);
+		if (it != c.store->index.end() && it.value().offset == c.entry.offset) {
+			total -= recordLength(it.value().keyLength, it.value().dataLength);
+			c.store->invalidate(it.value());
+			c.store->index.erase(it);
+			removed++;
+		}
+	}
+	evictionCount.fetchAndAddRelaxed(removed);
+
+	// Evicted records are only marked as invalid, so close any store that is now mostly invalid
+	// records - it will then be compacted when next opened.
+	for (ScaledCoverStore* store : stores) {
+		bool needsCompact = false;
+		{
+			QMutexLocker storeLocker(&store->mutex);
+			needsCompact = store->isOpen && store->file.size() > constMinCompactSize && store->invalidBytes > store->file.size() / 2;
+		}
+		if (needsCompact) {
+			store->close();
+		}
+	}
+	DBUG << "Removed" << removed << "covers, total now" << totalValidBytes.loadRelaxed() << "max" << maxSize;
+}
+
+ScaledCoverStore::ScaledCoverStore(int sz)
+	: size(sz), isOpen(false), invalidBytes(0), validBytes(0)
+{
+}
+
+ScaledCoverStore::~ScaledCoverStore()
+{
+	close();
+}
+
+QImage ScaledCoverStore::load(const QString& key, const char* format)
+{
+	// Hold the read lock whilst decoding, so that the mapping cannot be removed from under us.
+	QReadLocker readLocker(&mapLock);
+	const uchar* data = nullptr;
+	quint32 length = 0;
+	{
+		QMutexLocker locker(&mutex);
+		if (!open()) {
+			return QImage();
+		}
+		QHash<QString, Entry>::Iterator it = index.find(key);
+		if (it == index.end()) {
+			return QImage();
+		}
+		// Store when this was used in the file, so that eviction follows use across restarts
+		quint32 t = now();
+		if (t - it.value().used >= constUsedResolution && file.seek(it.value().offset + offsetof(RecordHeader, used))) {
+			file.write(reinterpret_cast<const char*>(&t), sizeof(quint32));
+			it.value().used = t;
+		}
+		length = it.value().dataLength;
+		data = mapped(it.value().offset + constRecordHeaderSize + it.value().keyLength, length);
+	}
+	return data ? QImage::fromData(QByteArray::fromRawData(reinterpret_cast<const char*>(data), length), format) : QImage();
+}
+
+bool ScaledCoverStore::save(const QString& key, const QByteArray& data)
+{
+	{
+		QMutexLocker locker(&mutex);
+		if (!open()) {
+			return false;
+		}
+		QHash<QString, Entry>::Iterator it = index.find(key);
+		if (it != index.end()) {
+			invalidate(it.value());
+			index.erase(it);
+		}
+
+		QByteArray utf8 = key.toUtf8();
+		quint32 t = now();
+		QByteArray rec = record(utf8, data, t);
+		qint64 end = file.size();
+		if (!file.seek(end) || file.write(rec) != rec.length()) {
+			DBUG << "Failed to write" << key << fileName;
+			file.resize(end);
+			return false;
+		}
+		index.insert(key, Entry(end, utf8.length(), data.length(), t));
+		addValidBytes(rec.length());
+	}
+	// Must be called without our mutex held, as checkTotalSize() locks storesMutex and then each store
+	qint64 maxSize = maxTotalSize.loadRelaxed();
+	if (maxSize > 0 && (!haveAllStores.loadRelaxed() || totalValidBytes.loadRelaxed() > maxSize)) {
+		checkTotalSize();
+	}
+	return true;
+}
+
+void ScaledCoverStore::remove(const QString& key)
+{
+	QMutexLocker locker(&mutex);
+	if (!open()) {
+		return;
+	}
+	QHash<QString, Entry>::Iterator it = index.find(key);
+	if (it != index.end()) {
+		invalidate(it.value());
+		index.erase(it);
+	}
+}
+
+void ScaledCoverStore::close()
+{
+	QWriteLocker writeLocker(&mapLock);
+	QMutexLocker locker(&mutex);
+	for (const Segment& s : segments) {
+		file.unmap(s.data);
+	}
+	segments.clear();
+	index.clear();
+	invalidBytes = 0;
+	addValidBytes(-validBytes);
+	file.close();
+	isOpen = false;
+}
+
+bool ScaledCoverStore::open()
+{
+	if (isOpen) {
+		return true;
+	}
+	if (suspendCount.loadRelaxed() > 0) {
+		return false;
+	}
+
+	QString dirName = Utils::cacheDir(Covers::constScaledCoverDir, true);
+	if (dirName.isEmpty()) {
+		return false;
+	}
+	fileName = dirName + QString::number(size) + constExtension;
+	file.setFileName(fileName);
+	if (!file.open(QIODevice::ReadWrite | QIODevice::Unbuffered)) {
+		DBUG << "Failed to open" << fileName;
+		return false;
+	}
+
+	qint64 fileSize = file.size();
+	uchar* data = fileSize >= constFileHeaderSize ? file.map(0, fileSize) : nullptr;
+	if (fileSize >= constFileHeaderSize && !data) {
+		// Could not read the file - fail, rather than throw away its covers
+		DBUG << "Failed to map" << fileName;
+		file.close();
+		return false;
+	}
+	quint32 magic = 0;
+	if (data) {
+		memcpy(&magic, data, sizeof(quint32));
+	}
+	// New (or truncated) file, or not one of ours
+	if (constFileMagic != magic) {
+		if (data) {
+			file.unmap(data);
+		}
+		file.resize(0);
+		QByteArray header = fileHeader();
+		if (file.write(header) != header.length()) {
+			file.close();
+			return false;
+		}
+		isOpen = true;
+		return true;
+	}
+
+	qint64 offset = constFileHeaderSize;
+	while (offset + constRecordHeaderSize <= fileSize) {
+		RecordHeader header;
+		memcpy(&header, data + offset, sizeof(RecordHeader));
+		qint64 len = recordLength(header.keyLength, header.dataLength);
+		if (constRecordMagic != header.magic || offset + len > fileSize) {
+			break;
+		}
+		if (header.flags & constValid) {
+			QString key = QString::fromUtf8(reinterpret_cast<const char*>(data + offset + constRecordHeaderSize), header.keyLength);
+			QHash<QString, Entry>::Iterator it = index.find(key);
+			if (it != index.end()) {
+				qint64 prevLen = recordLength(it.value().keyLength, it.value().dataLength);
+				invalidBytes += prevLen;
+				addValidBytes(-prevLen);
+			}
+			index.insert(key, Entry(offset, header.keyLength, header.dataLength, header.used));
+			addValidBytes(len);
+		}
+		else {
+			invalidBytes += len;
+		}
+		offset += len;
+	}
+
+	if (offset < fileSize) {
+		// Partially written, or corrupt, record - drop it and everything after it
+		DBUG << "Truncating" << fileName << "from" << fileSize << "to" << offset;
+		file.unmap(data);
+		file.resize(offset);
+		fileSize = offset;
+	}
+	else {
+		segments.append(Segment(0, fileSize, data));
+	}
+	isOpen = true;
+
+	if (fileSize > constMinCompactSize && invalidBytes > fileSize / 2) {
+		compact();
+	}
+	DBUG << fileName << index.count() << "entries," << invalidBytes << "of" << file.size() << "bytes invalid";
+	return true;
+}
+
+bool ScaledCoverStore::compact()
+{
+	DBUG << fileName;
+	QString tmpName = fileName + QLatin1String(".tmp");
+	QFile tmp(tmpName);
+	if (!tmp.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		return false;
+	}
+
+	QHash<QString, Entry> newIndex;
+	qint64 offset = constFileHeaderSize;
+	bool ok = tmp.write(fileHeader()) == constFileHeaderSize;
+	for (QHash<QString, Entry>::ConstIterator it = index.constBegin(), end = index.constEnd(); it != end && ok; ++it) {
+		qint64 len = recordLength(it.value().keyLength, it.value().dataLength);
+		const uchar* rec = mapped(it.value().offset, len);
+		ok = rec && tmp.write(reinterpret_cast<const char*>(rec), len) == len;
+		newIndex.insert(it.key(), Entry(offset, it.value().keyLength, it.value().dataLength, it.value().used));
+		offset += len;
+	}
+	tmp.close();
+
+	if (!ok) {
+		QFile::remove(tmpName);
+		return false;
+	}
+
+	// Only called from open(), so no-one else can be using the mappings.
+	for (const Segment& s : segments) {
+		file.unmap(s.data);
+	}
+	segments.clear();
+	file.close();
+	QFile::remove(fileName);
+	if (!QFile::rename(tmpName, fileName) || !file.open(QIODevice::ReadWrite | QIODevice::Unbuffered)) {
+		index.clear();
+		addValidBytes(-validBytes);
+		isOpen = false;
+		return false;
+	}
+	index = newIndex;
+	invalidBytes = 0;
+	return true;
+}
+
+const uchar* ScaledCoverStore::mapped(qint64 offset, qint64 length)
+{
+	for (const Segment& s : segments) {
+		if (offset >= s.offset && offset + length <= s.offset + s.size) {
+			return s.data + (offset - s.offset);
+		}
+	}
+
+	// Record has been appended since the file was mapped, so map everything after the
+	// last segment. Existing segments are not touched, as they may be in use.
+	qint64 start = segments.isEmpty() ? 0 : (segments.last().offset + segments.last().size);
+	qint64 end = file.size();
+	if (offset < start || offset + length > end) {
+		return nullptr;
+	}
+	uchar* data = file.map(start, end - start);
+	if (!data) {
+		return nullptr;
+	}
+	segments.append(Segment(start, end - start, data));
+	return data + (offset - start);
+}
+
+void ScaledCoverStore::invalidate(const Entry& entry)
+{
+	quint32 flags = 0;
+	if (file.seek(entry.offset + sizeof(quint32))) {
+		file.write(reinterpret_cast<const char*>(&flags), sizeof(quint32));
+	}
+	qint64 len = recordLength(entry.keyLength, entry.dataLength);
+	invalidBytes += len;
+	addValidBytes(-len);
+}
+
+void ScaledCoverStore::addValidBytes(qint64 len)
+{
+	validBytes += len;
+	totalValidBytes.fetchAndAddRelaxed(len);
+}
@@ -0,0 +1,105 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2022 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef SCALED_COVER_STORE_H
+#define SCALED_COVER_STORE_H
+
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QString>
+
+/*
+ * Stores all of the scaled covers of a given size in a single file, instead of one file per cover.
+ *
+ * The file consists of a header followed by a list of records, each of which contains the cover's
+ * key and its encoded image. The file is memory mapped, and images are decoded directly from the
+ * mapping. New covers are appended, and replaced or removed covers are marked as invalid in place.
+ * The file is compacted when it is opened, if more than half of it is invalid records.
+ *
+ * The total size of all stores may be limited, in which case the least recently used covers
+ * (of any size) are removed once the limit is exceeded. Each record holds the time it was last
+ * used, so this order is kept across restarts.
+ */
+class ScaledCoverStore {
+public:
+	static ScaledCoverStore* get(int size);
+	static QList<int> existingSizes();
+	static void closeAll();
+	// Close all stores, and keep them closed until resume() - whilst their files are deleted
+	static void suspend();
+	static void resume();
+	static void setMaxTotalSize(qint64 sz);
+	static int evictions();
+
+	ScaledCoverStore(int sz);
+	~ScaledCoverStore();
+
+	QImage load(const QString& key, const char* format);
+	bool save(const QString& key, const QByteArray& data);
+	void remove(const QString& key);
+	void close();
+
+private:
+	struct Entry {
+		Entry(qint64 o = 0, quint32 k = 0, quint32 l = 0, quint32 u = 0)
+			: offset(o), keyLength(k), dataLength(l), used(u) {}
+		qint64 offset;// Offset of record header
+		quint32 keyLength;
+		quint32 dataLength;
+		quint32 used;// Time of last load/save, as stored in the record, used to find least recently used entries
+	};
+
+	struct Segment {
+		Segment(qint64 o = 0, qint64 s = 0, uchar* d = nullptr)
+			: offset(o), size(s), data(d) {}
+		qint64 offset;
+		qint64 size;
+		uchar* data;
+	};
+
+	static void checkTotalSize();
+
+	bool open();
+	bool compact();
+	const uchar* mapped(qint64 offset, qint64 length);
+	void invalidate(const Entry& entry);
+	void addValidBytes(qint64 len);
+
+private:
+	int size;
+	QString fileName;
+	QFile file;
+	bool isOpen;
+	qint64 invalidBytes;
+	qint64 validBytes;
+	QHash<QString, Entry> index;
+	QList<Segment> segments;
+	QMutex mutex;         // Protects file, index, and segments
+	QReadWriteLock mapLock;// Held for reading whilst decoding from a mapping, and for writing when unmapping
+};
+
+#endif
@@ -31,6 +31,7 @@
 #include "widgets/itemview.h"
 #include <QDir>
 #include <QFile>
+#include <QThread>
 #include <qglobal.h>
 
 GLOBAL_STATIC(Settings, instance)
@@ -291,6 +292,18 @@ bool Settings::storeLyricsInMpdDir()
 	return cfg.get("storeLyricsInMpdDir", false);
 }
 
+// Size, in MB, of the in-memory scaled cover cache. 0 => calculate from screen size
+int Settings::coverMemoryCacheSize()
+{
+	return cfg.get("coverMemoryCacheSize", 0, 0, 2047);
+}
+
+// Size, in MB, of all of the on-disk scaled cover stores. 0 => no limit
+int Settings::coverDiskCacheSize()
+{
+	return cfg.get("coverDiskCacheSize", 0, 0, 16384);
+}
+
 QString Settings::coverFilename()
 {
 	QString name = cfg.get("coverFilename", QString());
@@ -441,6 +454,16 @@ bool Settings::showDeleteAction()
 {
 	return cfg.get("showDeleteAction", false);
 }
+
+int Settings::deviceTranscodeJobs()
+{
+	return cfg.get("deviceTranscodeJobs", QThread::idealThreadCount(), 1, 64);
+}
+
+int Settings::deviceWriteJobs()
+{
+	return cfg.get("deviceWriteJobs", 1, 1, 8);
+}
 #endif
 
 int Settings::version()
@@ -645,6 +668,17 @@ int Settings::podcastAutoDownloadLimit()
 	return cfg.get("podcastAutoDownloadLimit", 0, 0, 1000);
 }
 
+int Settings::podcastMaxDownloads()
+{
+	return cfg.get("podcastMaxDownloads", 2, 1, 10);
+}
+
+// Combined rate of all podcast downloads in KB/s, 0 for no limit
+int Settings::podcastDownloadRate()
+{
+	return cfg.get("podcastDownloadRate", 0, 0, 1000000);
+}
+
 int Settings::volumeStep()
 {
 	return cfg.get("volumeStep", 5, 1, 20);
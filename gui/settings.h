@@ -61,6 +61,8 @@ public:
 	bool storeCoversInMpdDir();
 	bool storeLyricsInMpdDir();
 	QString coverFilename();
+	int coverMemoryCacheSize();
+	int coverDiskCacheSize();
 	int sidebar();
 	QSet<QString> composerGenres();
 	QSet<QString> singleTracksFolders();
@@ -85,6 +87,8 @@ public:
 #ifdef ENABLE_DEVICES_SUPPORT
 	bool overwriteSongs();
 	bool showDeleteAction();
+	int deviceTranscodeJobs();
+	int deviceWriteJobs();
 #endif
 	int version();
 	int stopFadeDuration();
@@ -131,6 +135,8 @@ public:
 	QDateTime lastRssUpdate();
 	QString podcastDownloadPath();
 	int podcastAutoDownloadLimit();
+	int podcastMaxDownloads();
+	int podcastDownloadRate();
 	int volumeStep();
 	StartupState startupState();
 	QString searchCategory();
@@ -42,7 +42,7 @@ GLOBAL_STATIC(MpdLibraryModel, instance)
 	if (Covers::verboseDebugEnabled()) qWarning() << metaObject()->className() << QThread::currentThread()->objectName() << __FUNCTION__
 
 MpdLibraryModel::MpdLibraryModel()
-	: SqlLibraryModel(new MpdLibraryDb(nullptr), nullptr), showArtistImages(false)
+	: SqlLibraryModel(new MpdLibraryDb(nullptr), nullptr), showArtistImages(false), listingTotal(0), listingCurrent(0), listingRowId(0)
 {
 	connect(Covers::self(), SIGNAL(cover(Song, QImage, QString)), this, SLOT(cover(Song, QImage, QString)));
 	connect(Covers::self(), SIGNAL(coverUpdated(Song, QImage, QString)), this, SLOT(coverUpdated(Song, QImage, QString)));
@@ -178,6 +178,7 @@ void MpdLibraryModel::listSongs()
 {
 	listingTotal = db->trackCount();
 	listingCurrent = 0;
+	listingRowId = 0;
 	if (listingTotal > 0) {
 		QTimer::singleShot(0, this, SLOT(listNextChunk()));
 	}
@@ -199,16 +200,18 @@ void MpdLibraryModel::listNextChunk()
 		return;
 	}
 
-	QList<Song> songs = db->getTracks(listingCurrent, constMaxSongsInList);
+	QList<Song> songs = db->getTracks(listingRowId, constMaxSongsInList, listingRowId);
+	bool finished = songs.count() < constMaxSongsInList;
 	listingCurrent += songs.count();
-	emit songListing(songs, (listingCurrent * 100.0) / (listingTotal * 1.0));
-	if (songs.count() > 0) {
-		if (listingCurrent == listingTotal) {
-			emit songListing(QList<Song>(), 100.0);
-		}
-		else {
-			QTimer::singleShot(0, this, SLOT(listNextChunk()));
-		}
+	if (!songs.isEmpty()) {
+		emit songListing(songs, qMin((listingCurrent * 100.0) / (listingTotal * 1.0), finished ? 100.0 : 99.0));
+	}
+	if (finished) {
+		// The DB may have changed since the count was taken, so stop on the first short page rather than the count
+		emit songListing(QList<Song>(), 100.0);
+	}
+	else {
+		QTimer::singleShot(0, this, SLOT(listNextChunk()));
 	}
 }
 
@@ -52,6 +52,7 @@ private:
 	bool showArtistImages;
 	int listingTotal;
 	int listingCurrent;
+	int listingRowId;
 };
 
 #endif
@@ -1042,13 +1042,14 @@ qint32 PlayQueueModel::getSongId(const QString& file) const
 
 qint32 PlayQueueModel::getRowById(qint32 id) const
 {
-	for (int i = 0; i < songs.size(); i++) {
-		if (songs.at(i).id == id) {
-			return i;
+	if (rowsById.isEmpty() && !songs.isEmpty()) {
+		rowsById.reserve(songs.size());
+		// Iterate backwards, so that the first row wins should MPD ever report a duplicate id
+		for (int i = songs.size() - 1; i >= 0; --i) {
+			rowsById.insert(songs.at(i).id, i);
 		}
 	}
-
-	return -1;
+	return rowsById.value(id, -1);
 }
 
 Song PlayQueueModel::getSongByRow(const qint32 row) const
@@ -1058,12 +1059,7 @@ Song PlayQueueModel::getSongByRow(const qint32 row) const
 
 Song PlayQueueModel::getSongById(qint32 id) const
 {
-	for (const Song& s : songs) {
-		if (s.id == id) {
-			return s;
-		}
-	}
-	return Song();
+	return getSongByRow(getRowById(id));
 }
 
 void PlayQueueModel::updateCurrentSong(quint32 id)
@@ -1100,6 +1096,7 @@ void PlayQueueModel::clear()
 	beginResetModel();
 	songs.clear();
 	ids.clear();
+	rowsById.clear();
 	currentSongId = -1;
 	currentSongRowNum = 0;
 	stopAfterTrackId = -1;
@@ -1156,6 +1153,7 @@ void PlayQueueModel::update(const QList<Song>& songList, bool isComplete)
 		beginResetModel();
 		songs = songList;
 		ids = newIds;
+		rowsById.clear();
 		endResetModel();
 		if (songList.isEmpty()) {
 			stopAfterTrackId = -1;
@@ -1164,13 +1162,21 @@ void PlayQueueModel::update(const QList<Song>& songList, bool isComplete)
 	else {
 		time = 0;
 
+		// Remove from the end, so that rows are not affected by earlier removals, and
+		// remove contiguous rows together.
 		QSet<qint32> removed = ids - newIds;
-		for (qint32 id : removed) {
-			qint32 row = getRowById(id);
-			if (row != -1) {
-				beginRemoveRows(QModelIndex(), row, row);
-				songs.removeAt(row);
-				endRemoveRows();
+		if (!removed.isEmpty()) {
+			for (qint32 row = songs.count() - 1; row >= 0; --row) {
+				if (removed.contains(songs.at(row).id)) {
+					qint32 last = row;
+					while (row > 0 && removed.contains(songs.at(row - 1).id)) {
+						--row;
+					}
+					beginRemoveRows(QModelIndex(), row, last);
+					songs.remove(row, (last - row) + 1);
+					rowsById.clear();
+					endRemoveRows();
+				}
 			}
 		}
 		for (qint32 i = 0; i < songList.count(); ++i) {
@@ -1180,10 +1186,20 @@ void PlayQueueModel::update(const QList<Song>& songList, bool isComplete)
 			bool isEmpty = s.isEmpty();
 
 			if (newSong || s.id != currentSongAtPos.id) {
-				qint32 existingPos = newSong ? -1 : getRowById(s.id);
+				// Rows before i are now in their final order, so an existing song can only be after i. Scanning
+				// for it costs no more than the move itself.
+				qint32 existingPos = -1;
+				if (!newSong && ids.contains(s.id)) {
+					for (qint32 row = i + 1; row < songs.count() && -1 == existingPos; ++row) {
+						if (songs.at(row).id == s.id) {
+							existingPos = row;
+						}
+					}
+				}
 				if (-1 == existingPos) {
 					beginInsertRows(QModelIndex(), i, i);
 					songs.insert(i, s);
+					rowsById.clear();
 					endInsertRows();
 				}
 				else {
@@ -1193,6 +1209,7 @@ void PlayQueueModel::update(const QList<Song>& songList, bool isComplete)
 					s.rating = old.rating;
 					s.time = old.time;
 					songs.insert(i, isEmpty ? old : s);
+					rowsById.clear();
 					endMoveRows();
 				}
 			}
@@ -1220,6 +1237,7 @@ void PlayQueueModel::update(const QList<Song>& songList, bool isComplete)
 			for (int i = 0; i < toBeRemoved; ++i) {
 				songs.takeLast();
 			}
+			rowsById.clear();
 			endRemoveRows();
 		}
 
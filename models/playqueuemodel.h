@@ -32,6 +32,7 @@
 #include "mpd-interface/mpdstatus.h"
 #include "mpd-interface/song.h"
 #include <QAbstractItemModel>
+#include <QHash>
 #include <QList>
 #include <QMap>
 #include <QSet>
@@ -182,6 +183,7 @@ Q_SIGNALS:
 private:
 	QList<Song> songs;
 	QSet<qint32> ids;
+	mutable QHash<qint32, qint32> rowsById;// Built on demand, cleared whenever rows are added, moved, or removed
 	qint32 currentSongId;
 	mutable qint32 currentSongRowNum;
 	quint32 time;
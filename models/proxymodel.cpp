@@ -29,23 +29,78 @@
 #include <QMimeData>
 #include <QString>
 
+// Replace characters with decompositions (e.g. umlauts) with their base character. Returns an empty string if nothing changed.
+static QString basicString(const QString& str)
+{
+	QString basic;
+	for (int i = 0; i < str.size(); ++i) {
+		if (str.at(i).decompositionTag() != QChar::NoDecomposition) {
+			if (basic.isEmpty()) {
+				basic = str;
+			}
+			basic[i] = str.at(i).decomposition().at(0);
+		}
+	}
+	return basic;
+}
+
+// Strings are joined with a character that cannot be in a filter term, so that a term cannot match across two strings.
+static inline void addToKey(QString& key, const QString& str)
+{
+	if (!key.isEmpty()) {
+		key += QLatin1Char('\n');
+	}
+	key += str.simplified();
+}
+
+static inline bool isSame(const QString& a, const QString& b)
+{
+	return a.isSharedWith(b) || (a.isEmpty() && b.isEmpty());
+}
+
 bool ProxyModel::matchesFilter(const Song& s) const
 {
 	if (yearFrom > 0 && yearTo > 0 && (s.year < yearFrom || s.year > yearTo)) {
 		return false;
 	}
+	if (filterStrings.isEmpty()) {
+		return true;
+	}
 
-	QStringList strings;
+	SearchKey& sk = searchKeys[&s];
+	QString composer = s.composer();
+	if (sk.key.isEmpty() || !isSame(sk.artist, s.artist) || !isSame(sk.albumartist, s.albumartist) || !isSame(sk.composer, composer) || !isSame(sk.title, s.title) || !isSame(sk.album, s.album)) {
+		QString key;
+		addToKey(key, s.albumArtist());
+		if (!s.albumartist.isEmpty() && s.albumartist != s.artist) {
+			addToKey(key, s.artist);
+		}
+		if (!composer.isEmpty() && composer != s.artist && composer != s.albumartist) {
+			addToKey(key, composer);
+		}
+		addToKey(key, s.title);
+		addToKey(key, s.album);
 
-	strings << s.albumArtist();
-	if (!s.albumartist.isEmpty() && s.albumartist != s.artist) {
-		strings << s.artist;
+		sk.artist = s.artist;
+		sk.albumartist = s.albumartist;
+		sk.composer = composer;
+		sk.title = s.title;
+		sk.album = s.album;
+		sk.basicKey = basicString(key).toCaseFolded();
+		sk.key = key.toCaseFolded();
+		sk.rejectedBy = 0;
 	}
-	if (!s.composer().isEmpty() && s.composer() != s.artist && s.composer() != s.albumartist) {
-		strings << s.composer();
+	usedSearchKeys++;
+
+	// If the song did not match a previous filter, and the filter has only been added to since, then it cannot match now.
+	if (0 != sk.rejectedBy && sk.rejectedBy >= narrowedFrom) {
+		return false;
 	}
-	strings << s.title << s.album;
-	return matchesFilter(strings);
+	if (matchesKey(sk.key, sk.basicKey)) {
+		return true;
+	}
+	sk.rejectedBy = filterGeneration;
+	return false;
 }
 
 bool ProxyModel::matchesFilter(const QStringList& strings) const
@@ -54,40 +109,25 @@ bool ProxyModel::matchesFilter(const QStringList& strings) const
 		return true;
 	}
 
+	QString key;
+	for (const QString& str : strings) {
+		addToKey(key, str);
+	}
+	return matchesKey(key.toCaseFolded(), basicString(key).toCaseFolded());
+}
+
+bool ProxyModel::matchesKey(const QString& key, const QString& basicKey) const
+{
 	uint ums = unmatchedStrings;
-	int numStrings = filterStrings.count();
+	int numStrings = foldedFilterStrings.count();
 
-	for (const QString& str : strings) {
-		QString candidate = str.simplified();
-		QString basic;
-		bool useBasic = false;
-
-		for (int i = 0; i < numStrings; ++i) {
-			const QString& f = filterStrings.at(i);
-			// Try to match string as entered by user...
-			if (candidate.contains(f, Qt::CaseInsensitive)) {
-				ums &= ~(1 << i);
-				if (0 == ums) {
-					return true;
-				}
-			}
-			else {
-				// Try converting string to basic - e.g. remove umlauts, etc...
-				if (basic.isEmpty()) {
-					basic = candidate;
-					for (int i = 0; i < basic.size(); ++i) {
-						if (basic.at(i).decompositionTag() != QChar::NoDecomposition) {
-							basic[i] = basic[i].decomposition().at(0);
-							useBasic = true;
-						}
-					}
-				}
-				if (useBasic && basic.contains(f, Qt::CaseInsensitive)) {
-					ums &= ~(1 << i);
-					if (0 == ums) {
-						return true;
-					}
-				}
+	// Both key and filter strings are already case-folded, so can use a case-sensitive search
+	for (int i = 0; i < numStrings; ++i) {
+		const QString& f = foldedFilterStrings.at(i);
+		if (key.contains(f) || (!basicKey.isEmpty() && basicKey.contains(f))) {
+			ums &= ~(1 << i);
+			if (0 == ums) {
+				return true;
 			}
 		}
 	}
@@ -109,7 +149,19 @@ bool ProxyModel::update(const QString& txt)
 	}
 
 	bool wasEmpty = isEmpty();
+	// If text has only been added to, then only songs that matched the previous filter need to be checked
+	bool narrowed = !origFilterText.isEmpty() && text.startsWith(origFilterText) && !text.contains('#');
+	filterGeneration++;
+	if (!narrowed) {
+		narrowedFrom = filterGeneration;
+		// Remove keys of songs that are no longer in the model
+		if (searchKeys.count() > (usedSearchKeys * 2) + 1000) {
+			searchKeys.clear();
+		}
+	}
+	usedSearchKeys = 0;
 	filterStrings.clear();
+	foldedFilterStrings.clear();
 	yearFrom = yearTo = 0;
 
 	QStringList parts = text.split(' ', CANTATA_SKIP_EMPTY, Qt::CaseInsensitive);
@@ -135,6 +187,7 @@ bool ProxyModel::update(const QString& txt)
 			}
 		}
 		filterStrings.append(str);
+		foldedFilterStrings.append(str.toCaseFolded());
 	}
 
 	unmatchedStrings = 0;
@@ -26,6 +26,7 @@
 
 #include "config.h"
 #include "mpd-interface/song.h"
+#include <QHash>
 #include <QSortFilterProxyModel>
 #include <QStringList>
 
@@ -33,7 +34,7 @@ class QMimeData;
 
 class ProxyModel : public QSortFilterProxyModel {
 public:
-	ProxyModel(QObject* parent) : QSortFilterProxyModel(parent), isSorted(false), filterEnabled(false), filter(nullptr) {}
+	ProxyModel(QObject* parent) : QSortFilterProxyModel(parent), isSorted(false), filterEnabled(false), filter(nullptr), filterGeneration(1), narrowedFrom(1), usedSearchKeys(0) {}
 	~ProxyModel() override {}
 
 	bool update(const QString& text);
@@ -62,6 +63,21 @@ protected:
 	bool matchesFilter(const QStringList& strings) const;
 
 private:
+	// Case-folded, and simplified, song strings - so that these are only calculated once, and not for each row on each filter change.
+	struct SearchKey {
+		SearchKey() : rejectedBy(0) {}
+		// Copies of the song's strings, used to detect if the song has changed
+		QString artist;
+		QString albumartist;
+		QString composer;
+		QString title;
+		QString album;
+		QString key;
+		QString basicKey;  // key with umlauts, etc, removed - empty if same as key
+		quint32 rejectedBy;// Filter generation that did not match this song
+	};
+
+	bool matchesKey(const QString& key, const QString& basicKey) const;
 	QModelIndexList leaves(const QModelIndex& idx) const;
 
 protected:
@@ -70,10 +86,17 @@ protected:
 	QModelIndex rootIndex;
 	QString origFilterText;
 	QStringList filterStrings;
+	QStringList foldedFilterStrings;
 	uint unmatchedStrings;
 	const void* filter;
 	quint16 yearFrom;
 	quint16 yearTo;
+
+private:
+	quint32 filterGeneration;
+	quint32 narrowedFrom;// Filter changes since this generation have only added to the filter text
+	mutable int usedSearchKeys;
+	mutable QHash<const Song*, SearchKey> searchKeys;
 };
 
 #endif
@@ -69,12 +69,14 @@ void MPDConnection::enableDebug()
 static const int constSocketCommsTimeout = 2000;
 static const int constMaxReadAttempts = 4;
 static const int constMaxFilesPerAddCommand = 2000;
-static const int constConnTimer = 5000;
+static const int constConnTimer = 30000;// Keep-alive, MPD's default connection_timeout is 60s
+static const int constLibraryChunkSize = 200;
 
 static const QByteArray constOkValue("OK");
 static const QByteArray constOkMpdValue("OK MPD");
 static const QByteArray constOkNlValue("OK\n");
 static const QByteArray constAckValue("ACK");
+static const QByteArray constDirectoryKey("directory: ");
 static const QByteArray constIdleChangedKey("changed: ");
 static const QByteArray constIdleDbValue("database");
 static const QByteArray constIdleUpdateValue("update");
@@ -126,7 +128,18 @@ QByteArray MPDConnection::encodeName(const QString& name)
 	return '\"' + name.toUtf8().replace("\\", "\\\\").replace("\"", "\\\"") + '\"';
 }
 
-static QByteArray readFromSocket(MpdSocket& socket, int timeout = constSocketCommsTimeout)
+// Command lists may fail part way through, in which case the ACK follows the output of the earlier commands
+static bool endsWithAck(const QByteArray& data)
+{
+	if (!data.endsWith('\n')) {
+		return false;
+	}
+	int lastLine = data.lastIndexOf('\n', data.length() - 2) + 1;
+	return lastLine > 0 && 0 == qstrncmp(data.constData() + lastLine, constAckValue.constData(), constAckValue.length());
+}
+
+// If reader is set, then songs are parsed from the response as each chunk is received.
+static QByteArray readFromSocket(MpdSocket& socket, int timeout = constSocketCommsTimeout, MPDParseUtils::SongReader* reader = nullptr)
 {
 	QByteArray data;
 	int attempt = 0;
@@ -145,8 +158,11 @@ static QByteArray readFromSocket(MpdSocket& socket, int timeout = constSocketCom
 		}
 
 		data.append(socket.readAll());
+		if (reader) {
+			reader->parse(data);
+		}
 
-		if (data.endsWith(constOkNlValue) || data.startsWith(constOkValue) || data.startsWith(constAckValue)) {
+		if (data.endsWith(constOkNlValue) || data.startsWith(constOkValue) || data.startsWith(constAckValue) || endsWithAck(data)) {
 			break;
 		}
 	}
@@ -155,9 +171,9 @@ static QByteArray readFromSocket(MpdSocket& socket, int timeout = constSocketCom
 	return data;
 }
 
-static MPDConnection::Response readReply(MpdSocket& socket, int timeout = constSocketCommsTimeout)
+static MPDConnection::Response readReply(MpdSocket& socket, int timeout = constSocketCommsTimeout, MPDParseUtils::SongReader* reader = nullptr)
 {
-	QByteArray data = readFromSocket(socket, timeout);
+	QByteArray data = readFromSocket(socket, timeout, reader);
 	return MPDConnection::Response(data.endsWith(constOkNlValue), data);
 }
 
@@ -252,7 +268,7 @@ void MPDConnectionDetails::setDirReadable()
 }
 
 MPDConnection::MPDConnection()
-	: isInitialConnect(true), thread(nullptr), ver(0), canUseStickers(false), sock(this), idleSocket(this), lastStatusPlayQueueVersion(0), lastUpdatePlayQueueVersion(0), state(State_Blank), isListingMusic(false), reconnectTimer(nullptr), reconnectStart(0), stopAfterCurrent(false), currentSongId(-1), songPos(0), unmuteVol(-1), isUpdatingDb(false), volumeFade(nullptr), fadeDuration(0), restoreVolume(-1)
+	: isInitialConnect(true), thread(nullptr), ver(0), canUseStickers(false), ratingsLoaded(false), sock(this), idleSocket(this), librarySocket(this), lastStatusPlayQueueVersion(0), lastUpdatePlayQueueVersion(0), state(State_Blank), isListingMusic(false), reconnectTimer(nullptr), reconnectStart(0), stopAfterCurrent(false), currentSongId(-1), songPos(0), unmuteVol(-1), isUpdatingDb(false), volumeFade(nullptr), fadeDuration(0), restoreVolume(-1)
 {
 	qRegisterMetaType<time_t>("time_t");
 	qRegisterMetaType<Song>("Song");
@@ -273,6 +289,7 @@ MPDConnection::MPDConnection()
 	qRegisterMetaType<MPDStatusValues>("MPDStatusValues");
 	qRegisterMetaType<MPDConnectionDetails>("MPDConnectionDetails");
 	qRegisterMetaType<QMap<qint32, quint8>>("QMap<qint32, quint8>");
+	qRegisterMetaType<QMap<QString, quint8>>("QMap<QString, quint8>");
 	qRegisterMetaType<Stream>("Stream");
 	qRegisterMetaType<QList<Stream>>("QList<Stream>");
 #if (defined Q_OS_LINUX && defined QT_QTDBUS_FOUND) || (defined Q_OS_MAC && defined IOKIT_FOUND)
@@ -302,7 +319,7 @@ void MPDConnection::start()
 		connTimer->setSingleShot(false);
 		moveToThread(thread);
 		connect(thread, SIGNAL(finished()), connTimer, SLOT(stop()));
-		connect(connTimer, SIGNAL(timeout()), SLOT(getStatus()));
+		connect(connTimer, SIGNAL(timeout()), SLOT(keepAlive()));
 		thread->start();
 	}
 }
@@ -353,9 +370,11 @@ MPDConnection::ConnectionReturn MPDConnection::connectToMPD(MpdSocket& socket, b
 				DBUG << (void*)(&socket) << "Received identification string";
 			}
 
-			lastUpdatePlayQueueVersion = lastStatusPlayQueueVersion = 0;
-			playQueueIds.clear();
-			emit cantataStreams(QList<Song>(), false);
+			if (&socket != &librarySocket) {
+				lastUpdatePlayQueueVersion = lastStatusPlayQueueVersion = 0;
+				playQueueIds.clear();
+				emit cantataStreams(QList<Song>(), false);
+			}
 			int min, maj, patch;
 			if (3 == sscanf(&(recvdata.constData()[7]), "%3d.%3d.%3d", &maj, &min, &patch)) {
 				long v = ((maj & 0xFF) << 16) + ((min & 0xFF) << 8) + (patch & 0xFF);
@@ -487,6 +506,11 @@ void MPDConnection::disconnectFromMPD()
 	}
 	sock.close();
 	idleSocket.close();
+	librarySocket.close();
+	pipelinedCommands.clear();
+	pipelinedReplies.clear();
+	ratingsLoaded = false;
+	ratings.clear();
 	state = State_Disconnected;
 	ver = 0;
 	playQueueIds.clear();
@@ -659,7 +683,7 @@ void MPDConnection::setDetails(const MPDConnectionDetails& d)
 //    }
 //}
 
-MPDConnection::Response MPDConnection::sendCommand(const QByteArray& command, bool emitErrors, bool retry)
+MPDConnection::Response MPDConnection::sendCommand(const QByteArray& command, bool emitErrors, bool retry, MPDParseUtils::SongReader* reader)
 {
 	connTimer->stop();
 	static bool reconnected = false;// If we reconnect, and send playlistinfo - dont want that call causing reconnects, and recursion!
@@ -683,6 +707,9 @@ MPDConnection::Response MPDConnection::sendCommand(const QByteArray& command, bo
 			return Response(false);
 		}
 		else {
+			// Any pipelined commands were lost with the old connection
+			pipelinedCommands.clear();
+			pipelinedReplies.clear();
 			// Refresh playqueue...
 			reconnected = true;
 			listPartitions();
@@ -692,8 +719,15 @@ MPDConnection::Response MPDConnection::sendCommand(const QByteArray& command, bo
 		}
 	}
 
+	if (reader) {
+		reader->reset();
+	}
+
 	Response response;
-	if (-1 == sock.write(command + '\n')) {
+	if (takePipelinedReply(command, response, reader)) {
+		DBUG << "Used pipelined reply";
+	}
+	else if (-1 == sock.write(command + '\n')) {
 		DBUG << "Failed to write";
 		// If we fail to write, dont wait for bytes to be written!!
 		response = Response(false);
@@ -704,7 +738,7 @@ MPDConnection::Response MPDConnection::sendCommand(const QByteArray& command, bo
 		DBUG << "Timeout (ms):" << timeout;
 		sock.waitForBytesWritten(timeout);
 		DBUG << "Socket state after write:" << (int)sock.state();
-		response = readReply(sock, timeout);
+		response = readReply(sock, timeout, reader);
 	}
 
 	if (!response.ok) {
@@ -713,7 +747,7 @@ MPDConnection::Response MPDConnection::sendCommand(const QByteArray& command, bo
 			// Try one more time...
 			// This scenario, where socket seems to be closed during/after 'write' seems to occur more often
 			// when dynamizer is running. However, simply reconnecting seems to resolve the issue.
-			return sendCommand(command, emitErrors, false);
+			return sendCommand(command, emitErrors, false, reader);
 		}
 		clearError();
 		if (emitErrors) {
@@ -779,6 +813,75 @@ MPDConnection::Response MPDConnection::sendCommand(const QByteArray& command, bo
 	return response;
 }
 
+/*
+ * Write a set of (read-only) commands without waiting for their replies. MPD processes commands in order, so
+ * the replies arrive whilst earlier ones are being handled, and sendCommand() then reads the reply of a
+ * pipelined command instead of sending it again. This way a burst of commands costs one round trip.
+ */
+void MPDConnection::pipelineCommands(const QList<QByteArray>& commands)
+{
+	if (commands.isEmpty() || !isConnected() || QAbstractSocket::ConnectedState != sock.state()) {
+		return;
+	}
+	storePipelinedReplies();
+
+	QByteArray data;
+	for (const QByteArray& cmd : commands) {
+		data += cmd + '\n';
+	}
+	DBUG << (void*)(&sock) << "pipelineCommands:" << commands;
+	if (-1 == sock.write(data)) {
+		DBUG << "Failed to write";
+		sock.close();
+		return;
+	}
+	sock.waitForBytesWritten(socketTimeout(data.length()));
+	pipelinedCommands += commands;
+}
+
+// Replies are read in the order the commands were written, so if command is not next then the replies to
+// those before it are stored until they are asked for.
+bool MPDConnection::takePipelinedReply(const QByteArray& command, Response& response, MPDParseUtils::SongReader* reader)
+{
+	QHash<QByteArray, Response>::iterator it = pipelinedReplies.find(command);
+	if (it != pipelinedReplies.end()) {
+		response = it.value();
+		pipelinedReplies.erase(it);
+		return true;
+	}
+
+	while (!pipelinedCommands.isEmpty()) {
+		QByteArray cmd = pipelinedCommands.dequeue();
+		if (cmd == command) {
+			response = readReply(sock, constSocketCommsTimeout, reader);
+			return true;
+		}
+		Response reply = readReply(sock);
+		if (!pipelinedReplies.contains(cmd)) {
+			pipelinedReplies.insert(cmd, reply);
+		}
+	}
+	return false;
+}
+
+void MPDConnection::storePipelinedReplies()
+{
+	while (!pipelinedCommands.isEmpty()) {
+		QByteArray cmd = pipelinedCommands.dequeue();
+		Response reply = readReply(sock);
+		if (!pipelinedReplies.contains(cmd)) {
+			pipelinedReplies.insert(cmd, reply);
+		}
+	}
+}
+
+// Replies that were not used are now out of date, so discard these.
+void MPDConnection::endPipeline()
+{
+	storePipelinedReplies();
+	pipelinedReplies.clear();
+}
+
 /*
  * Playlist commands
  */
@@ -1130,6 +1233,16 @@ void MPDConnection::playListChanges()
 			QList<qint32> ids;
 			QSet<qint32> prevIds = Utils::listToSet(playQueueIds);
 			QSet<qint32> strmIds;
+			// New songs are fetched afterwards, as contiguous ranges, in a single command list
+			QList<int> newSongs;
+			QByteArray fetch;
+			qint64 rangeStart = -1;
+			quint32 rangeEnd = 0;
+			auto addRange = [&]() {
+				if (rangeStart >= 0) {
+					fetch += "playlistinfo " + QByteArray::number(rangeStart) + ':' + QByteArray::number(rangeEnd) + '\n';
+				}
+			};
 
 			for (const MPDParseUtils::IdPos& idp : changes) {
 				if (first) {
@@ -1160,17 +1273,36 @@ void MPDConnection::playListChanges()
 				}
 				else {
 					// New song!
-					data = "playlistinfo ";
-					data += quote(idp.pos);
-					response = sendCommand(data);
-					if (!response.ok) {
-						playListInfo();
-						return;
-					}
-					Song s = MPDParseUtils::parseSong(response.data, MPDParseUtils::Loc_PlayQueue);
+					Song s;
 					s.id = idp.id;
-					//                     s.pos=idp.pos;
+					newSongs.append(songs.size());
 					songs.append(s);
+					if (rangeStart >= 0 && idp.pos == rangeEnd) {
+						++rangeEnd;
+					}
+					else {
+						addRange();
+						rangeStart = idp.pos;
+						rangeEnd = idp.pos + 1;
+					}
+				}
+				ids.append(idp.id);
+			}
+
+			if (!newSongs.isEmpty()) {
+				addRange();
+				MPDParseUtils::SongReader reader(MPDParseUtils::Loc_PlayQueue);
+				response = sendCommand("command_list_begin\n" + fetch + "command_list_end", true, true, &reader);
+				QList<Song> fetched = response.ok ? reader.finish(response.data) : QList<Song>();
+				if (fetched.count() != newSongs.count()) {
+					playListInfo();
+					return;
+				}
+				getRatings(fetched);
+				for (int i = 0; i < fetched.count(); ++i) {
+					Song s = fetched.at(i);
+					s.id = songs.at(newSongs.at(i)).id;
+					songs[newSongs.at(i)] = s;
 					if (s.isCdda()) {
 						newCantataStreams.append(s);
 					}
@@ -1183,7 +1315,6 @@ void MPDConnection::playListChanges()
 						}
 					}
 				}
-				ids.append(idp.id);
 			}
 
 			// Dont think this section is ever called, but leave here to be safe!!!
@@ -1222,11 +1353,13 @@ void MPDConnection::playListChanges()
 
 void MPDConnection::playListInfo()
 {
-	Response response = sendCommand("playlistinfo");
+	MPDParseUtils::SongReader reader(MPDParseUtils::Loc_PlayQueue);
+	Response response = sendCommand("playlistinfo", true, true, &reader);
 	QList<Song> songs;
 	if (response.ok) {
 		lastUpdatePlayQueueVersion = lastStatusPlayQueueVersion;
-		songs = MPDParseUtils::parseSongs(response.data, MPDParseUtils::Loc_PlayQueue);
+		songs = reader.finish(response.data);
+		getRatings(songs);
 		playQueueIds.clear();
 		streamIds.clear();
 
@@ -1505,6 +1638,12 @@ void MPDConnection::getStats()
 	}
 }
 
+void MPDConnection::keepAlive()
+{
+	// Status changes are reported via idle, so there is no need to fetch it here
+	sendCommand("ping", false);
+}
+
 void MPDConnection::getStatus()
 {
 	Response response = sendCommand("status");
@@ -1705,6 +1844,42 @@ void MPDConnection::parseIdleReturn(const QByteArray& data)
 
 	QList<QByteArray> lines = data.split('\n');
 
+	// Pipeline the read-only commands that handling these events will send, so that their replies are
+	// received together rather than each costing a round trip.
+	QList<QByteArray> pipeline;
+	auto addToPipeline = [&pipeline](const QByteArray& cmd) {
+		if (!pipeline.contains(cmd)) {
+			pipeline.append(cmd);
+		}
+	};
+	for (const QByteArray& line : lines) {
+		if (line.startsWith(constIdleChangedKey)) {
+			QByteArray value = line.mid(constIdleChangedKey.length());
+			if (constIdleDbValue == value) {
+				addToPipeline("stats");
+				addToPipeline("status");
+				addToPipeline("playlistinfo");
+			}
+			else if (constIdleUpdateValue == value) {
+				addToPipeline("stats");
+				addToPipeline("status");
+			}
+			else if (constIdlePlaylistValue == value) {
+				if (0 != lastUpdatePlayQueueVersion && !playQueueIds.isEmpty()) {
+					addToPipeline("status");
+					addToPipeline("plchangesposid " + quote(lastUpdatePlayQueueVersion));
+				}
+			}
+			else if (constIdlePlayerValue == value || constIdleMixerValue == value || constIdleOptionsValue == value) {
+				addToPipeline("status");
+				if (replaygainSupported()) {
+					addToPipeline("replay_gain_status");
+				}
+			}
+		}
+	}
+	pipelineCommands(pipeline);
+
 	/*
      * See http://www.musicpd.org/doc/protocol/ch02.html
      */
@@ -1744,6 +1919,7 @@ void MPDConnection::parseIdleReturn(const QByteArray& data)
 				outputs();
 			}
 			else if (constIdleStickerValue == value) {
+				ratingsLoaded = false;
 				emit stickerDbChanged();
 			}
 			else if (constIdleSubscriptionValue == value) {
@@ -1756,6 +1932,7 @@ void MPDConnection::parseIdleReturn(const QByteArray& data)
 			}
 		}
 	}
+	endPipeline();
 
 	while (!idleSocketCommandQueue.isEmpty()) {
 		idleSocket.write(idleSocketCommandQueue.dequeue() + '\n');
@@ -1884,11 +2061,17 @@ void MPDConnection::update()
  */
 void MPDConnection::loadLibrary()
 {
+	// Listing may process events, so guard against being called again whilst already listing
+	if (isListingMusic) {
+		return;
+	}
 	DBUG << "loadLibrary";
 	isListingMusic = true;
 	emit updatingLibrary(dbUpdate);
-	QList<Song> songs;
-	recursivelyListDir("/", songs);
+	if (!streamLibrary()) {
+		QList<Song> songs;
+		recursivelyListDir("/", songs);
+	}
 	emit updatedLibrary();
 	isListingMusic = false;
 }
@@ -1930,9 +2113,10 @@ void MPDConnection::listPlaylists()
 
 void MPDConnection::playlistInfo(const QString& name)
 {
-	Response response = sendCommand("listplaylistinfo " + encodeName(name));
+	MPDParseUtils::SongReader reader(MPDParseUtils::Loc_Playlists);
+	Response response = sendCommand("listplaylistinfo " + encodeName(name), true, true, &reader);
 	if (response.ok) {
-		emit playlistInfoRetrieved(name, MPDParseUtils::parseSongs(response.data, MPDParseUtils::Loc_Playlists));
+		emit playlistInfoRetrieved(name, reader.finish(response.data));
 	}
 }
 
@@ -2109,16 +2293,17 @@ void MPDConnection::search(const QString& field, const QString& value, int id)
 	}
 
 	if (!cmd.isEmpty()) {
-		Response response = sendCommand(cmd);
+		MPDParseUtils::SongReader reader(MPDParseUtils::Loc_Search);
+		Response response = sendCommand(cmd, true, true, &reader);
 		if (response.ok) {
-			songs = MPDParseUtils::parseSongs(response.data, MPDParseUtils::Loc_Search);
+			songs = reader.finish(response.data);
 
 			if (QLatin1String("any") == field) {
 				// When searching on 'any' MPD ignores filename/paths! So, do another
 				// search on these, and combine results.
-				response = sendCommand("search file " + encodeName(value));
+				response = sendCommand("search file " + encodeName(value), true, true, &reader);
 				if (response.ok) {
-					QList<Song> otherSongs = MPDParseUtils::parseSongs(response.data, MPDParseUtils::Loc_Search);
+					QList<Song> otherSongs = reader.finish(response.data);
 					if (!otherSongs.isEmpty()) {
 						QSet<QString> fileNames;
 						for (const auto& s : songs) {
@@ -2147,9 +2332,10 @@ void MPDConnection::search(const QByteArray& query, const QString& id)
 			QList<QByteArray> lines = response.data.split('\n');
 			for (const QByteArray& line : lines) {
 				if (line.startsWith("AlbumArtist: ")) {
-					Response resp = sendCommand("find albumartist " + encodeName(QString::fromUtf8(line.mid(13))), false, false);
+					MPDParseUtils::SongReader reader(MPDParseUtils::Loc_Search);
+					Response resp = sendCommand("find albumartist " + encodeName(QString::fromUtf8(line.mid(13))), false, false, &reader);
 					if (resp.ok) {
-						songs += MPDParseUtils::parseSongs(resp.data, MPDParseUtils::Loc_Search);
+						songs += reader.finish(resp.data);
 					}
 				}
 			}
@@ -2158,21 +2344,16 @@ void MPDConnection::search(const QByteArray& query, const QString& id)
 	else if (query.startsWith("RATING:")) {
 		QList<QByteArray> parts = query.split(':');
 		if (3 == parts.length()) {
-			Response response = sendCommand("sticker find song \"\" rating", false, false);
-			if (response.ok) {
+			if (loadRatings()) {
 				int min = parts.at(1).toInt();
 				int max = parts.at(2).toInt();
-				QList<MPDParseUtils::Sticker> stickers = MPDParseUtils::parseStickers(response.data, constRatingSticker);
-				if (!stickers.isEmpty()) {
-					for (const MPDParseUtils::Sticker& sticker : stickers) {
-						if (!sticker.file.isEmpty() && !sticker.value.isEmpty()) {
-							int val = sticker.value.toInt();
-							if (val >= min && val <= max) {
-								Response resp = sendCommand("find file " + encodeName(QString::fromUtf8(sticker.file)), false, false);
-								if (resp.ok) {
-									songs += MPDParseUtils::parseSong(resp.data, MPDParseUtils::Loc_Search);
-								}
-							}
+				// Iterate over a copy, as ratings is cleared should the connection fail
+				const QHash<QString, quint8> rated = ratings;
+				for (auto it = rated.constBegin(), end = rated.constEnd(); it != end; ++it) {
+					if (it.value() >= min && it.value() <= max) {
+						Response resp = sendCommand("find file " + encodeName(it.key()), false, false);
+						if (resp.ok) {
+							songs += MPDParseUtils::parseSong(resp.data, MPDParseUtils::Loc_Search);
 						}
 					}
 				}
@@ -2180,9 +2361,10 @@ void MPDConnection::search(const QByteArray& query, const QString& id)
 		}
 	}
 	else {
-		Response response = sendCommand(query);
+		MPDParseUtils::SongReader reader(MPDParseUtils::Loc_Search);
+		Response response = sendCommand(query, true, true, &reader);
 		if (response.ok) {
-			songs = MPDParseUtils::parseSongs(response.data, MPDParseUtils::Loc_Search);
+			songs = reader.finish(response.data);
 		}
 	}
 	emit searchResponse(id, songs);
@@ -2348,11 +2530,9 @@ void MPDConnection::toggleStopAfterCurrent(bool afterCurrent)
 	}
 }
 
-bool MPDConnection::recursivelyListDir(const QString& dir, QList<Song>& songs)
+bool MPDConnection::libraryListingSupported()
 {
-	bool topLevel = "/" == dir || "" == dir;
-
-	if (topLevel && isMpd()) {
+	if (isMpd()) {
 		// UPnP database backend does not list separate metadata items, so if "list genre" returns
 		// empty response assume this is a UPnP backend and dont attempt to get rest of data...
 		// Although we dont use "list XXX", lsinfo will return duplciate items (due to the way most
@@ -2367,6 +2547,246 @@ bool MPDConnection::recursivelyListDir(const QString& dir, QList<Song>& songs)
 			}
 		}
 	}
+	return true;
+}
+
+void MPDConnection::sendLibrarySongs(QList<Song>& songs, bool force)
+{
+	if (songs.isEmpty() || (!force && songs.count() < constLibraryChunkSize)) {
+		return;
+	}
+	QCoreApplication::processEvents();
+	// Hand the songs over, rather than copying each one
+	QList<Song>* copy = new QList<Song>();
+	copy->swap(songs);
+	emit librarySongs(copy);
+}
+
+/*
+ * Load library via "listallinfo" on a dedicated connection - one command per top-level folder,
+ * rather than one "lsinfo" per folder. Response is parsed as it is received, a folder at a time,
+ * and songs are sent on in chunks - so the complete response is never held in memory. Folders
+ * whose listing is too large for MPD's output buffer are split into their sub-folders (see
+ * listLibraryDir), so the command connection is never used.
+ *
+ * Returns false if this could not be started, in which case caller should fallback to recursivelyListDir
+ */
+bool MPDConnection::streamLibrary()
+{
+	if (!isMpd()) {
+		return false;
+	}
+
+	if (!libraryListingSupported()) {
+		return true;
+	}
+
+	if (Success != connectToMPD(librarySocket)) {
+		DBUG << "Failed to open library connection";
+		librarySocket.close();
+		return false;
+	}
+
+	Response response(false);
+	if (-1 != librarySocket.write("lsinfo\n")) {
+		librarySocket.waitForBytesWritten(constSocketCommsTimeout);
+		response = readReply(librarySocket);
+	}
+	if (!response.ok) {
+		librarySocket.close();
+		return false;
+	}
+
+	QStringList topLevelDirs;
+	QList<Song> songs;
+	MPDParseUtils::parseDirItems(response.data, details.dir, ver, songs, "/", topLevelDirs, MPDParseUtils::Loc_Library);
+	sendLibrarySongs(songs);
+
+	for (const QString& dir : topLevelDirs) {
+		listLibraryDir(dir, songs, QSet<QString>());
+		sendLibrarySongs(songs);
+	}
+
+	sendLibrarySongs(songs, true);
+	librarySocket.close();
+	return true;
+}
+
+/*
+ * "listallinfo" lists the songs of a folder, followed by each sub-folder (and its contents). So we parse the
+ * songs of each folder via parseDirItems (so that CUE files, etc, are handled as per lsinfo), but keep a folder's
+ * songs pending until all of its sub-folders have been seen - as if its only sub-folder is a CUE file then the
+ * songs are ignored (see recursivelyListDir).
+ *
+ * listedDirs is populated with each folder whose contents, and sub-folders, have been fully listed.
+ */
+bool MPDConnection::streamDir(const QString& dir, QList<Song>& songs, QSet<QString>& listedDirs)
+{
+	struct PendingDir {
+		QString path;
+		QList<Song> songs;
+		int subDirs = 0;
+		bool cueSubDir = false;
+	};
+
+	DBUG << "streamDir" << dir;
+	if (QAbstractSocket::ConnectedState != librarySocket.state() || -1 == librarySocket.write("listallinfo " + encodeName(dir) + '\n')) {
+		return false;
+	}
+	librarySocket.waitForBytesWritten(constSocketCommsTimeout);
+
+	QList<PendingDir> pending;
+	QByteArray buffer;
+	QByteArray dirItems;
+	QString currentDir = dir;
+	bool ok = false;
+	bool finished = false;
+	int attempt = 0;
+
+	auto completeDir = [&]() {
+		PendingDir p;
+		QStringList subDirs;
+		p.path = currentDir;
+		MPDParseUtils::parseDirItems(dirItems, details.dir, ver, p.songs, currentDir, subDirs, MPDParseUtils::Loc_Library);
+		pending.append(p);
+		dirItems.clear();
+	};
+	auto releaseDir = [&]() {
+		PendingDir p = pending.takeLast();
+		if (1 != p.subDirs || !p.cueSubDir) {
+			songs += p.songs;
+		}
+		else {
+			DBUG << "IGNORING:" << p.songs.size() << "track(s) as they are source files of cue?" << p.path;
+		}
+		listedDirs.insert(p.path);
+	};
+
+	while (!finished) {
+		if (0 == librarySocket.bytesAvailable()) {
+			if (QAbstractSocket::ConnectedState != librarySocket.state()) {
+				break;
+			}
+			if (!librarySocket.waitForReadyRead(constSocketCommsTimeout)) {
+				DBUG << "Wait for read failed - " << librarySocket.errorString();
+				if (++attempt >= constMaxReadAttempts) {
+					break;
+				}
+				continue;
+			}
+		}
+		attempt = 0;
+		buffer += librarySocket.readAll();
+
+		int start = 0;
+		for (int end = buffer.indexOf('\n'); -1 != end && !finished; end = buffer.indexOf('\n', start)) {
+			QByteArray line = buffer.mid(start, end - start);
+			start = end + 1;
+			if (constOkValue == line) {
+				ok = finished = true;
+			}
+			else if (line.startsWith(constAckValue)) {
+				DBUG << line;
+				finished = true;
+			}
+			else if (line.startsWith(constDirectoryKey)) {
+				completeDir();
+				currentDir = QString::fromUtf8(line.mid(constDirectoryKey.length()));
+				while (!pending.isEmpty() && !currentDir.startsWith(pending.last().path + Utils::constDirSep)) {
+					releaseDir();
+				}
+				if (!pending.isEmpty()) {
+					PendingDir& parent = pending.last();
+					parent.subDirs++;
+					parent.cueSubDir = currentDir.endsWith(".cue");
+				}
+			}
+			else {
+				dirItems += line;
+				dirItems += '\n';
+			}
+		}
+		buffer.remove(0, start);
+		sendLibrarySongs(songs);
+	}
+
+	if (ok) {
+		completeDir();
+		while (!pending.isEmpty()) {
+			releaseDir();
+		}
+	}
+	return ok;
+}
+
+/*
+ * List a folder, and its sub-folders, on the library connection. The whole folder is requested via "listallinfo".
+ * If MPD cannot send that (most likely as it exceeds max_output_buffer_size, in which case MPD closes the
+ * connection), then the folder's own items are read via "lsinfo" and each sub-folder is listed in the same way.
+ * So the size of each reply is bounded by MPD's buffer, rather than by the size of the library.
+ *
+ * Folders in listed have already been fully listed, and are skipped.
+ */
+bool MPDConnection::listLibraryDir(const QString& dir, QList<Song>& songs, const QSet<QString>& listed)
+{
+	QSet<QString> listedDirs = listed;
+	bool partlyListed = false;
+	for (const QString& l : listed) {
+		if (l.startsWith(dir + Utils::constDirSep)) {
+			partlyListed = true;
+			break;
+		}
+	}
+
+	// Only stream the whole folder if none of it has been listed, otherwise those songs would be sent twice
+	if (!partlyListed && streamDir(dir, songs, listedDirs)) {
+		return true;
+	}
+
+	DBUG << "Failed to stream" << dir << "listed" << listedDirs.count() << "folder(s) - list sub-folders";
+	// Connection may have been closed by MPD, or still have part of the failed reply queued, so re-open
+	librarySocket.close();
+	if (Success != connectToMPD(librarySocket)) {
+		DBUG << "Failed to re-open library connection";
+		librarySocket.close();
+		return false;
+	}
+
+	Response response(false);
+	if (-1 != librarySocket.write("lsinfo " + encodeName(dir) + '\n')) {
+		librarySocket.waitForBytesWritten(constSocketCommsTimeout);
+		response = readReply(librarySocket);
+	}
+	if (!response.ok) {
+		return false;
+	}
+
+	QStringList subDirs;
+	QList<Song> dirSongs;
+	MPDParseUtils::parseDirItems(response.data, details.dir, ver, dirSongs, dir, subDirs, MPDParseUtils::Loc_Library);
+	// As per recursivelyListDir, the songs of a folder whose only sub-folder is a CUE file are its source files
+	if (1 != subDirs.size() || !subDirs.at(0).endsWith(".cue")) {
+		songs += dirSongs;
+		sendLibrarySongs(songs);
+	}
+	else {
+		DBUG << "IGNORING:" << dirSongs.size() << "track(s) as they are source files of cue?" << subDirs.at(0);
+	}
+	for (const QString& sub : subDirs) {
+		if (!listedDirs.contains(sub)) {
+			listLibraryDir(sub, songs, listedDirs);
+		}
+	}
+	return true;
+}
+
+bool MPDConnection::recursivelyListDir(const QString& dir, QList<Song>& songs)
+{
+	bool topLevel = "/" == dir || "" == dir;
+
+	if (topLevel && !libraryListingSupported()) {
+		return false;
+	}
 
 	Response response = sendCommand(topLevel
 	                                        ? serverInfo.getTopLevelLsinfo()
@@ -2379,13 +2799,7 @@ bool MPDConnection::recursivelyListDir(const QString& dir, QList<Song>& songs)
 		// therefore we ignore any files in this directory as they will be the source files of the CUE
 		if (1 != subDirs.size() || !subDirs.at(0).endsWith(".cue")) {
 			songs += dirSongs;
-			if (songs.count() >= 200) {
-				QCoreApplication::processEvents();
-				QList<Song>* copy = new QList<Song>();
-				*copy << songs;
-				emit librarySongs(copy);
-				songs.clear();
-			}
+			sendLibrarySongs(songs);
 		}
 		else {
 			DBUG << "IGNORING:" << dirSongs.size() << "track(s) as they are source files of cue?" << subDirs.at(0);
@@ -2394,10 +2808,8 @@ bool MPDConnection::recursivelyListDir(const QString& dir, QList<Song>& songs)
 			recursivelyListDir(sub, songs);
 		}
 
-		if (topLevel && !songs.isEmpty()) {
-			QList<Song>* copy = new QList<Song>();
-			*copy << songs;
-			emit librarySongs(copy);
+		if (topLevel) {
+			sendLibrarySongs(songs, true);
 		}
 		return true;
 	}
@@ -2558,6 +2970,7 @@ void MPDConnection::setRating(const QString& file, quint8 val)
 	}
 
 	if (ok) {
+		updateRating(file, val);
 		emit rating(file, val);
 	}
 	else {
@@ -2606,6 +3019,9 @@ void MPDConnection::setRating(const QStringList& files, quint8 val)
 		if (!ok) {
 			break;
 		}
+		for (const QString& f : list) {
+			updateRating(f, val);
+		}
 	}
 
 	if (!ok && 0 == val) {
@@ -2614,6 +3030,29 @@ void MPDConnection::setRating(const QStringList& files, quint8 val)
 }
 
 void MPDConnection::getRating(const QString& file)
+{
+	emit rating(file, loadRatings() ? ratings.value(file, 0) : readRating(file));
+}
+
+void MPDConnection::getRatings(const QStringList& files, const QString& id)
+{
+	QMap<QString, quint8> values;
+	if (loadRatings()) {
+		for (const QString& f : files) {
+			values.insert(f, ratings.value(f, 0));
+		}
+	}
+	else {
+		// Could not read all ratings at once (e.g. too large for MPD's output buffer), so get each one
+		for (const QString& f : files) {
+			values.insert(f, readRating(f));
+		}
+	}
+	emit ratingsRetrieved(id, values);
+}
+
+// Read a single file's rating via 'sticker get'
+quint8 MPDConnection::readRating(const QString& file)
 {
 	quint8 r = 0;
 	if (canUseStickers) {
@@ -2631,7 +3070,63 @@ void MPDConnection::getRating(const QString& file)
 			r = 0;
 		}
 	}
-	emit rating(file, r);
+	return r;
+}
+
+void MPDConnection::getRatings(QList<Song>& songs)
+{
+	if (!loadRatings()) {
+		return;
+	}
+	for (Song& s : songs) {
+		if (Song::Standard == s.type) {
+			s.rating = ratings.value(s.file, 0);
+		}
+	}
+}
+
+// Read all ratings with a single 'sticker find', rather than a 'sticker get' per file. The map is
+// re-read after MPD reports that the sticker database has changed.
+bool MPDConnection::loadRatings()
+{
+	if (ratingsLoaded) {
+		return true;
+	}
+	if (!canUseStickers) {
+		return false;
+	}
+
+	Response response = sendCommand("sticker find song \"\" " + constRatingSticker, false, false);
+	if (!response.ok) {
+		clearError();
+		return false;
+	}
+
+	ratings.clear();
+	const QList<MPDParseUtils::Sticker> stickers = MPDParseUtils::parseStickers(response.data, constRatingSticker);
+	for (const MPDParseUtils::Sticker& sticker : stickers) {
+		if (!sticker.file.isEmpty() && !sticker.value.isEmpty()) {
+			quint32 r = sticker.value.toUInt();
+			if (r > 0 && r <= Song::Rating_Max) {
+				ratings.insert(QString::fromUtf8(sticker.file), r);
+			}
+		}
+	}
+	ratingsLoaded = true;
+	return true;
+}
+
+void MPDConnection::updateRating(const QString& file, quint8 val)
+{
+	if (!ratingsLoaded) {
+		return;
+	}
+	if (0 == val) {
+		ratings.remove(file);
+	}
+	else {
+		ratings.insert(file, val);
+	}
 }
 
 void MPDConnection::getStickerSupport()
@@ -2697,6 +3192,7 @@ void MPDConnection::clearError()
 #ifdef REPORT_MPD_ERRORS
 	if (isConnected()) {
 		DBUG << __FUNCTION__;
+		storePipelinedReplies();
 		if (-1 != sock.write("clearerror\n")) {
 			sock.waitForBytesWritten(500);
 			readReply(sock);
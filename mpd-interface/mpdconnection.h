@@ -36,6 +36,7 @@
 #include "song.h"
 #include "stream.h"
 #include "support/utils.h"
+#include <QHash>
 #include <QHostAddress>
 #include <QLocalSocket>
 #include <QNetworkProxy>
@@ -47,6 +48,9 @@
 
 class QTimer;
 class Thread;
+namespace MPDParseUtils {
+class SongReader;
+}
 class QPropertyAnimation;
 
 class MpdSocket : public QObject {
@@ -407,6 +411,7 @@ public Q_SLOTS:
 	void setRating(const QString& file, quint8 val);
 	void setRating(const QStringList& files, quint8 val);
 	void getRating(const QString& file);
+	void getRatings(const QStringList& files, const QString& id);
 
 	void seek(qint32 offset = 0);
 
@@ -463,6 +468,7 @@ Q_SIGNALS:
 	void dynamicResponse(const QStringList& resp);
 
 	void rating(const QString& file, quint8 val);
+	void ratingsRetrieved(const QString& id, const QMap<QString, quint8>& values);
 	void stickerDbChanged();
 
 	void ifaceIp(const QString& addr);
@@ -470,6 +476,7 @@ Q_SIGNALS:
 	void albumArt(const Song& song, const QByteArray& data);
 
 private Q_SLOTS:
+	void keepAlive();
 	void idleDataReady();
 	void onSocketStateChanged(QAbstractSocket::SocketState socketState);
 
@@ -486,11 +493,20 @@ private:
 	ConnectionReturn connectToMPD();
 	void disconnectFromMPD();
 	ConnectionReturn connectToMPD(MpdSocket& socket, bool enableIdle = false);
-	Response sendCommand(const QByteArray& command, bool emitErrors = true, bool retry = true);
+	Response sendCommand(const QByteArray& command, bool emitErrors = true, bool retry = true, MPDParseUtils::SongReader* reader = nullptr);
+	void pipelineCommands(const QList<QByteArray>& commands);
+	bool takePipelinedReply(const QByteArray& command, Response& response, MPDParseUtils::SongReader* reader);
+	void storePipelinedReplies();
+	void endPipeline();
 	void initialize();
 	void parseIdleReturn(const QByteArray& data);
 	bool doMoveInPlaylist(const QString& name, const QList<quint32>& items, quint32 pos, quint32 size);
 	void toggleStopAfterCurrent(bool afterCurrent);
+	bool libraryListingSupported();
+	bool streamLibrary();
+	bool streamDir(const QString& dir, QList<Song>& songs, QSet<QString>& listedDirs);
+	void sendLibrarySongs(QList<Song>& songs, bool force = false);
+	bool listLibraryDir(const QString& dir, QList<Song>& songs, const QSet<QString>& listed);
 	bool recursivelyListDir(const QString& dir, QList<Song>& songs);
 	QStringList getPlaylistFiles(const QString& name);
 	QStringList getAllFiles(const QString& dir);
@@ -504,6 +520,9 @@ private:
 	void emitStatusUpdated(MPDStatusValues& v);
 	void clearError();
 	void getRatings(QList<Song>& songs);
+	bool loadRatings();
+	quint8 readRating(const QString& file);
+	void updateRating(const QString& file, quint8 val);
 	void getStickerSupport();
 	void playFirstTrack(bool emitErrors);
 	void determineIfaceIp();
@@ -515,15 +534,23 @@ private:
 	QSet<QString> handlers;
 	QSet<QString> tagTypes;
 	bool canUseStickers;
+	// Ratings of all rated files, read via a single 'sticker find'
+	bool ratingsLoaded;
+	QHash<QString, quint8> ratings;
 	MPDConnectionDetails details;
 	time_t dbUpdate;
 	// Use 2 sockets, 1 for commands and 1 to receive MPD idle events.
 	// Cant use 1, as we could write a command just as an idle event is ready to read
 	MpdSocket sock;
 	MpdSocket idleSocket;
+	// Dedicated connection used whilst loading the library, so that command socket is not blocked.
+	MpdSocket librarySocket;
 	QTimer* connTimer;
 	QByteArray dynamicId;
 	QQueue<QByteArray> idleSocketCommandQueue;
+	// Commands written to sock whose replies have not been read, and replies read but not yet used
+	QQueue<QByteArray> pipelinedCommands;
+	QHash<QByteArray, Response> pipelinedReplies;
 
 	// The three items are used so that we can do quick playqueue updates...
 	QList<qint32> playQueueIds;
@@ -0,0 +1,204 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2022 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "mpdparselines.h"
+#include "song.h"
+#include "support/utils.h"
+#include <QDateTime>
+#include <cctype>
+#include <climits>
+
+// Same semantics as QByteArray::toInt() - surrounding whitespace and sign allowed, anything else gives 0
+static int toInt(QByteArrayView value)
+{
+	const char* p = value.data();
+	const char* e = p + value.size();
+	while (p < e && isspace(static_cast<unsigned char>(*p))) {
+		++p;
+	}
+	while (e > p && isspace(static_cast<unsigned char>(e[-1]))) {
+		--e;
+	}
+	bool neg = false;
+	if (p < e && ('-' == *p || '+' == *p)) {
+		neg = '-' == *p;
+		++p;
+	}
+	if (p == e) {
+		return 0;
+	}
+	qint64 v = 0;
+	for (; p < e; ++p) {
+		if (*p < '0' || *p > '9') {
+			return 0;
+		}
+		v = (v * 10) + (*p - '0');
+		if (v > 0xFFFFFFFFll) {
+			return 0;
+		}
+	}
+	if (neg) {
+		v = -v;
+	}
+	return v < INT_MIN || v > INT_MAX ? 0 : static_cast<int>(v);
+}
+
+static inline quint32 toUInt(QByteArrayView value)
+{
+	int v = toInt(value);
+	return v < 0 ? 0 : static_cast<quint32>(v);
+}
+
+static inline QByteArrayView upTo(QByteArrayView value, char c)
+{
+	const char* pos = static_cast<const char*>(memchr(value.data(), c, value.size()));
+	return pos ? QByteArrayView(value.data(), pos - value.data()) : value;
+}
+
+static inline QString toStr(QByteArrayView value)
+{
+	return QString::fromUtf8(value);
+}
+
+void MPDParseUtils::parseSongLine(Song& song, QByteArrayView key, QByteArrayView value, Location location)
+{
+	if (key.isEmpty()) {
+		return;
+	}
+
+	switch (key.at(0)) {
+	case 'f':
+		if (isKey(key, "file")) {
+			song.file = toStr(value);
+		}
+		break;
+	case 'p':
+		if (isKey(key, "playlist")) {
+			song.file = toStr(value);
+			song.title = Utils::getFile(song.file);
+			song.type = Song::Playlist;
+		}
+		break;
+	case 'A':
+		if (isKey(key, "Album")) {
+			song.album = toStr(value);
+		}
+		else if (isKey(key, "Artist")) {
+			song.artist = toStr(value);
+		}
+		else if (isKey(key, "AlbumArtist")) {
+			song.albumartist = toStr(value);
+		}
+		else if (MPDParseUtils::Loc_Library == location) {
+			if (isKey(key, "AlbumSort")) {
+				song.setAlbumSort(toStr(value));
+			}
+			else if (isKey(key, "ArtistSort")) {
+				song.setArtistSort(toStr(value));
+			}
+			else if (isKey(key, "AlbumArtistSort")) {
+				song.setAlbumArtistSort(toStr(value));
+			}
+		}
+		break;
+	case 'C':
+		if (isKey(key, "Composer")) {
+			song.setComposer(toStr(value));
+		}
+		else if (MPDParseUtils::Loc_PlayQueue == location && isKey(key, "Comment")) {
+			song.setComment(toStr(value));
+		}
+		break;
+	case 'D':
+		if (isKey(key, "Disc")) {
+			int v = toInt(upTo(value, '/'));
+			song.disc = v < 0 ? 0 : v;
+		}
+		else if (isKey(key, "Date")) {
+			song.year = toUInt(value.size() > 4 ? value.first(4) : value);
+		}
+		break;
+	case 'G':
+		if (isKey(key, "Genre")) {
+			song.addGenre(toStr(value));
+		}
+		else if (isKey(key, "Grouping")) {
+			song.setGrouping(toStr(value));
+		}
+		break;
+	case 'I':
+		if (MPDParseUtils::Loc_Library != location && MPDParseUtils::Loc_Search != location && isKey(key, "Id")) {
+			song.id = toUInt(value);
+		}
+		break;
+	case 'L':
+		if ((MPDParseUtils::Loc_Search == location || MPDParseUtils::Loc_Library == location) && isKey(key, "Last-Modified")) {
+			song.lastModified = QDateTime::fromString(toStr(value), Qt::ISODate).toSecsSinceEpoch();
+		}
+		break;
+	case 'M':
+		if (isKey(key, "MUSICBRAINZ_ALBUMID")) {
+			song.setMbAlbumId(toStr(value));
+		}
+		break;
+	case 'N':
+		if (isKey(key, "Name")) {
+			song.setName(toStr(value));
+		}
+		break;
+	case 'O':
+		if (isKey(key, "OriginalDate")) {
+			song.origYear = toUInt(value.size() > 4 ? value.first(4) : value);
+		}
+		break;
+	case 'P':
+		if (isKey(key, "Performer")) {
+			if (MPDParseUtils::Loc_Search == location || MPDParseUtils::Loc_Playlists == location || MPDParseUtils::Loc_PlayQueue == location) {
+				if (song.hasPerformer()) {
+					song.setPerformer(song.performer() + QLatin1String(", ") + toStr(value));
+				}
+				else {
+					song.setPerformer(toStr(value));
+				}
+			}
+		}
+		else if (MPDParseUtils::Loc_PlayQueue == location && isKey(key, "Prio")) {
+			song.priority = toUInt(value);
+		}
+		break;
+	case 'T':
+		if (isKey(key, "Title")) {
+			song.title = toStr(value);
+		}
+		else if (isKey(key, "Time")) {
+			song.time = toUInt(value);
+		}
+		else if (isKey(key, "Track")) {
+			int v = toInt(upTo(value, '/'));
+			song.track = v < 0 ? 0 : v;
+		}
+		break;
+	default:
+		break;
+	}
+}
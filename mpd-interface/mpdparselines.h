@@ -0,0 +1,80 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2022 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef MPD_PARSE_LINES_H
+#define MPD_PARSE_LINES_H
+
+#include "mpdparseutils.h"
+#include <QByteArrayView>
+#include <cstring>
+
+// Lines, keys, and values are referenced directly within the MPD response - no
+// intermediate QByteArray copies are made until a value is converted.
+namespace MPDParseUtils {
+
+inline bool nextLine(QByteArrayView data, qsizetype& pos, QByteArrayView& line, bool partial = true)
+{
+	if (pos >= data.size()) {
+		return false;
+	}
+	const char* start = data.data() + pos;
+	const char* end = static_cast<const char*>(memchr(start, '\n', data.size() - pos));
+	if (!end && !partial) {
+		return false;
+	}
+	qsizetype len = end ? end - start : data.size() - pos;
+	line = QByteArrayView(start, len);
+	pos += len + 1;
+	return true;
+}
+
+inline bool splitLine(QByteArrayView line, QByteArrayView& key, QByteArrayView& value)
+{
+	if (line.isEmpty()) {
+		return false;
+	}
+	const char* sep = static_cast<const char*>(memchr(line.data(), ':', line.size()));
+	if (!sep) {
+		return false;
+	}
+	qsizetype keyLen = sep - line.data();
+	if (keyLen + 1 >= line.size() || ' ' != sep[1]) {
+		return false;
+	}
+	key = QByteArrayView(line.data(), keyLen);
+	value = QByteArrayView(sep + 2, line.size() - (keyLen + 2));
+	return true;
+}
+
+template<qsizetype N>
+inline bool isKey(QByteArrayView key, const char (&name)[N])
+{
+	return N - 1 == key.size() && 0 == memcmp(key.data(), name, N - 1);
+}
+
+// Store a key/value pair of a song (or playlist) item
+extern void parseSongLine(Song& song, QByteArrayView key, QByteArrayView value, Location location);
+
+}// namespace MPDParseUtils
+
+#endif
@@ -43,6 +43,7 @@
 #endif
 #include "cuefile.h"
 #include "mpdconnection.h"
+#include "mpdparselines.h"
 #include "support/utils.h"
 #include <algorithm>
 
@@ -55,30 +56,8 @@ void MPDParseUtils::enableDebug()
 	debugEnabled = true;
 }
 
-static const QByteArray constTimeKey("Time: ");
-static const QByteArray constAlbumKey("Album: ");
-static const QByteArray constArtistKey("Artist: ");
-static const QByteArray constAlbumArtistKey("AlbumArtist: ");
-static const QByteArray constGroupingKey("Grouping: ");
-static const QByteArray constAlbumSortKey("AlbumSort: ");
-static const QByteArray constArtistSortKey("ArtistSort: ");
-static const QByteArray constAlbumArtistSortKey("AlbumArtistSort: ");
-static const QByteArray constComposerKey("Composer: ");
-static const QByteArray constPerformerKey("Performer: ");
-static const QByteArray constCommentKey("Comment: ");
-static const QByteArray constTitleKey("Title: ");
-static const QByteArray constTrackKey("Track: ");
-static const QByteArray constIdKey("Id: ");
-static const QByteArray constDiscKey("Disc: ");
-static const QByteArray constDateKey("Date: ");
-static const QByteArray constOriginalDateKey("OriginalDate: ");
-static const QByteArray constGenreKey("Genre: ");
-static const QByteArray constNameKey("Name: ");
-static const QByteArray constPriorityKey("Prio: ");
-static const QByteArray constAlbumId("MUSICBRAINZ_ALBUMID: ");
 static const QByteArray constFileKey("file: ");
 static const QByteArray constPlaylistKey("playlist: ");
-static const QByteArray constDirectoryKey("directory: ");
 static const QByteArray constPartitionKey("partition: ");
 static const QByteArray constOutputIdKey("outputid: ");
 static const QByteArray constOutputNameKey("outputname: ");
@@ -330,111 +309,18 @@ static QSet<QString> constStdProtocols = QSet<QString>() << constHttpProtocol
 														 << QLatin1String("rtmpt://")
 														 << QLatin1String("rtmps://");
 
-Song MPDParseUtils::parseSong(const QList<QByteArray>& lines, Location location)
+static void finaliseSong(Song& song, MPDParseUtils::Location location)
 {
-	Song song;
-	for (const QByteArray& line : lines) {
-		if (line.startsWith(constFileKey)) {
-			song.file = QString::fromUtf8(line.mid(constFileKey.length()));
-		}
-		else if (line.startsWith(constTimeKey)) {
-			song.time = line.mid(constTimeKey.length()).toUInt();
-		}
-		else if (line.startsWith(constAlbumKey)) {
-			song.album = QString::fromUtf8(line.mid(constAlbumKey.length()));
-		}
-		else if (line.startsWith(constArtistKey)) {
-			song.artist = QString::fromUtf8(line.mid(constArtistKey.length()));
-		}
-		else if (line.startsWith(constAlbumArtistKey)) {
-			song.albumartist = QString::fromUtf8(line.mid(constAlbumArtistKey.length()));
-		}
-		else if (line.startsWith(constGroupingKey)) {
-			song.setGrouping(QString::fromUtf8(line.mid(constGroupingKey.length())));
-		}
-		else if (line.startsWith(constComposerKey)) {
-			song.setComposer(QString::fromUtf8(line.mid(constComposerKey.length())));
-		}
-		else if (line.startsWith(constTitleKey)) {
-			song.title = QString::fromUtf8(line.mid(constTitleKey.length()));
-		}
-		else if (line.startsWith(constTrackKey)) {
-			int v = line.mid(constTrackKey.length()).split('/').at(0).toInt();
-			song.track = v < 0 ? 0 : v;
-		}
-		else if (Loc_Library != location && Loc_Search != location && line.startsWith(constIdKey)) {
-			song.id = line.mid(constIdKey.length()).toUInt();
-		}
-		else if (line.startsWith(constDiscKey)) {
-			int v = line.mid(constDiscKey.length()).split('/').at(0).toInt();
-			song.disc = v < 0 ? 0 : v;
-		}
-		else if (line.startsWith(constDateKey)) {
-			QByteArray value = line.mid(constDateKey.length());
-			int v = value.length() > 4 ? value.left(4).toUInt() : value.toUInt();
-			song.year = v < 0 ? 0 : v;
-		}
-		else if (line.startsWith(constOriginalDateKey)) {
-			QByteArray value = line.mid(constOriginalDateKey.length());
-			int v = value.length() > 4 ? value.left(4).toUInt() : value.toUInt();
-			song.origYear = v < 0 ? 0 : v;
-		}
-		else if (line.startsWith(constGenreKey)) {
-			song.addGenre(QString::fromUtf8(line.mid(constGenreKey.length())));
-		}
-		else if (line.startsWith(constNameKey)) {
-			song.setName(QString::fromUtf8(line.mid(constNameKey.length())));
-		}
-		else if (line.startsWith(constPlaylistKey)) {
-			song.file = QString::fromUtf8(line.mid(constPlaylistKey.length()));
-			song.title = Utils::getFile(song.file);
-			song.type = Song::Playlist;
-		}
-		else if (line.startsWith(constAlbumId)) {
-			song.setMbAlbumId(line.mid(constAlbumId.length()));
-		}
-		else if ((Loc_Search == location || Loc_Library == location) && line.startsWith(constLastModifiedKey)) {
-			song.lastModified = QDateTime::fromString(QString::fromUtf8(line.mid(constLastModifiedKey.length())), Qt::ISODate).toSecsSinceEpoch();
-		}
-		else if ((Loc_Search == location || Loc_Playlists == location || Loc_PlayQueue == location) && line.startsWith(constPerformerKey)) {
-			if (song.hasPerformer()) {
-				song.setPerformer(song.performer() + QLatin1String(", ") + QString::fromUtf8(line.mid(constPerformerKey.length())));
-			}
-			else {
-				song.setPerformer(QString::fromUtf8(line.mid(constPerformerKey.length())));
-			}
-		}
-		else if (Loc_PlayQueue == location) {
-			if (line.startsWith(constPriorityKey)) {
-				song.priority = line.mid(constPriorityKey.length()).toUInt();
-			}
-			else if (line.startsWith(constCommentKey)) {
-				song.setComment(QString::fromUtf8(line.mid(constCommentKey.length())));
-			}
-		}
-		else if (Loc_Library == location) {
-			if (line.startsWith(constAlbumSortKey)) {
-				song.setAlbumSort(QString::fromUtf8(line.mid(constAlbumSortKey.length())));
-			}
-			else if (line.startsWith(constArtistSortKey)) {
-				song.setArtistSort(QString::fromUtf8(line.mid(constArtistSortKey.length())));
-			}
-			else if (line.startsWith(constAlbumArtistSortKey)) {
-				song.setAlbumArtistSort(QString::fromUtf8(line.mid(constAlbumArtistSortKey.length())));
-			}
-		}
-	}
-
 	if (Song::Playlist != song.type && song.genres[0].isEmpty()) {
 		song.addGenre(Song::unknown());
 	}
 
-	if (Loc_Library == location) {
+	if (MPDParseUtils::Loc_Library == location) {
 		song.guessTags();
 		song.fillEmptyFields();
 	}
-	else if (Loc_Streams == location) {
-		song.setName(getAndRemoveStreamName(song.file, true));
+	else if (MPDParseUtils::Loc_Streams == location) {
+		song.setName(MPDParseUtils::getAndRemoveStreamName(song.file, true));
 	}
 	else {
 		QString origFile = song.file;
@@ -486,7 +372,7 @@ Song MPDParseUtils::parseSong(const QList<QByteArray>& lines, Location location)
 						modifiedFile = true;
 					}
 					else {
-						QString name = getAndRemoveStreamName(song.file);
+						QString name = MPDParseUtils::getAndRemoveStreamName(song.file);
 						if (!name.isEmpty()) {
 							song.setName(name);
 						}
@@ -496,7 +382,7 @@ Song MPDParseUtils::parseSong(const QList<QByteArray>& lines, Location location)
 					}
 				}
 			}
-			else if (Loc_PlayQueue == location && Song::Standard == song.type && !singleTracksFolders.isEmpty() && singleTracksFolders.contains(Utils::getDir(song.file, false))) {
+			else if (MPDParseUtils::Loc_PlayQueue == location && Song::Standard == song.type && !singleTracksFolders.isEmpty() && singleTracksFolders.contains(Utils::getDir(song.file, false))) {
 				song.setFromSingleTracks();
 				song.fillEmptyFields();
 			}
@@ -519,35 +405,76 @@ Song MPDParseUtils::parseSong(const QList<QByteArray>& lines, Location location)
 			song.albumartist = song.artist = PodcastService::constName;
 		}
 	}
+	song.intern();
+}
+
+Song MPDParseUtils::parseSong(QByteArrayView data, Location location)
+{
+	Song song;
+	qsizetype pos = 0;
+	QByteArrayView line;
+	QByteArrayView key;
+	QByteArrayView value;
+	while (nextLine(data, pos, line)) {
+		if (splitLine(line, key, value)) {
+			parseSongLine(song, key, value, location);
+		}
+	}
+	finaliseSong(song, location);
 	return song;
 }
 
-QList<Song> MPDParseUtils::parseSongs(const QByteArray& data, Location location)
+void MPDParseUtils::SongReader::reset()
 {
-	QList<Song> songs;
-	QList<QByteArray> currentItem;
-	QList<QByteArray> lines = data.split('\n');
-	int amountOfLines = lines.size();
+	offset = 0;
+	current = Song();
+	haveItem = false;
+	songs.clear();
+}
 
-	for (int i = 0; i < amountOfLines; i++) {
-		const QByteArray& line = lines.at(i);
+void MPDParseUtils::SongReader::parse(const QByteArray& data, bool complete)
+{
+	QByteArrayView line;
+	QByteArrayView key;
+	QByteArrayView value;
+	while (nextLine(data, offset, line, complete)) {
 		// Skip the "OK" line, this is NOT a song!!!
-		if (constOkValue == line) {
+		if (!splitLine(line, key, value)) {
 			continue;
 		}
-		if (!line.isEmpty()) {
-			currentItem.append(line);
-		}
-		if (i == lines.size() - 1 || lines.at(i + 1).startsWith(constFileKey)) {
-			Song song = parseSong(currentItem, location);
-			if (!song.file.isEmpty()) {
-				songs.append(song);
-			}
-			currentItem.clear();
+		if (haveItem && isKey(key, "file")) {
+			addCurrent();
 		}
+		parseSongLine(current, key, value, location);
+		haveItem = true;
 	}
+}
+
+QList<Song> MPDParseUtils::SongReader::finish(const QByteArray& data)
+{
+	parse(data, true);
+	if (haveItem) {
+		addCurrent();
+	}
+	QList<Song> list = songs;
+	reset();
+	return list;
+}
+
+void MPDParseUtils::SongReader::addCurrent()
+{
+	finaliseSong(current, location);
+	if (!current.file.isEmpty()) {
+		songs.append(std::move(current));
+	}
+	current = Song();
+	haveItem = false;
+}
 
-	return songs;
+QList<Song> MPDParseUtils::parseSongs(const QByteArray& data, Location location)
+{
+	SongReader reader(location);
+	return reader.finish(data);
 }
 
 QList<MPDParseUtils::IdPos> MPDParseUtils::parseChanges(const QByteArray& data)
@@ -630,198 +557,212 @@ MPDParseUtils::MessageMap MPDParseUtils::parseMessages(const QByteArray& data)
 	return messages;
 }
 
-void MPDParseUtils::parseDirItems(const QByteArray& data, const QString& mpdDir, long mpdVersion, QList<Song>& songList, const QString& dir, QStringList& subDirs, Location loc)
+void MPDParseUtils::parseDirItems(QByteArrayView data, const QString& mpdDir, long mpdVersion, QList<Song>& songList, const QString& dir, QStringList& subDirs, Location loc)
 {
-	QList<QByteArray> currentItem;
-	QList<QByteArray> lines = data.split('\n');
-	int amountOfLines = lines.size();
 	bool parsePlaylists = "/" != dir && "" != dir;
 	bool setSingleTracks = parsePlaylists && singleTracksFolders.contains(dir) && Loc_Browse != loc;
 	QList<Song> songs;
+	Song currentSong;
+	bool haveItem = false;
 
-	for (int i = 0; i < amountOfLines; i++) {
-		const QByteArray& line = lines.at(i);
-		if (line.startsWith(constDirectoryKey)) {
-			subDirs.append(QString::fromUtf8(line.mid(constDirectoryKey.length())));
-		}
-		currentItem.append(line);
-		if (i == amountOfLines - 1 || lines.at(i + 1).startsWith(constFileKey) || lines.at(i + 1).startsWith(constPlaylistKey)) {
-			Song currentSong = parseSong(currentItem, Loc_Library);
-			currentItem.clear();
-			if (currentSong.file.isEmpty()) {
-				continue;
+	auto addItem = [&]() {
+		finaliseSong(currentSong, Loc_Library);
+		if (currentSong.file.isEmpty()) {
+			return;
+		}
+
+		DBUG << currentSong.file;
+		if (Song::Playlist == currentSong.type) {
+			// lsinfo will return all stored playlists - but this is deprecated.
+			if (!parsePlaylists) {
+				return;
 			}
 
-			DBUG << currentSong.file;
-			if (Song::Playlist == currentSong.type) {
-				// lsinfo will return all stored playlists - but this is deprecated.
-				if (!parsePlaylists) {
-					continue;
+			if (!currentSong.isCueFile()) {
+				// In Folders/Browse, we can list all playlists
+				if (Loc_Browse == loc) {
+					songs.append(currentSong);
 				}
+				// Only add CUE files to library listing...
+				return;
+			}
 
-				if (!currentSong.isCueFile()) {
-					// In Folders/Browse, we can list all playlists
-					if (Loc_Browse == loc) {
-						songs.append(currentSong);
-					}
-					// Only add CUE files to library listing...
-					continue;
+			switch (cueSupport) {
+			case Cue_Ignore:
+				return;
+				break;
+			case Cue_Parse:
+				if (Loc_Browse == loc) {
+					songs.append(currentSong);
 				}
-
-				switch (cueSupport) {
-				case Cue_Ignore:
-					continue;
-					break;
-				case Cue_Parse:
-					if (Loc_Browse == loc) {
-						songs.append(currentSong);
-					}
-					if (Loc_Library != loc) {
-						continue;
-					}
-					break;
-				case Cue_ListButDontParse:
-					if (Loc_Browse == loc) {
-						songs.append(currentSong);
-					}
-				default:
-					continue;
-					break;
+				if (Loc_Library != loc) {
+					return;
 				}
-
-				// No source files for CUE file..
-				if (songs.isEmpty()) {
-					continue;
+				break;
+			case Cue_ListButDontParse:
+				if (Loc_Browse == loc) {
+					songs.append(currentSong);
 				}
+			default:
+				return;
+				break;
+			}
 
-				Song firstSong = songs.at(0);
-				QList<Song> cueSongs;  // List of songs from cue file
-				QSet<QString> cueFiles;// List of source (flac, mp3, etc) files referenced in cue file
-
-				DBUG << "Got playlist item" << currentSong.file;
-
-				bool canSplitCue = mpdVersion >= CANTATA_MAKE_VERSION(0, 17, 0);
-				bool parseCue = canSplitCue && currentSong.isCueFile() && !mpdDir.startsWith(constHttpProtocol) && QFile::exists(mpdDir + currentSong.file);
-				bool cueParseStatus = false;
-				double lastTrackIndex = 0.0;
-				if (parseCue) {
-					DBUG << "Parsing cue file:" << currentSong.file << "mpdDir:" << mpdDir;
-					cueParseStatus = CueFile::parse(currentSong.file, mpdDir, cueSongs, cueFiles, lastTrackIndex);
-					if (!cueParseStatus) {
-						DBUG << "Failed to parse cue file!";
-						continue;
-					}
-					else
-						DBUG << "Parsed cue file, songs:" << cueSongs.count() << "files:" << cueFiles;
-				}
-				if (cueParseStatus && cueSongs.count() >= songs.count() && (cueFiles.count() < cueSongs.count() || (firstSong.albumArtist().isEmpty() && firstSong.album.isEmpty()))) {
+			// No source files for CUE file..
+			if (songs.isEmpty()) {
+				return;
+			}
 
-					bool canUseThisCueFile = true;
-					for (const Song& s : cueSongs) {
-						if (!QFile::exists(mpdDir + s.name())) {
-							DBUG << QString(mpdDir + s.name()) << "is referenced in cue file, but does not exist in MPD folder";
-							canUseThisCueFile = false;
-							break;
-						}
+			Song firstSong = songs.at(0);
+			QList<Song> cueSongs;  // List of songs from cue file
+			QSet<QString> cueFiles;// List of source (flac, mp3, etc) files referenced in cue file
+
+			DBUG << "Got playlist item" << currentSong.file;
+
+			bool canSplitCue = mpdVersion >= CANTATA_MAKE_VERSION(0, 17, 0);
+			bool parseCue = canSplitCue && currentSong.isCueFile() && !mpdDir.startsWith(constHttpProtocol) && QFile::exists(mpdDir + currentSong.file);
+			bool cueParseStatus = false;
+			double lastTrackIndex = 0.0;
+			if (parseCue) {
+				DBUG << "Parsing cue file:" << currentSong.file << "mpdDir:" << mpdDir;
+				cueParseStatus = CueFile::parse(currentSong.file, mpdDir, cueSongs, cueFiles, lastTrackIndex);
+				if (!cueParseStatus) {
+					DBUG << "Failed to parse cue file!";
+					return;
+				}
+				else
+					DBUG << "Parsed cue file, songs:" << cueSongs.count() << "files:" << cueFiles;
+			}
+			if (cueParseStatus && cueSongs.count() >= songs.count() && (cueFiles.count() < cueSongs.count() || (firstSong.albumArtist().isEmpty() && firstSong.album.isEmpty()))) {
+
+				bool canUseThisCueFile = true;
+				for (const Song& s : cueSongs) {
+					if (!QFile::exists(mpdDir + s.name())) {
+						DBUG << QString(mpdDir + s.name()) << "is referenced in cue file, but does not exist in MPD folder";
+						canUseThisCueFile = false;
+						break;
 					}
+				}
 
-					if (!canUseThisCueFile) {
-						continue;
-					}
+				if (!canUseThisCueFile) {
+					return;
+				}
 
-					bool canUseCueFileTracks = false;
-					QList<Song> fixedCueSongs;// Songs taken from cueSongs that have been updated...
+				bool canUseCueFileTracks = false;
+				QList<Song> fixedCueSongs;// Songs taken from cueSongs that have been updated...
 
-					if (songs.size() == cueFiles.size()) {
-						quint32 albumTime = 0;
-						QMap<QString, Song> origFiles;
-						for (const Song& s : songs) {
-							origFiles.insert(s.file, s);
-							albumTime += s.time;
+				if (songs.size() == cueFiles.size()) {
+					quint32 albumTime = 0;
+					QMap<QString, Song> origFiles;
+					for (const Song& s : songs) {
+						origFiles.insert(s.file, s);
+						albumTime += s.time;
+					}
+					DBUG << "Original files:" << origFiles.keys();
+
+					bool setTimeFromSource = origFiles.size() == cueSongs.size();
+					DBUG << "setTimeFromSource" << setTimeFromSource << "at" << albumTime << "#c" << cueFiles.size();
+					for (const Song& orig : cueSongs) {
+						Song s = orig;
+						Song albumSong = origFiles[s.name()];
+						s.setName(QString());// CueFile has placed source file name here!
+						if (s.artist.isEmpty() && !albumSong.artist.isEmpty()) {
+							s.artist = albumSong.artist;
+							DBUG << "Get artist from album" << albumSong.artist;
 						}
-						DBUG << "Original files:" << origFiles.keys();
-
-						bool setTimeFromSource = origFiles.size() == cueSongs.size();
-						DBUG << "setTimeFromSource" << setTimeFromSource << "at" << albumTime << "#c" << cueFiles.size();
-						for (const Song& orig : cueSongs) {
-							Song s = orig;
-							Song albumSong = origFiles[s.name()];
-							s.setName(QString());// CueFile has placed source file name here!
-							if (s.artist.isEmpty() && !albumSong.artist.isEmpty()) {
-								s.artist = albumSong.artist;
-								DBUG << "Get artist from album" << albumSong.artist;
-							}
-							if (s.composer().isEmpty() && !albumSong.composer().isEmpty()) {
-								s.setComposer(albumSong.composer());
-								DBUG << "Get composer from album" << albumSong.composer();
-							}
-							if (s.album.isEmpty() && !albumSong.album.isEmpty()) {
-								s.album = albumSong.album;
-								DBUG << "Get album from album" << albumSong.album;
-							}
-							if (s.albumartist.isEmpty() && !albumSong.albumartist.isEmpty()) {
-								s.albumartist = albumSong.albumartist;
-								DBUG << "Get albumartist from album" << albumSong.albumartist;
-							}
-							if (0 == s.year && 0 != albumSong.year) {
-								s.year = albumSong.year;
-								DBUG << "Get year from album" << albumSong.year;
-							}
-							if (0 == s.time && setTimeFromSource) {
-								s.time = albumSong.time;
-							}
-							else if (0 == s.time && 1 == cueFiles.size()) {
-								DBUG << "Set time of last track" << s.title << s.time << albumTime << (lastTrackIndex / 1000.0);
-								// Try to set duration of last track by subtracting previous track durations from album duration...
-								s.time = albumTime - (lastTrackIndex / 1000.0);
-							}
-							DBUG << s.title << s.time;
-							fixedCueSongs.append(s);
+						if (s.composer().isEmpty() && !albumSong.composer().isEmpty()) {
+							s.setComposer(albumSong.composer());
+							DBUG << "Get composer from album" << albumSong.composer();
 						}
-						canUseCueFileTracks = true;
-					}
-					else
-						DBUG << "ERROR: file count mismatch" << songs.size() << cueFiles.size();
-
-					if (!canUseCueFileTracks) {
-						// Album had a different number of source files to the CUE file. If so, then we need to ensure
-						// all tracks have meta data - otherwise just fallback to listing file + cue
-						for (const Song& orig : cueSongs) {
-							Song s = orig;
-							s.setName(QString());// CueFile has placed source file name here!
-							if (s.artist.isEmpty() || s.album.isEmpty()) {
-								break;
-							}
-							fixedCueSongs.append(s);
+						if (s.album.isEmpty() && !albumSong.album.isEmpty()) {
+							s.album = albumSong.album;
+							DBUG << "Get album from album" << albumSong.album;
 						}
-
-						if (fixedCueSongs.count() == cueSongs.count()) {
-							canUseCueFileTracks = true;
+						if (s.albumartist.isEmpty() && !albumSong.albumartist.isEmpty()) {
+							s.albumartist = albumSong.albumartist;
+							DBUG << "Get albumartist from album" << albumSong.albumartist;
+						}
+						if (0 == s.year && 0 != albumSong.year) {
+							s.year = albumSong.year;
+							DBUG << "Get year from album" << albumSong.year;
+						}
+						if (0 == s.time && setTimeFromSource) {
+							s.time = albumSong.time;
+						}
+						else if (0 == s.time && 1 == cueFiles.size()) {
+							DBUG << "Set time of last track" << s.title << s.time << albumTime << (lastTrackIndex / 1000.0);
+							// Try to set duration of last track by subtracting previous track durations from album duration...
+							s.time = albumTime - (lastTrackIndex / 1000.0);
+						}
+						DBUG << s.title << s.time;
+						fixedCueSongs.append(s);
+					}
+					canUseCueFileTracks = true;
+				}
+				else
+					DBUG << "ERROR: file count mismatch" << songs.size() << cueFiles.size();
+
+				if (!canUseCueFileTracks) {
+					// Album had a different number of source files to the CUE file. If so, then we need to ensure
+					// all tracks have meta data - otherwise just fallback to listing file + cue
+					for (const Song& orig : cueSongs) {
+						Song s = orig;
+						s.setName(QString());// CueFile has placed source file name here!
+						if (s.artist.isEmpty() || s.album.isEmpty()) {
+							break;
 						}
-						else
-							DBUG << "ERROR: Not all cue tracks had meta data";
+						fixedCueSongs.append(s);
 					}
 
-					if (canUseCueFileTracks) {
-						songs = fixedCueSongs;
+					if (fixedCueSongs.count() == cueSongs.count()) {
+						canUseCueFileTracks = true;
 					}
-					continue;
+					else
+						DBUG << "ERROR: Not all cue tracks had meta data";
 				}
 
-				if (!firstSong.albumArtist().isEmpty() && !firstSong.album.isEmpty()) {
-					currentSong.albumartist = firstSong.albumArtist();
-					currentSong.album = firstSong.album;
-					songs.append(currentSong);
+				if (canUseCueFileTracks) {
+					songs = fixedCueSongs;
 				}
+				return;
 			}
-			else {
-				if (setSingleTracks) {
-					currentSong.setFromSingleTracks();
-				}
-				currentSong.fillEmptyFields();
+
+			if (!firstSong.albumArtist().isEmpty() && !firstSong.album.isEmpty()) {
+				currentSong.albumartist = firstSong.albumArtist();
+				currentSong.album = firstSong.album;
 				songs.append(currentSong);
 			}
 		}
+		else {
+			if (setSingleTracks) {
+				currentSong.setFromSingleTracks();
+			}
+			currentSong.fillEmptyFields();
+			songs.append(currentSong);
+		}
+	};
+
+	qsizetype pos = 0;
+	QByteArrayView line;
+	QByteArrayView key;
+	QByteArrayView value;
+	while (nextLine(data, pos, line)) {
+		if (!splitLine(line, key, value)) {
+			continue;
+		}
+		if (isKey(key, "directory")) {
+			subDirs.append(QString::fromUtf8(value));
+			continue;
+		}
+		if (haveItem && (isKey(key, "file") || isKey(key, "playlist"))) {
+			addItem();
+			currentSong = Song();
+		}
+		parseSongLine(currentSong, key, value, Loc_Library);
+		haveItem = true;
+	}
+	if (haveItem) {
+		addItem();
 	}
 	if (Loc_Browse == loc) {
 		QList<Song> sngs;
@@ -29,6 +29,7 @@
 
 #include "config.h"
 #include "song.h"
+#include <QByteArrayView>
 #include <QSet>
 #include <QString>
 
@@ -80,14 +81,38 @@ extern void setSingleTracksFolders(const QSet<QString>& folders);
 extern QList<Playlist> parsePlaylists(const QByteArray& data);
 extern MPDStatsValues parseStats(const QByteArray& data);
 extern MPDStatusValues parseStatus(const QByteArray& data);
-extern Song parseSong(const QList<QByteArray>& lines, Location location);
-inline Song parseSong(const QByteArray& data, Location location) { return parseSong(data.split('\n'), location); }
+extern Song parseSong(QByteArrayView data, Location location);
 extern QList<Song> parseSongs(const QByteArray& data, Location location);
+
+// Parses songs from a response as it is being read, so that only complete
+// lines are processed and nothing is parsed twice.
+class SongReader {
+public:
+	SongReader(Location loc)
+		: location(loc), offset(0), haveItem(false)
+	{
+	}
+	void reset();
+	// Parse any new, complete, lines in data - which must be the same (growing) response
+	void parse(const QByteArray& data, bool complete = false);
+	QList<Song> finish(const QByteArray& data);
+
+private:
+	void addCurrent();
+
+private:
+	Location location;
+	qsizetype offset;
+	Song current;
+	bool haveItem;
+	QList<Song> songs;
+};
+
 extern QList<IdPos> parseChanges(const QByteArray& data);
 extern QStringList parseList(const QByteArray& data, const QByteArray& key);
 typedef QMap<QByteArray, QStringList> MessageMap;
 extern MessageMap parseMessages(const QByteArray& data);
-extern void parseDirItems(const QByteArray& data, const QString& mpdDir, long mpdVersion, QList<Song>& songList, const QString& dir, QStringList& subDirs, Location loc);
+extern void parseDirItems(QByteArrayView data, const QString& mpdDir, long mpdVersion, QList<Song>& songList, const QString& dir, QStringList& subDirs, Location loc);
 extern QList<Partition> parsePartitions(const QByteArray& data);
 extern QList<Output> parseOuputs(const QByteArray& data);
 extern QByteArray parseSticker(const QByteArray& data, const QByteArray& sticker);
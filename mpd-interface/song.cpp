@@ -177,36 +177,6 @@ Song::Song()
 {
 }
 
-Song& Song::operator=(const Song& s)
-{
-	id = s.id;
-	file = s.file;
-	time = s.time;
-	album = s.album;
-	artist = s.artist;
-	albumartist = s.albumartist;
-	title = s.title;
-	track = s.track;
-	//     pos = s.pos;
-	disc = s.disc;
-	blank = s.blank;
-	priority = s.priority;
-	origYear = s.origYear;
-	year = s.year;
-	for (int i = 0; i < constNumGenres; ++i) {
-		genres[i] = s.genres[i];
-	}
-	size = s.size;
-	rating = s.rating;
-	key = s.key;
-	type = s.type;
-	guessed = s.guessed;
-	extra = s.extra;
-	extraFields = s.extraFields;
-	lastModified = s.lastModified;
-	return *this;
-}
-
 bool Song::operator==(const Song& o) const
 {
 	return 0 == compareTo(o);
@@ -496,7 +466,7 @@ void Song::clear()
 		genres[i] = QString();
 	}
 	size = 0;
-	extra.clear();
+	clearExtra();
 	type = Standard;
 }
 
@@ -660,15 +630,71 @@ int Song::compareGenres(const Song& o) const
 void Song::setExtraField(quint32 f, const QString& v)
 {
 	if (v.isEmpty()) {
-		extra.remove(f);
-		extraFields &= ~f;
+		if (hasExtraField(f)) {
+			extra.removeAt(extraIndex(f));
+			extraFields &= ~f;
+		}
+	}
+	else if (hasExtraField(f)) {
+		extra[extraIndex(f)] = v;
 	}
 	else {
-		extra[f] = v;
+		extra.insert(extraIndex(f), v);
 		extraFields |= f;
 	}
 }
 
+// Pool of strings shared between songs. Strings only referenced by the pool are removed
+// once it has doubled in size since it was last pruned.
+static QMutex internMutex;
+static QSet<QString> internPool;
+static qsizetype internPoolPrunedSize = 0;
+static const qsizetype constMinInternPoolPruneSize = 4096;
+
+static void internString(QString& str)
+{
+	if (str.isEmpty()) {
+		return;
+	}
+	QSet<QString>::ConstIterator it = internPool.constFind(str);
+	if (it == internPool.constEnd()) {
+		internPool.insert(str);
+	}
+	else {
+		str = *it;
+	}
+}
+
+void Song::intern()
+{
+	static const quint32 constInternFields[] = {Composer, MusicBrainzAlbumId, AlbumSort, ArtistSort, AlbumArtistSort};
+
+	QMutexLocker locker(&internMutex);
+	internString(album);
+	internString(artist);
+	internString(albumartist);
+	for (int i = 0; i < constNumGenres && !genres[i].isEmpty(); ++i) {
+		internString(genres[i]);
+	}
+	for (quint32 f : constInternFields) {
+		if (hasExtraField(f)) {
+			internString(extra[extraIndex(f)]);
+		}
+	}
+
+	if (internPool.size() > qMax(constMinInternPoolPruneSize, internPoolPrunedSize * 2)) {
+		for (QSet<QString>::Iterator it = internPool.begin(); it != internPool.end();) {
+			if (it->isDetached()) {
+				it = internPool.erase(it);
+			}
+			else {
+				++it;
+			}
+		}
+		internPoolPrunedSize = internPool.size();
+	}
+}
+
 bool Song::isVariousArtists(const QString& str)
 {
 	return QLatin1String("Various Artists") == str || variousArtistsStr == str;
@@ -977,7 +1003,7 @@ QDataStream& operator<<(QDataStream& stream, const Song& song)
 {
 	stream << song.id << song.file << song.album << song.artist << song.albumartist << song.title
 		   << song.disc << song.priority << song.time << song.track << (quint16)song.year// << song.origYear
-		   << (quint16)song.type << (bool)song.guessed << song.size << song.extra << song.extraFields;
+		   << (quint16)song.type << (bool)song.guessed << song.size << song.extraFields << song.extra;
 	for (int i = 0; i < Song::constNumGenres; ++i) {
 		stream << song.genres[i];
 	}
@@ -992,7 +1018,10 @@ QDataStream& operator>>(QDataStream& stream, Song& song)
 	bool guessed;
 	stream >> song.id >> song.file >> song.album >> song.artist >> song.albumartist >> song.title
 			>> disc >> song.priority >> song.time >> song.track >> year// >> song.origYear
-			>> type >> guessed >> song.size >> song.extra >> song.extraFields;
+			>> type >> guessed >> song.size >> song.extraFields >> song.extra;
+	if (static_cast<qsizetype>(qPopulationCount(song.extraFields)) != song.extra.count()) {
+		song.clearExtra();
+	}
 	song.type = (Song::Type)type;
 	song.year = year;
 	song.guessed = guessed;
@@ -32,9 +32,11 @@
 #include "cuefile.h"
 #include "support/utils.h"
 #include <QHash>
+#include <QList>
 #include <QMetaType>
 #include <QSet>
 #include <QString>
+#include <QtAlgorithms>
 
 struct Song {
 	enum Constants {
@@ -99,7 +101,7 @@ struct Song {
 	QString albumartist;
 	QString title;
 	QString genres[constNumGenres];
-	QHash<quint32, QString> extra;
+	QList<QString> extra;// Values of set extraFields, in bit order
 	quint32 extraFields;
 	mutable quint8 priority;
 	quint8 disc : 5;
@@ -140,13 +142,14 @@ struct Song {
 	static void setUseOriginalYear(bool u);
 
 	Song();
-	Song(const Song& o) { *this = o; }
-	Song& operator=(const Song& o);
+	Song(const Song& o) = default;
+	Song(Song&& o) = default;
+	Song& operator=(const Song& o) = default;
+	Song& operator=(Song&& o) = default;
 	bool operator==(const Song& o) const;
 	bool operator!=(const Song& o) const { return !(*this == o); }
 	bool operator<(const Song& o) const;
 	int compareTo(const Song& o) const;
-	virtual ~Song() {}
 	bool isEmpty() const;
 	bool isDifferent(const Song& s) const { return file != s.file || year != s.year || track != s.track || disc != s.disc || artist != s.artist || album != s.album || title != s.title || name() != s.name(); }
 	bool sameMetadata(const Song& o) const;
@@ -154,7 +157,7 @@ struct Song {
 	void revertGuessedTags();
 	void fillEmptyFields();
 	quint16 setKey(int location);
-	virtual void clear();
+	void clear();
 	void addGenre(const QString& g);
 	quint16 displayYear() const;
 	QString entryName() const;
@@ -171,8 +174,9 @@ struct Song {
 	const QString& firstGenre() const { return genres[0]; }
 	int compareGenres(const Song& o) const;
 
-	QString extraField(quint32 f) const { return hasExtraField(f) ? extra[f] : QString(); }
+	QString extraField(quint32 f) const { return hasExtraField(f) ? extra.at(extraIndex(f)) : QString(); }
 	bool hasExtraField(quint32 f) const { return extraFields & f; }
+	int extraIndex(quint32 f) const { return qPopulationCount(extraFields & (f - 1)); }
 	void setExtraField(quint32 f, const QString& v);
 	QString name() const { return extraField(Name); }
 	void setName(const QString& v) { setExtraField(Name, v); }
@@ -206,7 +210,13 @@ struct Song {
 	QString artistSortString() const { return hasAlbumArtistSort() ? albumArtistSort() : hasArtistSort() ? artistSort()
 		                                                                                                 : QString(); }
 
-	void clearExtra() { extra.clear(); }
+	void clearExtra()
+	{
+		extra.clear();
+		extraFields = 0;
+	}
+	// Share the storage of strings that are repeated across many songs (artist, album, genre, etc.)
+	void intern();
 
 	static bool isVariousArtists(const QString& str);
 	bool isVariousArtists() const { return isVariousArtists(albumArtist()); }
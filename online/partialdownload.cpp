@@ -0,0 +1,178 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2022 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "partialdownload.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+
+static const QLatin1String constPartialExt(".partial");
+static const QLatin1String constValidatorExt(".partial-validator");
+
+static QString validatorFileName(const QString& dest)
+{
+	return dest + constValidatorExt;
+}
+
+static QByteArray readValidator(const QString& dest)
+{
+	QFile f(validatorFileName(dest));
+	return f.open(QIODevice::ReadOnly) ? f.readAll().trimmed() : QByteArray();
+}
+
+// If-Range only accepts a strong ETag, otherwise Last-Modified is used
+static QByteArray replyValidator(const QNetworkReply* reply)
+{
+	QByteArray etag = reply->rawHeader("ETag").trimmed();
+	if (!etag.isEmpty() && !etag.startsWith("W/")) {
+		return etag;
+	}
+	return reply->rawHeader("Last-Modified").trimmed();
+}
+
+// Start offset of a "Content-Range: bytes <first>-<last>/<length>" header, or -1 if it is not valid
+static qint64 rangeStart(const QByteArray& contentRange)
+{
+	if (!contentRange.startsWith("bytes ")) {
+		return -1;
+	}
+	int dash = contentRange.indexOf('-', 6);
+	bool ok = false;
+	qint64 start = -1 == dash ? -1 : contentRange.mid(6, dash - 6).trimmed().toLongLong(&ok);
+	return ok ? start : -1;
+}
+
+QString PartialDownload::fileName(const QString& dest)
+{
+	return dest + constPartialExt;
+}
+
+QStringList PartialDownload::nameFilters()
+{
+	return QStringList() << QLatin1Char('*') + constPartialExt << QLatin1Char('*') + constValidatorExt;
+}
+
+QString PartialDownload::destFor(const QString& fileName)
+{
+	if (fileName.endsWith(constValidatorExt)) {
+		return fileName.left(fileName.length() - constValidatorExt.size());
+	}
+	if (fileName.endsWith(constPartialExt)) {
+		return fileName.left(fileName.length() - constPartialExt.size());
+	}
+	return fileName;
+}
+
+qint64 PartialDownload::prepare(const QString& dest, QNetworkRequest& req)
+{
+	qint64 offset = QFileInfo(fileName(dest)).size();
+	if (offset <= 0) {
+		return 0;
+	}
+	QByteArray validator = readValidator(dest);
+	if (validator.isEmpty()) {
+		// Cannot tell if the file has changed since this was downloaded, so start again
+		remove(dest);
+		return 0;
+	}
+	// Server sends the whole file (200), rather than the range (206), if it no longer matches the validator
+	req.setRawHeader("Range", "bytes=" + QByteArray::number(offset) + "-");
+	req.setRawHeader("If-Range", validator);
+	return offset;
+}
+
+bool PartialDownload::start(const QString& dest, const QNetworkReply* reply)
+{
+	int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+	QString partial = fileName(dest);
+	if (206 == status) {
+		qint64 start = rangeStart(reply->rawHeader("Content-Range"));
+		if (start != QFileInfo(partial).size()) {
+			remove(dest);
+			return false;
+		}
+		return true;
+	}
+	if (200 != status) {
+		return false;
+	}
+
+	// Whole file - so replace any partial file, and note what this version of the file is
+	QString dir = QFileInfo(partial).absolutePath();
+	if (!QDir(dir).exists()) {
+		QDir(dir).mkpath(dir);
+	}
+	QFile f(partial);
+	if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		return false;
+	}
+	f.close();
+	QByteArray validator = replyValidator(reply);
+	if (validator.isEmpty()) {
+		QFile::remove(validatorFileName(dest));
+	}
+	else {
+		QFile v(validatorFileName(dest));
+		if (v.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+			v.write(validator);
+		}
+	}
+	return true;
+}
+
+bool PartialDownload::append(const QString& dest, QIODevice* dev, qint64 bytes)
+{
+	QFile f(fileName(dest));
+	if (!f.open(QIODevice::Append)) {
+		return false;
+	}
+	f.write(dev->read(bytes));
+	return true;
+}
+
+bool PartialDownload::complete(const QString& dest)
+{
+	QString partial = fileName(dest);
+	if (!QFile::exists(partial)) {
+		return false;
+	}
+	if (QFile::exists(dest)) {
+		QFile::remove(dest);
+	}
+	if (!QFile::rename(partial, dest)) {
+		return false;
+	}
+	QFile::remove(validatorFileName(dest));
+	return true;
+}
+
+void PartialDownload::remove(const QString& dest)
+{
+	for (const QString& f : QStringList() << fileName(dest) << validatorFileName(dest)) {
+		if (QFile::exists(f)) {
+			QFile::remove(f);
+		}
+	}
+}
@@ -0,0 +1,55 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2022 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef PARTIALDOWNLOAD_H
+#define PARTIALDOWNLOAD_H
+
+#include <QString>
+#include <QStringList>
+
+class QIODevice;
+class QNetworkReply;
+class QNetworkRequest;
+
+// Episode data is downloaded into "<dest>.partial", and only renamed to dest once complete. Alongside this,
+// "<dest>.partial-validator" holds the ETag (or Last-Modified) of the reply the data came from, so that an
+// interrupted download is only resumed if the file on the server has not changed.
+namespace PartialDownload {
+
+QString fileName(const QString& dest);
+// Name filters matching partial, and validator, files in a folder
+QStringList nameFilters();
+// Destination file that a partial, or validator, file is for
+QString destFor(const QString& fileName);
+// Request only the part of the file not yet downloaded. Returns the size of the partial file being resumed
+qint64 prepare(const QString& dest, QNetworkRequest& req);
+// Called before the first data of a reply is written. Returns false if the reply does not continue, nor
+// replace, the partial file - in which case this has been removed
+bool start(const QString& dest, const QNetworkReply* reply);
+bool append(const QString& dest, QIODevice* dev, qint64 bytes);
+bool complete(const QString& dest);
+void remove(const QString& dest);
+
+}// namespace PartialDownload
+
+#endif
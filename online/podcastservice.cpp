@@ -30,6 +30,7 @@
 #include "models/roles.h"
 #include "mpd-interface/mpdconnection.h"
 #include "network/networkaccessmanager.h"
+#include "partialdownload.h"
 #include "podcastsettingsdialog.h"
 #include "qtiocompressor/qtiocompressor.h"
 #include "rssparser.h"
@@ -147,7 +148,12 @@ static const QLatin1String constExt(".xml.gz");
 static const char* constNewFeedProperty = "new-feed";
 static const char* constRssUrlProperty = "rss-url";
 static const char* constDestProperty = "dest";
-static const QLatin1String constPartialExt(".partial");
+static const char* constOffsetProperty = "offset";
+static const char* constStartedProperty = "started";
+// Maximum number of RSS feeds to download at once when refreshing
+static const int constMaxRssJobs = 4;
+// When podcast downloads are rate limited, data is read this many times a second
+static const int constDownloadTicks = 10;
 
 static QString generateFileName(const QUrl& url, bool creatingNew)
 {
@@ -240,6 +246,8 @@ PodcastService::Podcast::Podcast(const QString& f)
 static QLatin1String constTopTag("podcast");
 static QLatin1String constImageAttribute("img");
 static QLatin1String constRssAttribute("rss");
+static QLatin1String constETagAttribute("etag");
+static QLatin1String constLastModifiedAttribute("modified");
 static QLatin1String constEpisodeTag("episode");
 static QLatin1String constNameAttribute("name");
 static QLatin1String constDescrAttribute("descr");
@@ -276,6 +284,8 @@ bool PodcastService::Podcast::load()
 			if (constTopTag == element) {
 				imageUrl = attributes.value(constImageAttribute).toString();
 				url = attributes.value(constRssAttribute).toString();
+				etag = attributes.value(constETagAttribute).toString();
+				lastModified = attributes.value(constLastModifiedAttribute).toString();
 				name = attributes.value(constNameAttribute).toString();
 				descr = attributes.value(constDescrAttribute).toString();
 				if (url.isEmpty() || name.isEmpty()) {
@@ -335,6 +345,12 @@ bool PodcastService::Podcast::save() const
 	writer.writeStartElement(constTopTag);
 	writer.writeAttribute(constImageAttribute, imageUrl.toString());// ??
 	writer.writeAttribute(constRssAttribute, url.toString());       // ??
+	if (!etag.isEmpty()) {
+		writer.writeAttribute(constETagAttribute, etag);
+	}
+	if (!lastModified.isEmpty()) {
+		writer.writeAttribute(constLastModifiedAttribute, lastModified);
+	}
 	writer.writeAttribute(constNameAttribute, name);
 	writer.writeAttribute(constDescrAttribute, descr);
 	for (Episode* ep : episodes) {
@@ -421,12 +437,11 @@ const Song& PodcastService::Podcast::coverSong()
 }
 
 PodcastService::PodcastService()
-	: ActionModel(nullptr), downloadJob(nullptr), rssUpdateTimer(nullptr)
+	: ActionModel(nullptr), downloadRateTimer(nullptr), downloadSlice(0), downloadBudget(0), rssUpdateTimer(nullptr)
 {
 	QMetaObject::invokeMethod(this, "loadAll", Qt::QueuedConnection);
 	icn = Icon::fa(fa::fa_solid, fa::fa_rss_square);
 	useCovers(name(), true);
-	clearPartialDownloads();
 	connect(MPDConnection::self(), SIGNAL(currentSongUpdated(const Song&)), this, SLOT(currentMpdSong(const Song&)));
 	refreshAction = new Action(Icons::self()->reloadIcon, tr("Refresh"), this);
 }
@@ -769,6 +784,7 @@ void PodcastService::loadAll()
 	}
 	endResetModel();
 	emit dataChanged(QModelIndex(), QModelIndex());
+	clearPartialDownloads();
 }
 
 void PodcastService::cancelAll()
@@ -778,6 +794,7 @@ void PodcastService::cancelAll()
 		j->cancelAndDelete();
 	}
 	rssJobs.clear();
+	rssQueue.clear();
 	cancelAllDownloads();
 }
 
@@ -790,6 +807,7 @@ void PodcastService::rssJobFinished()
 
 	j->deleteLater();
 	rssJobs.removeAll(j);
+	startRssJobs();
 	bool isNew = j->property(constNewFeedProperty).toBool();
 
 	if (j->ok()) {
@@ -802,6 +820,11 @@ void PodcastService::rssJobFinished()
 			}
 		}
 
+		if (!isNew && 304 == j->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt()) {
+			// Not modified since last download
+			return;
+		}
+
 		RssParser::Channel ch = RssParser::parse(j->actualJob());
 
 		if (!ch.isValid()) {
@@ -825,6 +848,8 @@ void PodcastService::rssJobFinished()
 		}
 
 		int autoDownload = Settings::self()->podcastAutoDownloadLimit();
+		QString etag = QString::fromLatin1(j->actualJob()->rawHeader("ETag"));
+		QString lastModified = QString::fromLatin1(j->actualJob()->rawHeader("Last-Modified"));
 
 		if (isNew) {
 			Podcast* podcast = new Podcast();
@@ -832,6 +857,8 @@ void PodcastService::rssJobFinished()
 			podcast->fileName = podcast->imageFile = generateFileName(podcast->url, true);
 			podcast->imageFile = podcast->imageFile.replace(constExt, ".jpg");
 			podcast->imageUrl = ch.image.toString();
+			podcast->etag = etag;
+			podcast->lastModified = lastModified;
 			podcast->name = ch.name;
 			podcast->descr = ch.description;
 			podcast->unplayedCount = ch.episodes.count();
@@ -874,6 +901,9 @@ void PodcastService::rssJobFinished()
 			if (!podcast) {
 				return;
 			}
+			bool validatorsChanged = podcast->etag != etag || podcast->lastModified != lastModified;
+			podcast->etag = etag;
+			podcast->lastModified = lastModified;
 			QSet<QUrl> newEpisodes;
 			QSet<QUrl> oldEpisodes;
 			for (Episode* episode : podcast->episodes) {
@@ -900,6 +930,7 @@ void PodcastService::rssJobFinished()
 							}
 						}
 					}
+					clearPartialDownloads();
 				}
 				if (added.count()) {
 					beginInsertRows(podcastIndex, podcast->episodes.count(), (podcast->episodes.count() + added.count()) - 1);
@@ -920,6 +951,9 @@ void PodcastService::rssJobFinished()
 				podcast->save();
 				emit dataChanged(podcastIndex, podcastIndex);
 			}
+			else if (validatorsChanged) {
+				podcast->save();
+			}
 		}
 	}
 	else {
@@ -962,6 +996,7 @@ void PodcastService::unSubscribe(Podcast* podcast)
 			episodes.append(e);
 		}
 		cancelDownloads(episodes);
+		rssQueue.removeAll(podcast->url);
 		beginRemoveRows(QModelIndex(), row, row);
 		podcast->removeFiles();
 		delete podcasts.takeAt(row);
@@ -970,6 +1005,7 @@ void PodcastService::unSubscribe(Podcast* podcast)
 		if (podcasts.isEmpty()) {
 			stopRssUpdateTimer();
 		}
+		clearPartialDownloads();
 	}
 }
 
@@ -997,7 +1033,8 @@ void PodcastService::refreshSubscription(Podcast* item)
 		if (processingUrl(url)) {
 			return;
 		}
-		addUrl(url, false);
+		rssQueue.append(url);
+		startRssJobs();
 	}
 	else {
 		updateRss();
@@ -1011,12 +1048,23 @@ bool PodcastService::processingUrl(const QUrl& url) const
 			return true;
 		}
 	}
-	return false;
+	return rssQueue.contains(url);
 }
 
 void PodcastService::addUrl(const QUrl& url, bool isNew)
 {
-	NetworkJob* job = NetworkAccessManager::self()->get(url);
+	QNetworkRequest req(url);
+	Podcast* podcast = isNew ? nullptr : getPodcast(url);
+	if (podcast) {
+		// Ask the server to only send the feed if it has changed
+		if (!podcast->etag.isEmpty()) {
+			req.setRawHeader("If-None-Match", podcast->etag.toLatin1());
+		}
+		if (!podcast->lastModified.isEmpty()) {
+			req.setRawHeader("If-Modified-Since", podcast->lastModified.toLatin1());
+		}
+	}
+	NetworkJob* job = NetworkAccessManager::self()->get(req);
 	connect(job, SIGNAL(finished()), this, SLOT(rssJobFinished()));
 	job->setProperty(constNewFeedProperty, isNew);
 	rssJobs.append(job);
@@ -1024,8 +1072,10 @@ void PodcastService::addUrl(const QUrl& url, bool isNew)
 
 bool PodcastService::downloadingEpisode(const QUrl& url) const
 {
-	if (downloadJob && downloadJob->origUrl() == url) {
-		return true;
+	for (NetworkJob* job : downloadJobs) {
+		if (job->origUrl() == url) {
+			return true;
+		}
 	}
 	return toDownload.contains(url);
 }
@@ -1037,7 +1087,10 @@ void PodcastService::cancelAllDownloads()
 	}
 
 	toDownload.clear();
-	cancelDownload();
+	// Keep partial files, so that these downloads can be resumed later
+	while (!downloadJobs.isEmpty()) {
+		cancelDownload(downloadJobs.first(), false);
+	}
 }
 
 void PodcastService::downloadPodcasts(Podcast* pod, const QList<Episode*>& episodes)
@@ -1119,85 +1172,153 @@ void PodcastService::downloadEpisode(const Podcast* podcast, const QUrl& episode
 
 void PodcastService::cancelDownloads(const QList<Episode*> episodes)
 {
-	bool cancelDl = false;
 	for (Episode* e : episodes) {
 		toDownload.removeAll(e->url);
 		e->downloadProg = Episode::NotDownloading;
 		QModelIndex idx = createIndex(e->parent->episodes.indexOf(e), 0, (void*)e);
 		emit dataChanged(idx, idx);
-		if (!cancelDl && downloadJob && downloadJob->url() == e->url) {
-			cancelDl = true;
+		for (NetworkJob* job : downloadJobs) {
+			if (job->origUrl() == e->url) {
+				cancelDownload(job, true);
+				break;
+			}
 		}
 	}
-	if (cancelDl) {
-		cancelDownload();
-	}
+	doNextDownload();
 }
 
 void PodcastService::cancelDownload(const QUrl& url)
 {
-	if (downloadJob && downloadJob->origUrl() == url) {
-		cancelDownload();
-		doNextDownload();
+	for (NetworkJob* job : downloadJobs) {
+		if (job->origUrl() == url) {
+			cancelDownload(job, true);
+			doNextDownload();
+			return;
+		}
 	}
 }
 
-void PodcastService::cancelDownload()
+void PodcastService::cancelDownload(NetworkJob* job, bool removePartial)
 {
-	if (downloadJob) {
-		downloadJob->cancelAndDelete();
-		disconnect(downloadJob, SIGNAL(finished()), this, SLOT(downloadJobFinished()));
-		disconnect(downloadJob, SIGNAL(readyRead()), this, SLOT(downloadReadyRead()));
-		disconnect(downloadJob, SIGNAL(downloadPercent(int)), this, SLOT(downloadPercent(int)));
+	job->cancelAndDelete();
+	disconnect(job, SIGNAL(finished()), this, SLOT(downloadJobFinished()));
+	disconnect(job, SIGNAL(readyRead()), this, SLOT(downloadReadyRead()));
+	disconnect(job, SIGNAL(downloadProgress(qint64, qint64)), this, SLOT(downloadProgress(qint64, qint64)));
+	downloadJobs.removeAll(job);
 
-		QString dest = downloadJob->property(constDestProperty).toString();
-		QString partial = dest.isEmpty() ? QString() : QString(dest + constPartialExt);
-		if (!partial.isEmpty() && QFile::exists(partial)) {
-			QFile::remove(partial);
-		}
-		updateEpisode(downloadJob->property(constRssUrlProperty).toUrl(), downloadJob->origUrl(), Episode::NotDownloading);
-		downloadJob = nullptr;
+	QString dest = job->property(constDestProperty).toString();
+	if (removePartial && !dest.isEmpty()) {
+		PartialDownload::remove(dest);
+	}
+	updateEpisode(job->property(constRssUrlProperty).toUrl(), job->origUrl(), Episode::NotDownloading);
+	if (downloadJobs.isEmpty() && downloadRateTimer) {
+		downloadRateTimer->stop();
 	}
 }
 
 void PodcastService::doNextDownload()
 {
-	if (downloadJob) {
+	int maxDownloads = Settings::self()->podcastMaxDownloads();
+	while (downloadJobs.count() < maxDownloads && !toDownload.isEmpty()) {
+		DownloadEntry entry = toDownload.takeFirst();
+		QNetworkRequest req(entry.url);
+		// Continue from the end of any previous, interrupted, download
+		qint64 offset = PartialDownload::prepare(entry.dest, req);
+		NetworkJob* job = NetworkAccessManager::self()->get(req);
+		connect(job, SIGNAL(finished()), this, SLOT(downloadJobFinished()));
+		connect(job, SIGNAL(readyRead()), this, SLOT(downloadReadyRead()));
+		connect(job, SIGNAL(downloadProgress(qint64, qint64)), this, SLOT(downloadProgress(qint64, qint64)));
+		job->setProperty(constRssUrlProperty, entry.rssUrl);
+		job->setProperty(constDestProperty, entry.dest);
+		job->setProperty(constOffsetProperty, offset);
+		downloadJobs.append(job);
+		updateEpisode(entry.rssUrl, entry.url, 0);
+	}
+
+	if (downloadJobs.isEmpty()) {
+		if (downloadRateTimer) {
+			downloadRateTimer->stop();
+		}
 		return;
 	}
 
-	if (toDownload.isEmpty()) {
-		return;
+	downloadSlice = (Settings::self()->podcastDownloadRate() * 1024ll) / constDownloadTicks;
+	if (downloadSlice > 0) {
+		if (!downloadRateTimer) {
+			downloadRateTimer = new QTimer(this);
+			downloadRateTimer->setInterval(1000 / constDownloadTicks);
+			connect(downloadRateTimer, SIGNAL(timeout()), this, SLOT(downloadRateTimeout()));
+		}
+		if (!downloadRateTimer->isActive()) {
+			downloadBudget = downloadSlice;
+			downloadRateTimer->start();
+		}
+	}
+	else if (downloadRateTimer) {
+		downloadRateTimer->stop();
+	}
+}
+
+// Append up to maxBytes (or all, if negative) of the data received by job to its partial file
+qint64 PodcastService::writeDownload(NetworkJob* job, qint64 maxBytes)
+{
+	if (!job->actualJob() || job->attribute(QNetworkRequest::RedirectionTargetAttribute).isValid()) {
+		return 0;
+	}
+	if (maxBytes >= 0) {
+		// Limit how much is buffered, so that the rate limit also applies to the connection
+		job->actualJob()->setReadBufferSize(qMax(downloadSlice, 16384ll));
+	}
+
+	qint64 bytes = job->bytesAvailable();
+	if (maxBytes >= 0) {
+		bytes = qMin(bytes, maxBytes);
+	}
+	if (bytes <= 0) {
+		return 0;
 	}
 
-	DownloadEntry entry = toDownload.takeFirst();
-	downloadJob = NetworkAccessManager::self()->get(entry.url);
-	connect(downloadJob, SIGNAL(finished()), this, SLOT(downloadJobFinished()));
-	connect(downloadJob, SIGNAL(readyRead()), this, SLOT(downloadReadyRead()));
-	connect(downloadJob, SIGNAL(downloadPercent(int)), this, SLOT(downloadPercent(int)));
-	downloadJob->setProperty(constRssUrlProperty, entry.rssUrl);
-	downloadJob->setProperty(constDestProperty, entry.dest);
-	updateEpisode(entry.rssUrl, entry.url, 0);
+	int status = job->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+	if (200 != status && 206 != status) {
+		// Error page, etc. - discard it, and leave any partial file untouched
+		job->read(bytes);
+		return bytes;
+	}
 
-	QString partial = entry.dest + constPartialExt;
-	if (QFile::exists(partial)) {
-		QFile::remove(partial);
+	QString dest = job->property(constDestProperty).toString();
+	if (dest.isEmpty()) {
+		return 0;
+	}
+	if (!job->property(constStartedProperty).toBool()) {
+		// First data of this reply - either the range that was asked for (206), or the whole episode (200) as the
+		// server ignored the range, or the file has changed since the partial file was downloaded.
+		if (!PartialDownload::start(dest, job->actualJob())) {
+			restartDownload(job);
+			return 0;
+		}
+		job->setProperty(constStartedProperty, true);
+		if (200 == status) {
+			job->setProperty(constOffsetProperty, 0);
+		}
 	}
+	return PartialDownload::append(dest, job->actualJob(), bytes) ? bytes : 0;
 }
 
-void PodcastService::updateEpisode(const QUrl& rssUrl, const QUrl& url, int pc)
+// Reply did not continue the partial file, which has been removed - so download the whole episode. This is only
+// retried if a range was requested, as otherwise the server would just send the same reply.
+void PodcastService::restartDownload(NetworkJob* job)
 {
-	Podcast* pod = getPodcast(rssUrl);
-	if (pod) {
-		Episode* episode = pod->getEpisode(url);
-		if (episode && episode->downloadProg != pc) {
-			episode->downloadProg = pc;
-			QModelIndex idx = createIndex(pod->episodes.indexOf(episode), 0, (void*)episode);
-			emit dataChanged(idx, idx);
-		}
+	DownloadEntry entry(job->origUrl(), job->property(constRssUrlProperty).toUrl(), job->property(constDestProperty).toString());
+	bool resumed = job->property(constOffsetProperty).toLongLong() > 0;
+	cancelDownload(job, true);
+	if (resumed) {
+		toDownload.prepend(entry);
+		updateEpisode(entry.rssUrl, entry.url, Episode::QueuedForDownload);
 	}
+	doNextDownload();
 }
 
+// Remove partial downloads that can no longer be resumed, as their episode or podcast has been removed
 void PodcastService::clearPartialDownloads()
 {
 	QString dest = Settings::self()->podcastDownloadPath();
@@ -1206,11 +1327,39 @@ void PodcastService::clearPartialDownloads()
 	}
 
 	dest = Utils::fixPath(dest);
+	QSet<QString> episodes;
+	for (const Podcast* podcast : podcasts) {
+		QString podPath = dest + Utils::fixPath(encodeName(podcast->name));
+		for (const Episode* episode : podcast->episodes) {
+			episodes.insert(podPath + episodeFileName(episode->url));
+		}
+	}
+	// Episodes being downloaded are still wanted, even if their podcast is being removed
+	for (const NetworkJob* job : downloadJobs) {
+		episodes.insert(job->property(constDestProperty).toString());
+	}
+
 	QStringList sub = QDir(dest).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
 	for (const QString& d : sub) {
-		QStringList partials = QDir(dest + d).entryList(QStringList() << QLatin1Char('*') + constPartialExt, QDir::Files);
+		QString dir = dest + d + Utils::constDirSep;
+		QStringList partials = QDir(dir).entryList(PartialDownload::nameFilters(), QDir::Files);
 		for (const QString& p : partials) {
-			QFile::remove(dest + d + Utils::constDirSep + p);
+			if (!episodes.contains(PartialDownload::destFor(dir + p))) {
+				QFile::remove(dir + p);
+			}
+		}
+	}
+}
+
+void PodcastService::updateEpisode(const QUrl& rssUrl, const QUrl& url, int pc)
+{
+	Podcast* pod = getPodcast(rssUrl);
+	if (pod) {
+		Episode* episode = pod->getEpisode(url);
+		if (episode && episode->downloadProg != pc) {
+			episode->downloadProg = pc;
+			QModelIndex idx = createIndex(pod->episodes.indexOf(episode), 0, (void*)episode);
+			emit dataChanged(idx, idx);
 		}
 	}
 }
@@ -1218,86 +1367,89 @@ void PodcastService::clearPartialDownloads()
 void PodcastService::downloadJobFinished()
 {
 	NetworkJob* job = dynamic_cast<NetworkJob*>(sender());
-	if (!job || job != downloadJob) {
+	if (!job || !downloadJobs.contains(job)) {
 		return;
 	}
-	job->deleteLater();
-
 	QString dest = job->property(constDestProperty).toString();
-	QString partial = dest.isEmpty() ? QString() : QString(dest + constPartialExt);
+	bool complete = false;
+	int status = job->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
-	if (job->ok()) {
-		QString dest = job->property(constDestProperty).toString();
-		if (dest.isEmpty()) {
+	if (416 == status) {
+		// Range not satisfiable - the partial file is of no use
+		restartDownload(job);
+		return;
+	}
+	if (job->ok() && (200 == status || 206 == status)) {
+		// Write anything not yet read due to the rate limit
+		writeDownload(job, -1);
+		if (!downloadJobs.contains(job)) {
+			// Reply did not continue the partial file, and has been restarted
 			return;
 		}
-
-		QString partial = dest + constPartialExt;
-		if (QFile::exists(partial)) {
-			if (QFile::exists(dest)) {
-				QFile::remove(dest);
-			}
-			if (QFile::rename(partial, dest)) {
-				Podcast* pod = getPodcast(job->property(constRssUrlProperty).toUrl());
-				if (pod) {
-					Episode* episode = pod->getEpisode(job->origUrl());
-					if (episode) {
-						episode->localFile = dest;
-						pod->save();
-						QModelIndex idx = createIndex(pod->episodes.indexOf(episode), 0, (void*)episode);
-						emit dataChanged(idx, idx);
-					}
-				}
+		// Only if data was received, otherwise the partial file is not from this reply
+		complete = job->property(constStartedProperty).toBool();
+	}
+	// Otherwise, the partial file (which only ever contains episode data) is kept so that the download can be resumed
+	job->deleteLater();
+	downloadJobs.removeAll(job);
+
+	if (complete && !dest.isEmpty() && PartialDownload::complete(dest)) {
+		Podcast* pod = getPodcast(job->property(constRssUrlProperty).toUrl());
+		if (pod) {
+			Episode* episode = pod->getEpisode(job->origUrl());
+			if (episode) {
+				episode->localFile = dest;
+				pod->save();
+				QModelIndex idx = createIndex(pod->episodes.indexOf(episode), 0, (void*)episode);
+				emit dataChanged(idx, idx);
 			}
 		}
 	}
-	else if (!partial.isEmpty() && QFile::exists(partial)) {
-		QFile::remove(partial);
-	}
 	updateEpisode(job->property(constRssUrlProperty).toUrl(), job->origUrl(), Episode::NotDownloading);
-	downloadJob = nullptr;
 	doNextDownload();
 }
 
 void PodcastService::downloadReadyRead()
 {
 	NetworkJob* job = dynamic_cast<NetworkJob*>(sender());
-	if (!job || job != downloadJob) {
+	if (!job || !downloadJobs.contains(job)) {
 		return;
 	}
-	QString dest = job->property(constDestProperty).toString();
-	QString partial = dest.isEmpty() ? QString() : QString(dest + constPartialExt);
-	if (!partial.isEmpty()) {
-		QString dir = Utils::getDir(partial);
-		if (!QDir(dir).exists()) {
-			QDir(dir).mkpath(dir);
-		}
-		if (!QDir(dir).exists()) {
-			return;
-		}
-		QFile f(partial);
-		while (true) {
-			const qint64 bytes = job->bytesAvailable();
-			if (bytes <= 0) {
-				break;
-			}
-			if (!f.isOpen()) {
-				if (!f.open(QIODevice::Append)) {
-					return;
-				}
-			}
-			f.write(job->read(bytes));
-		}
+	if (downloadSlice > 0) {
+		// Anything over the budget is read on a later tick of downloadRateTimer
+		downloadBudget -= writeDownload(job, qMax(downloadBudget, 0ll));
+	}
+	else {
+		writeDownload(job, -1);
 	}
 }
 
-void PodcastService::downloadPercent(int pc)
+void PodcastService::downloadProgress(qint64 bytesReceived, qint64 bytesTotal)
 {
 	NetworkJob* job = dynamic_cast<NetworkJob*>(sender());
-	if (!job || job != downloadJob) {
+	if (!job || !downloadJobs.contains(job) || bytesTotal <= 0) {
 		return;
 	}
-	updateEpisode(job->property(constRssUrlProperty).toUrl(), job->origUrl(), pc);
+	// Include any previously downloaded part of the episode
+	qint64 offset = job->property(constOffsetProperty).toLongLong();
+	int pc = (((bytesReceived + offset) * 100.0) / (bytesTotal + offset)) + 0.5;
+	updateEpisode(job->property(constRssUrlProperty).toUrl(), job->origUrl(), qBound(0, pc, 100));
+}
+
+void PodcastService::downloadRateTimeout()
+{
+	downloadBudget = downloadSlice;
+	// Start with a different download each tick, so that each gets a share of the budget
+	if (downloadJobs.count() > 1) {
+		downloadJobs.append(downloadJobs.takeFirst());
+	}
+	const QList<NetworkJob*> jobs = downloadJobs;
+	for (NetworkJob* job : jobs) {
+		if (downloadBudget <= 0) {
+			break;
+		}
+		downloadBudget -= writeDownload(job, downloadBudget);
+	}
 }
 
 void PodcastService::startRssUpdateTimer()
@@ -1377,9 +1529,17 @@ void PodcastService::updateRss()
 		const QUrl& url = podcast->url;
 		updateUrls.insert(url);
 		if (!processingUrl(url)) {
-			addUrl(url, false);
+			rssQueue.append(url);
 		}
 	}
+	startRssJobs();
+}
+
+void PodcastService::startRssJobs()
+{
+	while (rssJobs.count() < constMaxRssJobs && !rssQueue.isEmpty()) {
+		addUrl(rssQueue.takeFirst(), false);
+	}
 }
 
 void PodcastService::currentMpdSong(const Song& s)
@@ -87,6 +87,8 @@ public:
 		QString fileName;
 		QString imageFile;
 		QUrl imageUrl;
+		QString etag;        // Validators from the last download of the RSS feed, used to
+		QString lastModified;// only download the feed again if it has changed
 		Song song;
 	};
 
@@ -150,7 +152,7 @@ public:
 	static QUrl fixUrl(const QUrl& orig);
 	static bool isUrlOk(const QUrl& u) { return QLatin1String("http") == u.scheme() || QLatin1String("https") == u.scheme(); }
 
-	bool isDownloading() const { return nullptr != downloadJob; }
+	bool isDownloading() const { return !downloadJobs.isEmpty(); }
 	void cancelAllDownloads();
 	void downloadPodcasts(Podcast* pod, const QList<Episode*>& episodes);
 	void deleteDownloadedPodcasts(Podcast* pod, const QList<Episode*>& episodes);
@@ -176,10 +178,13 @@ private:
 	void downloadEpisode(const Podcast* podcast, const QUrl& episode);
 	void cancelDownloads(const QList<Episode*> episodes);
 	void cancelDownload(const QUrl& url);
-	void cancelDownload();
+	void cancelDownload(NetworkJob* job, bool removePartial);
 	void doNextDownload();
-	void updateEpisode(const QUrl& rssUrl, const QUrl& url, int pc);
+	qint64 writeDownload(NetworkJob* job, qint64 maxBytes);
+	void restartDownload(NetworkJob* job);
 	void clearPartialDownloads();
+	void updateEpisode(const QUrl& rssUrl, const QUrl& url, int pc);
+	void startRssJobs();
 
 private Q_SLOTS:
 	void loadAll();
@@ -188,7 +193,8 @@ private Q_SLOTS:
 	void currentMpdSong(const Song& s);
 	void downloadJobFinished();
 	void downloadReadyRead();
-	void downloadPercent(int pc);
+	void downloadProgress(qint64 bytesReceived, qint64 bytesTotal);
+	void downloadRateTimeout();
 
 private:
 	struct DownloadEntry {
@@ -202,8 +208,12 @@ private:
 
 	QList<Podcast*> podcasts;
 	QList<NetworkJob*> rssJobs;
-	NetworkJob* downloadJob;
+	QList<QUrl> rssQueue;
+	QList<NetworkJob*> downloadJobs;
 	QList<DownloadEntry> toDownload;
+	QTimer* downloadRateTimer;
+	qint64 downloadSlice; // Bytes that may be read per tick of downloadRateTimer, 0 if not limited
+	qint64 downloadBudget;// Bytes that may still be read in the current tick
 	QTimer* rssUpdateTimer;
 	QDateTime lastRssUpdate;
 	QDateTime lastDelete;
@@ -52,8 +52,8 @@ SmartPlaylistsPage::SmartPlaylistsPage(QWidget* p)
 
 	connect(this, SIGNAL(search(QByteArray, QString)), MPDConnection::self(), SLOT(search(QByteArray, QString)));
 	connect(MPDConnection::self(), SIGNAL(searchResponse(QString, QList<Song>)), this, SLOT(searchResponse(QString, QList<Song>)));
-	connect(this, SIGNAL(getRating(QString)), MPDConnection::self(), SLOT(getRating(QString)));
-	connect(MPDConnection::self(), SIGNAL(rating(QString, quint8)), this, SLOT(rating(QString, quint8)));
+	connect(this, SIGNAL(getRatings(QStringList, QString)), MPDConnection::self(), SLOT(getRatings(QStringList, QString)));
+	connect(MPDConnection::self(), SIGNAL(ratingsRetrieved(QString, QMap<QString, quint8>)), this, SLOT(ratings(QString, QMap<QString, quint8>)));
 	connect(view, SIGNAL(itemsSelected(bool)), this, SLOT(controlActions()));
 	connect(view, SIGNAL(headerClicked(int)), SLOT(headerClicked(int)));
 	connect(addAction, SIGNAL(triggered()), SLOT(addNew()));
@@ -215,38 +215,36 @@ void SmartPlaylistsPage::filterCommand()
 				command.toCheck.append(s.file);
 			}
 		}
-		command.checking = command.toCheck.takeFirst();
-		emit getRating(command.checking);
+		command.checkingRatings = true;
+		emit getRatings(command.toCheck, "R:" + QString::number(command.id));
+		command.toCheck.clear();
 	}
 	else {
 		addSongsToPlayQueue();
 	}
 }
 
-void SmartPlaylistsPage::rating(const QString& file, quint8 val)
+void SmartPlaylistsPage::ratings(const QString& id, const QMap<QString, quint8>& values)
 {
-	if (command.isEmpty() || file != command.checking) {
+	if (id.length() < 3 || id.mid(2).toUInt() != command.id || command.isEmpty() || !command.checkingRatings) {
 		return;
 	}
 
-	for (auto& s : command.songs) {
-		if (s.file == file) {
-			s.rating = val;
-			if (command.filterRating && (val < command.ratingFrom || val > command.ratingTo) && !(command.includeUnrated && val == 0)) {
-				command.songs.remove(s);
-			}
-			break;
+	command.checkingRatings = false;
+	QSet<Song> toRemove;
+	for (const auto& s : command.songs) {
+		QMap<QString, quint8>::ConstIterator it = values.constFind(s.file);
+		if (it == values.constEnd()) {
+			continue;
+		}
+		quint8 val = it.value();
+		s.rating = val;
+		if (command.filterRating && (val < command.ratingFrom || val > command.ratingTo) && !(command.includeUnrated && val == 0)) {
+			toRemove.insert(s);
 		}
 	}
-
-	if (command.toCheck.isEmpty()) {
-		command.checking.clear();
-		addSongsToPlayQueue();
-	}
-	else {
-		command.checking = command.toCheck.takeFirst();
-		emit getRating(command.checking);
-	}
+	command.songs.subtract(toRemove);
+	addSongsToPlayQueue();
 }
 
 static bool sortAscending = true;
@@ -48,7 +48,7 @@ class SmartPlaylistsPage : public SinglePageWidget {
 			excludeRules.clear();
 			songs.clear();
 			toCheck.clear();
-			checking.clear();
+			checkingRatings = false;
 		}
 		bool haveRating() const { return ratingFrom >= 0 && ratingTo > 0; }
 
@@ -76,7 +76,7 @@ class SmartPlaylistsPage : public SinglePageWidget {
 
 		quint32 id;
 
-		QString checking;
+		bool checkingRatings = false;
 		QSet<Song> songs;
 		QStringList toCheck;
 	};
@@ -88,7 +88,7 @@ public:
 
 Q_SIGNALS:
 	void search(const QByteArray& query, const QString& id);
-	void getRating(const QString& file);
+	void getRatings(const QStringList& files, const QString& id);
 	void error(const QString& str);
 
 private Q_SLOTS:
@@ -97,7 +97,7 @@ private Q_SLOTS:
 	void remove();
 	void headerClicked(int level);
 	void searchResponse(const QString& id, const QList<Song>& songs);
-	void rating(const QString& file, quint8 val);
+	void ratings(const QString& id, const QMap<QString, quint8>& values);
 
 private:
 	void doSearch() override;
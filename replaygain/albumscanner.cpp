@@ -25,9 +25,74 @@
 #include "config.h"
 #include <QApplication>
 #include <QProcess>
+#include <cmath>
 
-AlbumScanner::AlbumScanner(const QMap<int, QString>& files)
-	: proc(0)
+static const double constReferenceLevel = -18.0;
+static const double constMinLoudness = -70.0;
+static const double constRelativeGate = -10.0;
+
+static inline double binEnergy(int bin)
+{
+	// Use the centre of the bin, as libebur128 does for its histogram mode
+	return std::pow(10.0, ((constMinLoudness + (bin + 0.5) / 10.0) + 0.691) / 10.0);
+}
+
+static inline double energyToLoudness(double energy)
+{
+	return 10.0 * std::log10(energy) - 0.691;
+}
+
+double AlbumScanner::referenceGain(double loudness)
+{
+	return qBound(-51.0, constReferenceLevel - loudness, 51.0);
+}
+
+AlbumScanner::Values AlbumScanner::calcAlbumValues(const QList<Values>& tracks)
+{
+	Values album;
+	Histogram combined;
+	for (const Values& t : tracks) {
+		if (!t.ok) {
+			continue;
+		}
+		album.ok = true;
+		album.peak = qMax(album.peak, t.peak);
+		for (Histogram::ConstIterator it = t.histogram.constBegin(), end = t.histogram.constEnd(); it != end; ++it) {
+			combined[it.key()] += it.value();
+		}
+	}
+	if (!album.ok || combined.isEmpty()) {
+		album.ok = false;
+		return album;
+	}
+
+	// BS.1770 gating - blocks below -70 LUFS are not in the histogram, so only the relative gate is applied here
+	double energy = 0.0;
+	quint64 blocks = 0;
+	for (Histogram::ConstIterator it = combined.constBegin(), end = combined.constEnd(); it != end; ++it) {
+		energy += binEnergy(it.key()) * it.value();
+		blocks += it.value();
+	}
+	double relativeThreshold = energyToLoudness(energy / blocks) + constRelativeGate;
+	int startBin = qMax(0, static_cast<int>(std::ceil((relativeThreshold - constMinLoudness) * 10.0)));
+
+	energy = 0.0;
+	blocks = 0;
+	for (Histogram::ConstIterator it = combined.lowerBound(startBin), end = combined.constEnd(); it != end; ++it) {
+		energy += binEnergy(it.key()) * it.value();
+		blocks += it.value();
+	}
+	if (0 == blocks) {
+		album.ok = false;
+		return album;
+	}
+	album.loudness = energyToLoudness(energy / blocks);
+	album.gain = referenceGain(album.loudness);
+	return album;
+}
+
+AlbumScanner::AlbumScanner(const QMap<int, QString>& files, int jobs)
+	: proc(0), maxThreads(qMin(jobs, static_cast<int>(files.count()))), activeThreads(maxThreads)
 {
 	QMap<int, QString>::ConstIterator it = files.constBegin();
 	QMap<int, QString>::ConstIterator end = files.constEnd();
@@ -51,7 +116,7 @@ void AlbumScanner::start()
 		proc->setReadChannel(QProcess::StandardOutput);
 		connect(proc, SIGNAL(finished(int)), this, SLOT(procFinished()));
 		connect(proc, SIGNAL(readyReadStandardOutput()), this, SLOT(read()));
-		proc->start(Utils::helper(QLatin1String("cantata-replaygain")), fileNames, QProcess::ReadOnly);
+		proc->start(Utils::helper(QLatin1String("cantata-replaygain")), QStringList() << QLatin1String("--jobs=") + QString::number(maxThreads) << fileNames, QProcess::ReadOnly);
 	}
 }
 
@@ -69,6 +134,8 @@ void AlbumScanner::stop()
 static const QString constProgLine = QLatin1String("PROGRESS: ");
 static const QString constTrackLine = QLatin1String("TRACK: ");
 static const QString constAlbumLine = QLatin1String("ALBUM: ");
+static const QString constActiveLine = QLatin1String("ACTIVE: ");
+static const QString constHistogramLine = QLatin1String("HISTOGRAM: ");
 
 void AlbumScanner::read()
 {
@@ -76,10 +143,14 @@ void AlbumScanner::read()
 		return;
 	}
 
-	QString output = proc->readAllStandardOutput().data();
-	if (output.isEmpty()) {
+	// Only handle complete lines, histogram lines can be long enough to be split across reads
+	buffer += proc->readAllStandardOutput();
+	int lastNewLine = buffer.lastIndexOf('\n');
+	if (lastNewLine < 0) {
 		return;
 	}
+	QString output = QString::fromUtf8(buffer.left(lastNewLine));
+	buffer.remove(0, lastNewLine + 1);
 
 	QStringList lines = output.split("\n", CANTATA_SKIP_EMPTY);
 
@@ -87,6 +158,10 @@ void AlbumScanner::read()
 		if (line.startsWith(constProgLine)) {
 			emit progress(line.mid(constProgLine.length()).toUInt());
 		}
+		else if (line.startsWith(constActiveLine)) {
+			activeThreads = line.mid(constActiveLine.length()).toInt();
+			emit threadsChanged();
+		}
 		else if (line.startsWith(constTrackLine)) {
 			QStringList parts = line.mid(constTrackLine.length()).split(" ", CANTATA_SKIP_EMPTY);
 			if (!parts.isEmpty()) {
@@ -97,9 +172,25 @@ void AlbumScanner::read()
 					vals.peak = parts[2].toDouble();
 					vals.ok = true;
 				}
+				if (parts.length() >= 4) {
+					vals.loudness = parts[3].toDouble();
+				}
+				vals.histogram = tracks[trackIndexMap[num]].histogram;
 				tracks[trackIndexMap[num]] = vals;
 			}
 		}
+		else if (line.startsWith(constHistogramLine)) {
+			QStringList parts = line.mid(constHistogramLine.length()).split(" ", CANTATA_SKIP_EMPTY);
+			if (!parts.isEmpty()) {
+				Histogram& histogram = tracks[trackIndexMap[parts[0].toInt()]].histogram;
+				for (int i = 1; i < parts.length(); ++i) {
+					int sep = parts.at(i).indexOf(':');
+					if (sep > 0) {
+						histogram[parts.at(i).left(sep).toUShort()] = parts.at(i).mid(sep + 1).toUInt();
+					}
+				}
+			}
+		}
 		else if (line.startsWith(constAlbumLine)) {
 			QStringList parts = line.mid(constAlbumLine.length()).split(" ", CANTATA_SKIP_EMPTY);
 			if (parts.length() >= 2) {
@@ -113,6 +204,7 @@ void AlbumScanner::read()
 
 void AlbumScanner::procFinished()
 {
+	read();
 	setFinished(true);
 	emit done();
 }
@@ -34,17 +34,28 @@ class AlbumScanner : public Job {
 	Q_OBJECT
 
 public:
+	// Count of 400ms blocks, per 0.1 LU from -70 LUFS - as output by cantata-replaygain
+	typedef QMap<quint16, quint32> Histogram;
+
 	struct Values {
-		Values() : gain(0.0), peak(0.0), ok(false) {}
+		Values() : gain(0.0), peak(0.0), loudness(0.0), ok(false) {}
 		double gain;
 		double peak;
+		double loudness;
+		Histogram histogram;
 		bool ok;
 	};
 
-	AlbumScanner(const QMap<int, QString>& files);
+	// Gain required to bring loudness (LUFS) to the ReplayGain reference level
+	static double referenceGain(double loudness);
+	// Calculate album values from the histograms of its tracks
+	static Values calcAlbumValues(const QList<Values>& tracks);
+
+	AlbumScanner(const QMap<int, QString>& files, int jobs);
 	~AlbumScanner();
 	virtual void start();
 	virtual void stop();
+	virtual int threads() const { return activeThreads; }
 	const Values& albumValues() const { return album; }
 	const QMap<int, Values> trackValues() const { return tracks; }
 
@@ -54,10 +65,13 @@ private Q_SLOTS:
 
 private:
 	QProcess* proc;
+	int maxThreads;
+	int activeThreads;
 	Values album;
 	QMap<int, Values> tracks;
 	QMap<int, int> trackIndexMap;
 	QStringList fileNames;
+	QByteArray buffer;
 };
 
 #endif
@@ -20,110 +20,103 @@ extern "C" {
 #endif
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
-#if LIBAVFORMAT_VERSION_MAJOR >= 54
 #include <libavutil/channel_layout.h>
-#endif
+#include <libswresample/swresample.h>
 #ifdef __cplusplus
 }
 #endif
 #include "ebur128.h"
 #include "ffmpeginput.h"
-#include <QByteArray>
 #include <QFile>
-#include <QList>
 #include <QMutex>
 #include <QString>
 
 static QMutex mutex;
 
-#ifndef AVCODEC_MAX_AUDIO_FRAME_SIZE
-#define AVCODEC_MAX_AUDIO_FRAME_SIZE 192000// 1 second of 48khz 32bit audio
-#endif
-
-#if defined FF_INPUT_BUFFER_PADDING_SIZE
-#define FFMPEG_INPUT_BUFFER_PADDING_SIZE FF_INPUT_BUFFER_PADDING_SIZE
-#elif defined AV_INPUT_BUFFER_PADDING_SIZE
-#define FFMPEG_INPUT_BUFFER_PADDING_SIZE AV_INPUT_BUFFER_PADDING_SIZE
-#else
-#define FFMPEG_INPUT_BUFFER_PADDING_SIZE 32
-#endif
-
-#define BUFFER_SIZE ((((AVCODEC_MAX_AUDIO_FRAME_SIZE * 3) / 2) * sizeof(int16_t)) + FFMPEG_INPUT_BUFFER_PADDING_SIZE)
-
 #if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 89, 100)// Not 100% of version here!
 #define GET_CODEC_TYPE(A) A->codecpar->codec_type
 #else
 #define GET_CODEC_TYPE(A) A->codec->codec_type
 #endif
 
-#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 24, 0)
-#define AV_FREE(PKT) av_packet_unref(PKT)
-#else
-#define AV_FREE(PKT) av_free_packet(PKT)
-#endif
-
 struct FfmpegInput::Handle {
 	Handle()
-		: formatContext(0), codecContext(0), codec(0)
-#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(53, 35, 0)
-		  ,
-		  frame(0), gotFrame(0), packetLeft(false), flushing(false)
-#endif
-		  ,
-		  audioStream(0), currentBytes(0)
+		: formatContext(0), codecContext(0), codec(0), swrContext(0), endOfFile(false), audioStream(0), buffer(0), bufferFrames(0)
 	{
 		packet = av_packet_alloc();
-		origPacket = NULL;
-		audioBuffer = (int16_t*)av_malloc(BUFFER_SIZE);
-#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(53, 35, 0)
-#if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(55, 39, 101)
-		frame = avcodec_alloc_frame();
-#else
 		frame = av_frame_alloc();
-#endif
-#endif
 	}
 	~Handle()
 	{
-		if (origPacket != NULL) {
-			av_packet_free(&origPacket);
-		}
-		if (packet != NULL) {
+		if (packet) {
 			av_packet_free(&packet);
 		}
-		if (audioBuffer) {
-			av_free(audioBuffer);
-		}
-#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(53, 35, 0)
 		if (frame) {
-#if LIBAVCODEC_VERSION_INT <= AV_VERSION_INT(54, 23, 100)
-			av_free(&frame);
-#elif LIBAVCODEC_VERSION_INT < AV_VERSION_INT(55, 39, 101)
-			avcodec_free_frame(&frame);
-#else
 			av_frame_free(&frame);
-#endif
 		}
-#endif
+		if (swrContext) {
+			swr_free(&swrContext);
+		}
+		if (buffer) {
+			av_free(buffer);
+		}
 	}
+	bool decodeFrame();
+	bool initConverter();
+
 	AVFormatContext* formatContext;
 	AVCodecContext* codecContext;
 	const AVCodec* codec;
-#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(53, 35, 0)
+	SwrContext* swrContext;
 	AVFrame* frame;
-	int gotFrame;
-	bool packetLeft;
-	bool flushing;
-	AVPacket* origPacket;
-#endif
 	AVPacket* packet;
+	bool endOfFile;
 	int audioStream;
-	int16_t* audioBuffer;
-	float buffer[BUFFER_SIZE / 2 + 1];
-	QList<QByteArray> bufferList;
-	size_t currentBytes;
+	float* buffer;
+	size_t bufferFrames;
 };
 
+// Decode the next frame of the audio stream into frame. Returns false at the end of the stream.
+bool FfmpegInput::Handle::decodeFrame()
+{
+	for (;;) {
+		int ret = avcodec_receive_frame(codecContext, frame);
+		if (0 == ret) {
+			return true;
+		}
+		if (AVERROR(EAGAIN) != ret || endOfFile) {
+			return false;
+		}
+
+		if (av_read_frame(formatContext, packet) < 0) {
+			// Enter draining mode, so that the decoder returns any frames it has buffered
+			endOfFile = true;
+			avcodec_send_packet(codecContext, NULL);
+			continue;
+		}
+		if (packet->stream_index == audioStream) {
+			// Corrupt packets are skipped, as the old decode API did
+			avcodec_send_packet(codecContext, packet);
+		}
+		av_packet_unref(packet);
+	}
+}
+
+// Converter from whatever the decoder outputs to interleaved float, in the codec's channel layout
+bool FfmpegInput::Handle::initConverter()
+{
+	if (swrContext) {
+		return true;
+	}
+	if (swr_alloc_set_opts2(&swrContext, &codecContext->ch_layout, AV_SAMPLE_FMT_FLT, codecContext->sample_rate,
+	                        &frame->ch_layout, (AVSampleFormat)frame->format, frame->sample_rate, 0, NULL) < 0 ||
+	    swr_init(swrContext) < 0) {
+		swr_free(&swrContext);
+		return false;
+	}
+	return true;
+}
+
 void FfmpegInput::init()
 {
 	static int i = false;
@@ -347,339 +340,53 @@ bool FfmpegInput::setChannelMap(int* st) const
 	return false;
 }
 
-size_t FfmpegInput::readFrames()
+bool FfmpegInput::allocateBuffer()
 {
 	if (!handle || !channels()) {
-		return 0;
-	}
-
-	size_t bufferPosition = 0;
-
-	while (handle->currentBytes < BUFFER_SIZE) {
-		size_t numberRead = readOnePacket();
-		if (!numberRead) {
-			break;
-		}
-		size_t bufferSize = numberRead * channels() * sizeof(float);
-		handle->bufferList.append(QByteArray(reinterpret_cast<const char*>(handle->buffer), bufferSize));
-		handle->currentBytes += bufferSize;
+		return false;
 	}
 
-	while (handle->bufferList.count() && handle->bufferList.first().size() + bufferPosition <= BUFFER_SIZE) {
-		QByteArray b = handle->bufferList.takeAt(0);
-		memcpy((char*)handle->buffer + bufferPosition, b.constData(), b.size());
-		bufferPosition += b.size();
-		handle->currentBytes -= b.size();
-	}
-
-	return bufferPosition / sizeof(float) / channels();
-}
-
-#if LIBAVCODEC_VERSION_MAJOR >= 54
-static int decodePacket(FfmpegInput::Handle* handle)
-{
-#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(57, 89, 100)// Not 100% of version here!
-	int ret = avcodec_receive_frame(handle->codecContext, handle->frame);
-	if (0 == ret) {
-		handle->gotFrame = true;
-	}
-	if (AVERROR(EAGAIN) == ret) {
-		ret = 0;
-	}
-	if (0 == ret) {
-		ret = avcodec_send_packet(handle->codecContext, handle->packet);
+	if (!handle->buffer) {
+		// 1 second of audio, aligned so that swresample can use its SIMD conversions
+		handle->bufferFrames = sampleRate();
+		handle->buffer = (float*)av_malloc(handle->bufferFrames * channels() * sizeof(float));
 	}
-	if (AVERROR(EAGAIN) == ret) {
-		ret = 0;
-	}
-	return ret < 0 ? ret : handle->packet->size;
-#else
-	int ret = avcodec_decode_audio4(handle->codecContext, handle->frame, &handle->gotFrame, handle->packet);
-	if (ret < 0) {
-		return ret;
-	}
-	return FFMIN(ret, handle->packet->size);
-#endif
+	return handle->buffer;
 }
 
-size_t FfmpegInput::readOnePacket()
+size_t FfmpegInput::readFrames()
 {
-	if (!handle) {
+	if (!handle || !channels() || !allocateBuffer()) {
 		return 0;
 	}
 
-start:
-	if (handle->flushing) {
-		handle->packet->data = NULL;
-		handle->packet->size = 0;
-		decodePacket(handle);
-		if (!handle->gotFrame) {
-			return 0;
-		}
-		else {
-			goto write_to_buffer;
-		}
-	}
-
-	if (handle->packetLeft) {
-		goto packetLeft;
-	}
-
-	//next_frame:
-	for (;;) {
-		if (av_read_frame(handle->formatContext, handle->packet) < 0) {
-			handle->flushing = true;
-			goto start;
-		}
-		if (handle->packet->stream_index != handle->audioStream) {
-			AV_FREE(handle->packet);
-			continue;
-		}
-		else {
-			break;
-		}
-	}
-
-	int ret;
-	if (handle->origPacket != NULL) {
-		AV_FREE(handle->origPacket);
-	}
-	handle->origPacket = av_packet_clone(handle->packet);
-packetLeft:
-	ret = decodePacket(handle);
-	if (ret < 0) {
-		goto free_packet;
-	}
-	handle->packet->data += ret;
-	handle->packet->size -= ret;
-	if (handle->packet->size > 0) {
-		handle->packetLeft = true;
-	}
-	else {
-	free_packet:
-		AV_FREE(handle->origPacket);
-		handle->origPacket = NULL;
-		handle->packetLeft = false;
-	}
-
-	if (!handle->gotFrame) {
-		goto start;
-	}
-
-write_to_buffer:;
-	size_t numberRead = handle->frame->nb_samples;
-	/* TODO: fix this */
-	int numChannels = handle->codecContext->ch_layout.nb_channels;
-	// channels = handle->frame->channels;
-
-	if (handle->frame->nb_samples * numChannels > (int)sizeof handle->buffer) {
-		return 0;
-	}
-
-	switch (handle->codecContext->sample_fmt) {
-	case AV_SAMPLE_FMT_S16: {
-		int16_t* dataShort = (int16_t*)handle->frame->extended_data[0];
-		for (int i = 0; i < handle->frame->nb_samples * numChannels; ++i) {
-			handle->buffer[i] = ((float)dataShort[i]) / qMax(-(float)SHRT_MIN, (float)SHRT_MAX);
-		}
-		break;
-	}
-	case AV_SAMPLE_FMT_S32: {
-		int32_t* dataInt = (int32_t*)handle->frame->extended_data[0];
-		for (int i = 0; i < handle->frame->nb_samples * numChannels; ++i) {
-			handle->buffer[i] = ((float)dataInt[i]) / qMax(-(float)INT_MIN, (float)INT_MAX);
-		}
-		break;
-	}
-	case AV_SAMPLE_FMT_FLT: {
-		float* dataFloat = (float*)handle->frame->extended_data[0];
-		for (int i = 0; i < handle->frame->nb_samples * numChannels; ++i) {
-			handle->buffer[i] = dataFloat[i];
-		}
-		break;
-	}
-	case AV_SAMPLE_FMT_DBL: {
-		double* dataDouble = (double*)handle->frame->extended_data[0];
-		for (int i = 0; i < handle->frame->nb_samples * numChannels; ++i) {
-			handle->buffer[i] = (float)dataDouble[i];
-		}
-		break;
-	}
-	case AV_SAMPLE_FMT_S16P: {
-		uint8_t** ed = handle->frame->extended_data;
-		for (int i = 0; i < handle->frame->nb_samples * numChannels; ++i) {
-			int currentChannel = i / handle->frame->nb_samples;
-			int currentSample = i % handle->frame->nb_samples;
-			handle->buffer[currentSample * numChannels + currentChannel] = ((float)((int16_t*)ed[currentChannel])[currentSample]) / qMax(-(float)SHRT_MIN, (float)SHRT_MAX);
-		}
-		break;
-	}
-	case AV_SAMPLE_FMT_S32P: {
-		uint8_t** ed = handle->frame->extended_data;
-		for (int i = 0; i < handle->frame->nb_samples * numChannels; ++i) {
-			int currentChannel = i / handle->frame->nb_samples;
-			int currentSample = i % handle->frame->nb_samples;
-			handle->buffer[currentSample * numChannels + currentChannel] = ((float)((int32_t*)ed[currentChannel])[currentSample]) / qMax(-(float)INT_MIN, (float)INT_MAX);
-		}
-		break;
-	}
-	case AV_SAMPLE_FMT_FLTP: {
-		uint8_t** ed = handle->frame->extended_data;
-		for (int i = 0; i < handle->frame->nb_samples * numChannels; ++i) {
-			int currentChannel = i / handle->frame->nb_samples;
-			int currentSample = i % handle->frame->nb_samples;
-			handle->buffer[currentSample * numChannels + currentChannel] = ((float*)ed[currentChannel])[currentSample];
-		}
-		break;
-	}
-	case AV_SAMPLE_FMT_DBLP: {
-		uint8_t** ed = handle->frame->extended_data;
-		for (int i = 0; i < handle->frame->nb_samples * numChannels; ++i) {
-			int currentChannel = i / handle->frame->nb_samples;
-			int currentSample = i % handle->frame->nb_samples;
-			handle->buffer[currentSample * numChannels + currentChannel] = ((double*)ed[currentChannel])[currentSample];
-		}
-		break;
-	}
-	case AV_SAMPLE_FMT_U8:
-	case AV_SAMPLE_FMT_NONE:
-	case AV_SAMPLE_FMT_NB:
-	default:
-		numberRead = 0;
-		goto out;
-	}
-
-out:
-	return numberRead;
-}
-#else
-#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(53, 35, 0)
-static int decodeAudio(FfmpegInput::Handle* handle, int* frame_size_ptr)
-{
-	int ret, got_frame = 0;
-
-	if (!handle->frame) {
-		return AVERROR(ENOMEM);
-	}
-
-#if LIBAVFORMAT_VERSION_INT < AV_VERSION_INT(55, 0, 0)
-	if (handle->codecContext->get_buffer != avcodec_default_get_buffer) {
-		handle->codecContext->get_buffer = avcodec_default_get_buffer;
-		handle->codecContext->release_buffer = avcodec_default_release_buffer;
-	}
-#endif
-
-	ret = avcodec_decode_audio4(handle->codecContext, handle->frame, &got_frame, handle->packet);
+	// Samples are converted straight from the decoded frames into buffer. If a frame does not
+	// fit, swresample keeps the remainder, and this is output first on the next call.
+	size_t numberRead = 0;
+	while (numberRead < handle->bufferFrames) {
+		uint8_t* out = (uint8_t*)(handle->buffer + (numberRead * channels()));
+		int space = (int)(handle->bufferFrames - numberRead);
+		int converted = 0;
 
-	if (ret >= 0 && got_frame) {
-		int ch, plane_size;
-		int planar = av_sample_fmt_is_planar(handle->codecContext->sample_fmt);
-		int data_size = av_samples_get_buffer_size(&plane_size, handle->codecContext->channels,
-		                                           handle->frame->nb_samples, handle->codecContext->sample_fmt, 1);
-		if (*frame_size_ptr < data_size) {
-			return AVERROR(EINVAL);
+		if (handle->swrContext && swr_get_out_samples(handle->swrContext, 0) > 0) {
+			converted = swr_convert(handle->swrContext, &out, space, NULL, 0);
 		}
-
-		memcpy(handle->audioBuffer, handle->frame->extended_data[0], plane_size);
-
-		if (planar && handle->codecContext->channels > 1) {
-			uint8_t* out = ((uint8_t*)(handle->audioBuffer)) + plane_size;
-			for (ch = 1; ch < handle->codecContext->channels; ch++) {
-				memcpy(out, handle->frame->extended_data[ch], plane_size);
-				out += plane_size;
+		if (0 == converted) {
+			if (!handle->decodeFrame() || !handle->initConverter()) {
+				break;
 			}
+			converted = swr_convert(handle->swrContext, &out, space, (const uint8_t**)handle->frame->extended_data, handle->frame->nb_samples);
+			av_frame_unref(handle->frame);
 		}
-		*frame_size_ptr = data_size;
-	}
-	else {
-		*frame_size_ptr = 0;
-	}
 
-	return ret;
-}
-#endif
-
-size_t FfmpegInput::readOnePacket()
-{
-	if (!handle) {
-		return 0;
-	}
-
-next_frame:
-	for (;;) {
-		if (av_read_frame(handle->formatContext, handle->packet) < 0) {
-			return 0;
-		}
-		if (handle->packet->stream_index == handle->audioStream) {
+		if (converted < 0) {
 			break;
 		}
-		AV_FREE(handle->packet);
-	}
-
-	size_t numberRead = 0;
-	int dataSize = BUFFER_SIZE;
-#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(53, 35, 0)
-	int len = decodeAudio(handle, &dataSize);
-#elif LIBAVCODEC_VERSION_MAJOR >= 53 || (LIBAVCODEC_VERSION_MAJOR == 52 && LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(52, 23, 0))
-	int len = avcodec_decode_audio3(handle->codecContext, handle->audioBuffer, &dataSize, handle->packet);
-#else
-	int len = avcodec_decode_audio2(handle->codecContext, handle->audioBuffer, &dataSize, handle->packet->data, handle->packet->size);
-#endif
-	if (len < 0) {
-		goto out;
-	}
-
-	/* No data used, (happens with metadata frames for example) */
-	if (len <= 0) {
-		AV_FREE(handle->packet);
-		goto next_frame;
-	}
-	switch (handle->codecContext->sample_fmt) {
-	case SAMPLE_FMT_S16: {
-		int16_t* dataShort = (int16_t*)handle->audioBuffer;
-		numberRead = (size_t)dataSize / sizeof(int16_t) / (size_t)handle->codecContext->channels;
-		for (unsigned int i = 0; i < (size_t)dataSize / sizeof(int16_t); ++i) {
-			handle->buffer[i] = ((float)dataShort[i]) / qMax(-(float)SHRT_MIN, (float)SHRT_MAX);
-		}
-		break;
-	}
-	case SAMPLE_FMT_S32: {
-		int32_t* dataInt = (int32_t*)handle->audioBuffer;
-		numberRead = (size_t)dataSize / sizeof(int32_t) / (size_t)handle->codecContext->channels;
-		for (unsigned int i = 0; i < (size_t)dataSize / sizeof(int32_t); ++i) {
-			handle->buffer[i] = ((float)dataInt[i]) / qMax(-(float)INT_MIN, (float)INT_MAX);
-		}
-		break;
-	}
-	case SAMPLE_FMT_FLT: {
-		float* dataFloat = (float*)handle->audioBuffer;
-		numberRead = (size_t)dataSize / sizeof(float) / (size_t)handle->codecContext->channels;
-		for (unsigned int i = 0; i < (size_t)dataSize / sizeof(float); ++i) {
-			handle->buffer[i] = dataFloat[i];
-		}
-		break;
-	}
-	case SAMPLE_FMT_DBL: {
-		double* dataDouble = (double*)handle->audioBuffer;
-		numberRead = (size_t)dataSize / sizeof(double) / (size_t)handle->codecContext->channels;
-		for (unsigned int i = 0; i < (size_t)dataSize / sizeof(double); ++i) {
-			handle->buffer[i] = (float)dataDouble[i];
-		}
-		break;
-	}
-	case SAMPLE_FMT_U8:
-	case SAMPLE_FMT_NONE:
-	case SAMPLE_FMT_NB:
-	default:
-		numberRead = 0;
-		goto out;
+		numberRead += converted;
 	}
 
-out:
-	AV_FREE(handle->packet);
 	return numberRead;
 }
-#endif
 
 bool FfmpegInput::isFloatCodec() const
 {
@@ -26,14 +26,12 @@ public:
 	size_t totalFrames() const;
 	unsigned int channels() const;
 	unsigned long sampleRate() const;
+	bool allocateBuffer();
 	float* buffer() const;
 	bool setChannelMap(int* st) const;
 	size_t readFrames();
 	bool isFloatCodec() const;
 
-private:
-	size_t readOnePacket();
-
 private:
 	Handle* handle;
 };
@@ -89,10 +89,13 @@ void JobController::finishedWith(Job* job)
 
 void JobController::startJobs()
 {
-	while (active.count() < maxActive && !jobs.isEmpty()) {
+	// Start another job whilst any thread is free, even if the job will use more than are free. This
+	// keeps all threads busy, and any over-subscription only lasts until an active job winds down.
+	while (!jobs.isEmpty() && activeThreads() < maxActive) {
 		Job* job = jobs.takeAt(0);
 		active.append(job);
 		connect(job, SIGNAL(done()), this, SLOT(jobDone()), Qt::QueuedConnection);
+		connect(job, SIGNAL(threadsChanged()), this, SLOT(jobThreadsChanged()), Qt::QueuedConnection);
 		job->start();
 	}
 }
@@ -101,6 +104,7 @@ void JobController::cancel()
 {
 	for (Job* j : active) {
 		disconnect(j, SIGNAL(done()), this, SLOT(jobDone()));
+		disconnect(j, SIGNAL(threadsChanged()), this, SLOT(jobThreadsChanged()));
 		j->stop();
 	}
 	active.clear();
@@ -120,4 +124,18 @@ void JobController::jobDone()
 	startJobs();
 }
 
+void JobController::jobThreadsChanged()
+{
+	startJobs();
+}
+
+int JobController::activeThreads() const
+{
+	int count = 0;
+	for (Job* j : active) {
+		count += j->threads();
+	}
+	return count;
+}
+
 #include "moc_jobcontroller.cpp"
@@ -38,6 +38,8 @@ public:
 	virtual void requestAbort() { abortRequested = true; }
 	virtual void start() = 0;
 	virtual void stop() = 0;
+	// Number of threads (or processes) the job is currently keeping busy
+	virtual int threads() const { return 1; }
 	void setFinished(bool f);
 	bool success() { return finished; }
 
@@ -45,6 +47,7 @@ Q_SIGNALS:
 	void exec();
 	void progress(int);
 	void done();
+	void threadsChanged();
 
 protected:
 	bool abortRequested;
@@ -73,6 +76,7 @@ public:
 	static JobController* self();
 	JobController();
 
+	// Maximum number of threads that active jobs may use
 	void setMaxActive(int m);
 	void add(Job* job);
 	void finishedWith(Job* job);
@@ -81,6 +85,10 @@ public:
 
 private Q_SLOTS:
 	void jobDone();
+	void jobThreadsChanged();
+
+private:
+	int activeThreads() const;
 
 private:
 	int maxActive;
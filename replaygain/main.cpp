@@ -30,17 +30,24 @@
 int main(int argc, char* argv[])
 {
 	if (argc < 2) {
-		printf("Usage: %s <file 1..N>\n", argv[0]);
+		printf("Usage: %s [--jobs=<N>] <file 1..N>\n", argv[0]);
 		return -1;
 	}
 
 	QStringList fileNames;
+	int jobs = ReplayGain::constDefaultJobs;
 	for (int i = 0; i < argc - 1; ++i) {
-		fileNames.append(QString::fromUtf8(argv[i + 1]));
+		QString arg = QString::fromUtf8(argv[i + 1]);
+		if (0 == i && arg.startsWith(QLatin1String("--jobs="))) {
+			jobs = qMax(1, arg.mid(7).toInt());
+		}
+		else {
+			fileNames.append(arg);
+		}
 	}
 
 	QCoreApplication app(argc, argv);
-	ReplayGain* rg = new ReplayGain(fileNames);
+	ReplayGain* rg = new ReplayGain(fileNames, jobs);
 	QTimer::singleShot(0, rg, SLOT(scan()));
 	return app.exec();
 }
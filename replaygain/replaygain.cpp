@@ -32,11 +32,11 @@ static QString formatDouble(double d)
 	return QString::number(d, 'f', 10).replace(",", ".");
 }
 
-ReplayGain::ReplayGain(const QStringList& fileNames)
-	: QObject(0), files(fileNames), lastProgress(-1), totalScanned(0)
+ReplayGain::ReplayGain(const QStringList& fileNames, int jobs)
+	: QObject(0), files(fileNames), maxJobs(jobs), lastActive(jobs), lastProgress(-1), totalScanned(0)
 {
 	TrackScanner::init();
-	JobController::self()->setMaxActive(8);
+	JobController::self()->setMaxActive(maxJobs);
 }
 
 ReplayGain::~ReplayGain()
@@ -110,8 +110,16 @@ void ReplayGain::showResults()
 		TrackScanner* s = scanners[i];
 		const Track& t = tracks[i];
 		if (t.success && s->ok()) {
-			printf("TRACK: %d %s %s\n", i, formatDouble(TrackScanner::reference(s->results().loudness)).toLatin1().constData(),
-			       formatDouble(s->results().peakValue()).toLatin1().constData());
+			printf("TRACK: %d %s %s %s\n", i, formatDouble(TrackScanner::reference(s->results().loudness)).toLatin1().constData(),
+			       formatDouble(s->results().peakValue()).toLatin1().constData(),
+			       formatDouble(s->results().loudness).toLatin1().constData());
+			QByteArray histogram;
+			TrackScanner::Histogram::ConstIterator it = s->results().histogram.constBegin();
+			TrackScanner::Histogram::ConstIterator end = s->results().histogram.constEnd();
+			for (; it != end; ++it) {
+				histogram += ' ' + QByteArray::number(it.key()) + ':' + QByteArray::number(it.value());
+			}
+			printf("HISTOGRAM: %d%s\n", i, histogram.constData());
 			okScanners.append(s);
 		}
 		else {
@@ -156,6 +164,14 @@ void ReplayGain::scannerDone()
 		track.progress = 100;
 		showProgress();
 		totalScanned++;
+
+		// Let the caller know when we are using fewer threads, so that it can start another album
+		int active = qMin(maxJobs, static_cast<int>(files.count()) - totalScanned);
+		if (active < lastActive) {
+			lastActive = active;
+			printf("ACTIVE: %d\n", lastActive);
+			fflush(stdout);
+		}
 	}
 
 	if (toScan.isEmpty()) {
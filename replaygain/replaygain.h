@@ -35,7 +35,9 @@ class ReplayGain : public QObject {
 	Q_OBJECT
 
 public:
-	ReplayGain(const QStringList& fileNames);
+	static const int constDefaultJobs = 8;
+
+	ReplayGain(const QStringList& fileNames, int jobs = constDefaultJobs);
 	virtual ~ReplayGain();
 
 public Q_SLOTS:
@@ -60,6 +62,8 @@ private:
 	};
 
 	QStringList files;
+	int maxJobs;
+	int lastActive;
 	QMap<int, TrackScanner*> scanners;
 	QList<int> toScan;
 	QMap<int, Track> tracks;
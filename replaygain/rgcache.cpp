@@ -0,0 +1,180 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2022 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include "rgcache.h"
+#include "support/globalstatic.h"
+#include "support/utils.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QVariant>
+
+GLOBAL_STATIC(RgCache, instance)
+
+static const QLatin1String constDbName("replaygain");
+static const QLatin1String constFileName("replaygain.sql");
+
+static QByteArray toBlob(const AlbumScanner::Histogram& histogram)
+{
+	QByteArray data;
+	QDataStream stream(&data, QIODevice::WriteOnly);
+	stream << histogram;
+	return data;
+}
+
+static AlbumScanner::Histogram fromBlob(const QByteArray& data)
+{
+	AlbumScanner::Histogram histogram;
+	QDataStream stream(data);
+	stream >> histogram;
+	return QDataStream::Ok == stream.status() ? histogram : AlbumScanner::Histogram();
+}
+
+RgCache::RgCache()
+	: db(nullptr), failed(false)
+{
+}
+
+RgCache::~RgCache()
+{
+	if (db) {
+		db->close();
+		delete db;
+		QSqlDatabase::removeDatabase(constDbName);
+	}
+}
+
+bool RgCache::get(const QString& file, AlbumScanner::Values& vals)
+{
+	if (!init()) {
+		return false;
+	}
+
+	QFileInfo info(file);
+	if (!info.exists()) {
+		return false;
+	}
+
+	QSqlQuery query(*db);
+	query.prepare("select size, mtime, loudness, peak, histogram from tracks where file=:file");
+	query.bindValue(":file", file);
+	if (!query.exec() || !query.next() || query.value(0).toLongLong() != info.size() || query.value(1).toLongLong() != info.lastModified().toSecsSinceEpoch()) {
+		return false;
+	}
+
+	vals.loudness = query.value(2).toDouble();
+	vals.gain = AlbumScanner::referenceGain(vals.loudness);
+	vals.peak = query.value(3).toDouble();
+	vals.histogram = fromBlob(query.value(4).toByteArray());
+	// Album values cannot be calculated without the histogram, so treat as a miss
+	vals.ok = !vals.histogram.isEmpty();
+	return vals.ok;
+}
+
+void RgCache::add(const QMap<QString, AlbumScanner::Values>& vals)
+{
+	if (vals.isEmpty() || !init()) {
+		return;
+	}
+
+	db->transaction();
+	QSqlQuery query(*db);
+	query.prepare("insert or replace into tracks (file, size, mtime, loudness, peak, histogram) values(:file, :size, :mtime, :loudness, :peak, :histogram)");
+	QMap<QString, AlbumScanner::Values>::ConstIterator it = vals.constBegin();
+	QMap<QString, AlbumScanner::Values>::ConstIterator end = vals.constEnd();
+	for (; it != end; ++it) {
+		QFileInfo info(it.key());
+		if (!it.value().ok || it.value().histogram.isEmpty() || !info.exists()) {
+			continue;
+		}
+		query.bindValue(":file", it.key());
+		query.bindValue(":size", info.size());
+		query.bindValue(":mtime", info.lastModified().toSecsSinceEpoch());
+		query.bindValue(":loudness", it.value().loudness);
+		query.bindValue(":peak", it.value().peak);
+		query.bindValue(":histogram", toBlob(it.value().histogram));
+		query.exec();
+	}
+	db->commit();
+}
+
+void RgCache::touch(const QString& file)
+{
+	if (!init()) {
+		return;
+	}
+
+	QFileInfo info(file);
+	if (!info.exists()) {
+		return;
+	}
+	QSqlQuery query(*db);
+	query.prepare("update tracks set size=:size, mtime=:mtime where file=:file");
+	query.bindValue(":size", info.size());
+	query.bindValue(":mtime", info.lastModified().toSecsSinceEpoch());
+	query.bindValue(":file", file);
+	query.exec();
+}
+
+bool RgCache::init()
+{
+	if (db) {
+		return true;
+	}
+	if (failed) {
+		return false;
+	}
+
+	failed = true;
+	QSqlDatabase* d = new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE", constDbName));
+	if (!d->isValid()) {
+		delete d;
+		QSqlDatabase::removeDatabase(constDbName);
+		return false;
+	}
+	d->setDatabaseName(Utils::cacheDir(QString(), true) + constFileName);
+	if (!d->open()) {
+		delete d;
+		QSqlDatabase::removeDatabase(constDbName);
+		return false;
+	}
+	QSqlQuery(*d).exec("pragma journal_mode=wal");
+	if (!QSqlQuery(*d).exec("create table if not exists tracks ("
+	                        "file text primary key, "
+	                        "size integer, "
+	                        "mtime integer, "
+	                        "loudness real, "
+	                        "peak real, "
+	                        "histogram blob)")) {
+		d->close();
+		delete d;
+		QSqlDatabase::removeDatabase(constDbName);
+		return false;
+	}
+	db = d;
+	failed = false;
+	return true;
+}
@@ -0,0 +1,59 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2022 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef _RG_CACHE_H_
+#define _RG_CACHE_H_
+
+#include "albumscanner.h"
+#include <QString>
+
+class QSqlDatabase;
+
+/*
+ * Stores the results of scanning tracks, so that unchanged tracks do not need to be decoded
+ * again. Entries are keyed on the track's path, and only used if its size and modification
+ * time still match. The loudness histogram is stored, so that album values can be calculated
+ * for albums where only some tracks need scanning.
+ */
+class RgCache {
+public:
+	static RgCache* self();
+
+	RgCache();
+	~RgCache();
+
+	bool get(const QString& file, AlbumScanner::Values& vals);
+	void add(const QMap<QString, AlbumScanner::Values>& vals);
+	// Update the stored size and modification time, after the file's tags have been written
+	void touch(const QString& file);
+
+private:
+	bool init();
+
+private:
+	QSqlDatabase* db;
+	bool failed;
+};
+
+#endif
@@ -29,6 +29,7 @@
 #include "jobcontroller.h"
 #include "mpd-interface/cuefile.h"
 #include "mpd-interface/mpdconnection.h"
+#include "rgcache.h"
 #include "support/action.h"
 #include "support/icon.h"
 #include "support/messagebox.h"
@@ -44,6 +45,7 @@
 #include <QHeaderView>
 #include <QLabel>
 #include <QProgressBar>
+#include <QThread>
 #include <QTreeWidget>
 #include <algorithm>
 
@@ -58,6 +60,10 @@ enum Columns {
 };
 
 static int iCount = 0;
+// Only show an estimate of the time remaining once we have scanned for this long
+static const qint64 constMinEtaTime = 5000;
+// Used, for the estimate, when a track's duration is not known
+static const quint32 constDefaultTrackTime = 240;
 
 int RgDialog::instanceCount()
 {
@@ -70,7 +76,7 @@ static inline void setResizeMode(QHeaderView* hdr, int idx, QHeaderView::ResizeM
 }
 
 RgDialog::RgDialog(QWidget* parent)
-	: SongDialog(parent, "RgDialog", QSize(800, 400)), state(State_Idle), totalToScan(0), tagReader(0), autoScanTags(false)
+	: SongDialog(parent, "RgDialog", QSize(800, 400)), state(State_Idle), totalToScan(0), totalDuration(0), tagReader(0), autoScanTags(false)
 {
 	iCount++;
 	setButtons(User1 | Ok | Cancel);
@@ -132,7 +138,8 @@ RgDialog::RgDialog(QWidget* parent)
 
 	italic = font();
 	italic.setItalic(true);
-	JobController::self()->setMaxActive(1);
+	// Scanners report how many tracks they are decoding, so keep all cores busy - even across albums
+	JobController::self()->setMaxActive(QThread::idealThreadCount());
 }
 
 RgDialog::~RgDialog()
@@ -273,6 +280,8 @@ void RgDialog::startScanning()
 	statusLabel->setVisible(true);
 	clearScanners();
 	totalToScan = 0;
+	totalDuration = 0;
+	scanTimer.start();
 	QMap<QString, QList<int>> groupedTracks;
 	for (int i = 0; i < origSongs.count(); ++i) {
 		if (!removedItems.contains(i) && (all || !origTags.contains(i))) {
@@ -286,10 +295,28 @@ void RgDialog::startScanning()
 	QMap<QString, QList<int>>::ConstIterator end(groupedTracks.constEnd());
 
 	for (; it != end; ++it) {
-		createScanner(*it);
-		totalToScan++;
+		QList<int> toScan;
+		QMap<int, AlbumScanner::Values> cached;
+		for (int i : *it) {
+			AlbumScanner::Values vals;
+			if (RgCache::self()->get(origSongs.at(i).filePath(base), vals)) {
+				cached.insert(i, vals);
+			}
+			else {
+				toScan.append(i);
+			}
+		}
+		if (toScan.isEmpty()) {
+			showResults(cached, AlbumScanner::calcAlbumValues(cached.values()), true);
+		}
+		else {
+			createScanner(toScan, cached);
+			totalToScan++;
+		}
 	}
 	progress->setRange(0, 100 * totalToScan);
+	// In case all tracks were cached
+	updateView();
 }
 
 void RgDialog::stopScanning()
@@ -304,17 +331,24 @@ void RgDialog::stopScanning()
 	setButtonGuiItem(Cancel, StdGuiItem::close());
 }
 
-void RgDialog::createScanner(const QList<int>& indexes)
+void RgDialog::createScanner(const QList<int>& indexes, const QMap<int, AlbumScanner::Values>& cached)
 {
 	QMap<int, QString> fileMap;
+	quint32 duration = 0;
 	for (int i : indexes) {
 		fileMap[i] = origSongs.at(i).filePath(base);
+		duration += origSongs.at(i).time > 0 ? origSongs.at(i).time : constDefaultTrackTime;
 	}
 
-	AlbumScanner* s = new AlbumScanner(fileMap);
+	AlbumScanner* s = new AlbumScanner(fileMap, QThread::idealThreadCount());
 	connect(s, SIGNAL(progress(int)), this, SLOT(scannerProgress(int)));
 	connect(s, SIGNAL(done()), this, SLOT(scannerDone()));
 	scanners[s] = 0;
+	scannerDurations[s] = duration;
+	if (!cached.isEmpty()) {
+		cachedValues[s] = cached;
+	}
+	totalDuration += duration;
 	JobController::self()->add(s);
 }
 
@@ -325,6 +359,8 @@ void RgDialog::clearScanners()
 		sc->stop();
 	}
 	scanners.clear();
+	scannerDurations.clear();
+	cachedValues.clear();
 }
 
 void RgDialog::startReadingTags()
@@ -391,6 +427,10 @@ bool RgDialog::saveTags()
 		case Tags::Update_BadFile:
 			failed.append(tr("%1 (Corrupt tags?)", "filename (Corrupt tags?)").arg(filePath));
 			break;
+		case Tags::Update_Modified:
+			// Only the tags have changed, so the cached values are still valid
+			RgCache::self()->touch(filePath);
+			break;
 		default:
 			break;
 		}
@@ -412,6 +452,7 @@ void RgDialog::updateView()
 {
 	int finished = 0;
 	quint64 totalProgress = 0;
+	quint64 scannedDuration = 0;
 	QMap<AlbumScanner*, int>::ConstIterator it = scanners.constBegin();
 	QMap<AlbumScanner*, int>::ConstIterator end = scanners.constEnd();
 
@@ -420,6 +461,7 @@ void RgDialog::updateView()
 			finished++;
 		}
 		totalProgress += (*it);
+		scannedDuration += (scannerDurations.value(it.key()) * static_cast<quint64>(it.value())) / 100;
 	}
 
 	if (finished == totalToScan) {
@@ -431,6 +473,12 @@ void RgDialog::updateView()
 	}
 	else {
 		progress->setValue(totalProgress);
+		// Estimate time remaining from how much audio has been decoded so far
+		qint64 elapsed = scanTimer.elapsed();
+		if (elapsed >= constMinEtaTime && scannedDuration > 0 && scannedDuration < totalDuration) {
+			quint32 remaining = ((totalDuration - scannedDuration) * elapsed) / (scannedDuration * 1000);
+			statusLabel->setText(tr("Scanning tracks, about %1 remaining...").arg(Utils::formatTime(remaining)));
+		}
 	}
 }
 
@@ -475,13 +523,37 @@ void RgDialog::scannerDone()
 		return;
 	}
 
-	const QMap<int, AlbumScanner::Values>& trackValues = s->trackValues();
+	QMap<int, AlbumScanner::Values> trackValues = s->trackValues();
+	AlbumScanner::Values albumValues = s->albumValues();
+	if (s->success()) {
+		QMap<QString, AlbumScanner::Values> toCache;
+		QMap<int, AlbumScanner::Values>::ConstIterator it(trackValues.constBegin());
+		QMap<int, AlbumScanner::Values>::ConstIterator end(trackValues.constEnd());
+		for (; it != end; ++it) {
+			toCache.insert(origSongs.at(it.key()).filePath(base), it.value());
+		}
+		RgCache::self()->add(toCache);
+	}
+	if (cachedValues.contains(s)) {
+		// Only some tracks were scanned, so the album values need to be calculated from all of the histograms
+		trackValues.insert(cachedValues.take(s));
+		albumValues = AlbumScanner::calcAlbumValues(trackValues.values());
+	}
+	showResults(trackValues, albumValues, s->success());
+
+	scanners[s] = 100;
+	updateView();
+	JobController::self()->finishedWith(s);
+}
+
+void RgDialog::showResults(const QMap<int, AlbumScanner::Values>& trackValues, const AlbumScanner::Values& albumValues, bool ok)
+{
 	QMap<int, AlbumScanner::Values>::ConstIterator it(trackValues.constBegin());
 	QMap<int, AlbumScanner::Values>::ConstIterator end(trackValues.constEnd());
 
-	if (s->success()) {
+	if (ok) {
 		for (; it != end; ++it) {
-			Tags::ReplayGain updatedTags(it.value().gain, s->albumValues().gain, it.value().peak, s->albumValues().peak);
+			Tags::ReplayGain updatedTags(it.value().gain, albumValues.gain, it.value().peak, albumValues.peak);
 			QTreeWidgetItem* item = view->topLevelItem(it.key());
 			if (it.value().ok) {
 				item->setText(COL_TRACKGAIN, tr("%1 dB").arg(Utils::formatNumber(updatedTags.trackGain, 2)));
@@ -493,7 +565,7 @@ void RgDialog::scannerDone()
 				item->setText(COL_TRACKGAIN, tr("Failed"));
 				item->setText(COL_TRACKPEAK, tr("Failed"));
 			}
-			if (s->albumValues().ok) {
+			if (albumValues.ok) {
 				item->setText(COL_ALBUMGAIN, tr("%1 dB").arg(Utils::formatNumber(updatedTags.albumGain, 2)));
 				if (!Utils::equal(updatedTags.albumPeak, 0.0)) {
 					item->setText(COL_ALBUMPEAK, Utils::formatNumber(updatedTags.albumPeak, 6));
@@ -567,10 +639,6 @@ void RgDialog::scannerDone()
 			tagsToSave.remove(it.key());
 		}
 	}
-
-	scanners[s] = 100;
-	updateView();
-	JobController::self()->finishedWith(s);
 }
 
 void RgDialog::songTags(int index, Tags::ReplayGain tags)
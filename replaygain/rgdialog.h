@@ -28,6 +28,7 @@
 #include "config.h"
 #include "tags/tags.h"
 #include "widgets/songdialog.h"
+#include <QElapsedTimer>
 #include <QFont>
 
 class QComboBox;
@@ -59,12 +60,13 @@ private:
 	void slotButtonClicked(int button);
 	void startScanning();
 	void stopScanning();
-	void createScanner(const QList<int>& indexes);
+	void createScanner(const QList<int>& indexes, const QMap<int, AlbumScanner::Values>& cached);
 	void clearScanners();
 	void startReadingTags();
 	void stopReadingTags();
 	bool saveTags();
 	void updateView();
+	void showResults(const QMap<int, AlbumScanner::Values>& trackValues, const AlbumScanner::Values& albumValues, bool ok);
 #ifdef ENABLE_DEVICES_SUPPORT
 	Device* getDevice(const QString& udi, QWidget* p);
 #endif
@@ -97,7 +99,11 @@ private:
 	QList<Song> origSongs;
 
 	QMap<AlbumScanner*, int> scanners;
+	QMap<AlbumScanner*, quint32> scannerDurations;
+	QMap<AlbumScanner*, QMap<int, AlbumScanner::Values>> cachedValues;// Tracks of a scanner's album that did not need scanning
 	int totalToScan;
+	quint64 totalDuration;
+	QElapsedTimer scanTimer;
 
 	QMap<int, Tags::ReplayGain> origTags;
 	QMap<int, Tags::ReplayGain> tagsToSave;
@@ -163,6 +163,11 @@ void TrackScanner::run()
 
 	size_t numFramesRead = 0;
 	size_t totalRead = 0;
+	// Gating blocks are 400ms long, and start every 100ms. Frames are added a step at a time, so that
+	// the momentary loudness can be read at the end of each block.
+	size_t blockStep = state->samplerate / 10;
+	size_t stepFrames = 0;
+	int steps = 0;
 	input->allocateBuffer();
 	while ((numFramesRead = input->readFrames())) {
 		if (abortRequested) {
@@ -171,9 +176,23 @@ void TrackScanner::run()
 		}
 		totalRead += numFramesRead;
 		emit progress((int)((totalRead * 100.0 / input->totalFrames()) + 0.5));
-		if (ebur128_add_frames_float(state, input->buffer(), numFramesRead)) {
-			setFinishedStatus(false);
-			return;
+		for (size_t offset = 0; offset < numFramesRead;) {
+			size_t count = qMin(numFramesRead - offset, blockStep - stepFrames);
+			if (ebur128_add_frames_float(state, input->buffer() + (offset * state->channels), count)) {
+				setFinishedStatus(false);
+				return;
+			}
+			offset += count;
+			stepFrames += count;
+			if (stepFrames == blockStep) {
+				stepFrames = 0;
+				if (++steps >= 4) {
+					double blockLoudness = 0.0;
+					if (0 == ebur128_loudness_momentary(state, &blockLoudness) && blockLoudness >= -70.0) {
+						data.histogram[qMin(static_cast<int>((blockLoudness + 70.0) * 10.0), constHistogramBins - 1)]++;
+					}
+				}
+			}
 		}
 	}
 
@@ -26,6 +26,7 @@
 
 #include "ebur128.h"
 #include "jobcontroller.h"
+#include <QMap>
 
 class Input;
 
@@ -33,6 +34,11 @@ class TrackScanner : public StandardJob {
 	Q_OBJECT
 
 public:
+	// Loudness of each 400ms gating block, in 0.1 LU bins from -70 LUFS (the absolute gate). This
+	// allows the album loudness to be calculated later, without having to decode the tracks again.
+	typedef QMap<quint16, quint32> Histogram;
+	static const int constHistogramBins = 1000;
+
 	struct Data {
 		Data()
 			: loudness(0.0), peak(0.0), truePeak(0.0)
@@ -42,6 +48,7 @@ public:
 		double loudness;
 		double peak;
 		double truePeak;
+		Histogram histogram;
 	};
 
 	static Data global(const QList<TrackScanner*>& scanners);
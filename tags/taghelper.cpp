@@ -28,6 +28,7 @@
 #include <QLocalServer>
 #include <QLocalSocket>
 #include <QThread>
+#include <QThreadPool>
 #include <QTimer>
 #include <QVariant>
 #ifdef Q_OS_WIN
@@ -59,7 +60,7 @@ static void deleteSocket()
 }
 
 TagHelper::TagHelper(const QString& sockName, int parent)
-	: parentPid(parent), dataSize(0)
+	: parentPid(parent), dataSize(0), batchRemaining(0)
 {
 	socket = new QLocalSocket(this);
 	socket->connectToServer(sockName);
@@ -175,10 +176,58 @@ void TagHelper::process()
 	else if (QLatin1String("readAll") == request) {
 		outStream << Tags::readAll(fileName);
 	}
+	else if (QLatin1String("readBatch") == request) {
+		QStringList fileNames;
+		inStream >> fileNames;
+		data.clear();
+		dataSize = 0;
+		readBatch(fileNames);
+		return;
+	}
 	else {
 		qApp->exit();
 	}
 
+	sendResponse(response);
+	data.clear();
+	dataSize = 0;
+}
+
+// Read files in the thread pool, and send each song back as soon as it has been read. Each response contains
+// the index of the file, and its song. A response with an index of -1 marks the end of the batch.
+void TagHelper::readBatch(const QStringList& fileNames)
+{
+	batchRemaining = fileNames.count();
+	if (0 == batchRemaining) {
+		batchRead(-1, Song());
+		return;
+	}
+	for (int i = 0; i < fileNames.count(); ++i) {
+		QString fileName = fileNames.at(i);
+		QThreadPool::globalInstance()->start([this, i, fileName]() {
+			Song song = Tags::read(fileName);
+			QMetaObject::invokeMethod(this, [this, i, song]() { batchRead(i, song); }, Qt::QueuedConnection);
+		});
+	}
+}
+
+void TagHelper::batchRead(int index, const Song& song)
+{
+	QByteArray response;
+	QDataStream outStream(&response, QIODevice::WriteOnly);
+	outStream << qint32(index);
+	if (index >= 0) {
+		outStream << song;
+	}
+	sendResponse(response);
+
+	if (index >= 0 && 0 == --batchRemaining) {
+		batchRead(-1, Song());
+	}
+}
+
+void TagHelper::sendResponse(const QByteArray& response)
+{
 	DBUG << "RESP" << response.size();
 	QDataStream writeStream(socket);
 	writeStream << qint32(response.length());
@@ -186,8 +235,6 @@ void TagHelper::process()
 		writeStream.writeRawData(response.data(), response.length());
 	}
 	socket->flush();
-	data.clear();
-	dataSize = 0;
 }
 
 #include "moc_taghelper.cpp"
@@ -24,8 +24,10 @@
 #ifndef TAG_HELPER_H
 #define TAG_HELPER_H
 
+#include "mpd-interface/song.h"
 #include <QByteArray>
 #include <QObject>
+#include <QStringList>
 
 class QLocalSocket;
 
@@ -44,12 +46,16 @@ private Q_SLOTS:
 
 private:
 	void process();
+	void readBatch(const QStringList& fileNames);
+	void batchRead(int index, const Song& song);
+	void sendResponse(const QByteArray& response);
 
 private:
 	int parentPid;
 	QLocalSocket* socket;
 	qint32 dataSize;
 	QByteArray data;
+	int batchRemaining;
 };
 
 #endif
@@ -47,7 +47,7 @@ void TagHelperIface::enableDebug()
 GLOBAL_STATIC(TagHelperIface, instance)
 
 TagHelperIface::TagHelperIface()
-	: msgStatus(true), dataSize(0), awaitingResponse(false), thread(nullptr), proc(nullptr), server(nullptr), sock(nullptr)
+	: msgStatus(true), dataSize(0), awaitingResponse(false), awaitingBatch(false), thread(nullptr), proc(nullptr), server(nullptr), sock(nullptr)
 {
 	qRegisterMetaType<QAbstractSocket::SocketError>("QAbstractSocket::SocketError");
 	thread = new Thread(metaObject()->className());
@@ -83,6 +83,20 @@ Song TagHelperIface::read(const QString& fileName)
 	return resp;
 }
 
+QList<Song> TagHelperIface::read(const QStringList& fileNames)
+{
+	DBUG << fileNames.count();
+	if (fileNames.isEmpty()) {
+		return QList<Song>();
+	}
+	QByteArray message;
+	QDataStream outStream(&message, QIODevice::WriteOnly);
+	outStream << QString("readBatch") << QString() << fileNames;
+	Reply reply = sendMessage(message, fileNames.count());
+	// If the helper failed part way through, then the songs it did not get to will be empty
+	return reply.songs;
+}
+
 QImage TagHelperIface::readImage(const QString& fileName)
 {
 	DBUG << fileName;
@@ -278,16 +292,23 @@ QMap<QString, QString> TagHelperIface::readAll(const QString& fileName)
 	return resp;
 }
 
-TagHelperIface::Reply TagHelperIface::sendMessage(const QByteArray& msg)
+TagHelperIface::Reply TagHelperIface::sendMessage(const QByteArray& msg, int batchSize)
 {
 	QMutexLocker locker(&mutex);
 	data = msg;
+	awaitingBatch = batchSize >= 0;
+	batchSongs.clear();
+	if (awaitingBatch) {
+		batchSongs.resize(batchSize);
+	}
 	metaObject()->invokeMethod(this, "sendMsg", Qt::QueuedConnection);
 	sema.acquire();
 	TagHelperIface::Reply reply;
 	reply.status = msgStatus;
 	reply.data = data;
-	DBUG << "Message response - " << reply.status << reply.data.length();
+	reply.songs = batchSongs;
+	batchSongs.clear();
+	DBUG << "Message response - " << reply.status << reply.data.length() << reply.songs.count();
 	return reply;
 }
 
@@ -425,7 +446,25 @@ void TagHelperIface::dataReady()
 
 		data += sock->read(dataSize - data.length());
 		if (data.length() == dataSize) {
-			DBUG << "Response fully received";
+			if (awaitingBatch) {
+				// Songs of a batch are sent one per response, as the helper reads them
+				QDataStream stream(data);
+				qint32 index = -1;
+				stream >> index;
+				if (index >= 0 && index < batchSongs.count()) {
+					stream >> batchSongs[index];
+				}
+				data.clear();
+				dataSize = 0;
+				if (index >= 0) {
+					continue;
+				}
+				DBUG << "Batch fully received";
+				awaitingBatch = false;
+			}
+			else {
+				DBUG << "Response fully received";
+			}
 			setStatus(true);
 			break;
 		}
@@ -26,6 +26,7 @@
 
 #include "mpd-interface/song.h"
 #include <QImage>
+#include <QList>
 #include <QMap>
 #include <QMutex>
 #include <QSemaphore>
@@ -50,11 +51,14 @@ public:
 	struct Reply {
 		bool status;
 		QByteArray data;
+		QList<Song> songs;
 	};
 
 	TagHelperIface();
 	void stop();
 	Song read(const QString& fileName);
+	// Read several files at once - the helper reads these in parallel. Returned list has the same order as fileNames.
+	QList<Song> read(const QStringList& fileNames);
 	QImage readImage(const QString& fileName);
 	QString readLyrics(const QString& fileName);
 	QString readComment(const QString& fileName);
@@ -70,7 +74,7 @@ public:
 
 private:
 	bool helperIsRunning();
-	Reply sendMessage(const QByteArray& msg);
+	Reply sendMessage(const QByteArray& msg, int batchSize = -1);
 	bool startHelper();
 	void setStatus(bool st);
 
@@ -87,6 +91,8 @@ private:
 	bool msgStatus;
 	qint32 dataSize;
 	bool awaitingResponse;
+	bool awaitingBatch;
+	QList<Song> batchSongs;
 	Thread* thread;
 	QSemaphore sema;
 	QProcess* proc;
@@ -196,11 +196,9 @@ struct RgTagsStrings {
 
 static void ensureFileTypeResolvers()
 {
-	static bool alreadyAdded = false;
-	if (!alreadyAdded) {
-		alreadyAdded = true;
-		TagLib::FileRef::addFileTypeResolver(new Meta::Tag::FileTypeResolver());
-	}
+	// Files may be read from several threads at once, so use a static initialiser to only add this once
+	static const bool added = (TagLib::FileRef::addFileTypeResolver(new Meta::Tag::FileTypeResolver()), true);
+	Q_UNUSED(added)
 }
 
 static TagLib::FileRef getFileRef(const QString& path)
@@ -65,6 +65,7 @@ void enableDebug();
 inline void init() { TagHelperIface::self(); }
 inline void stop() { TagHelperIface::self()->stop(); }
 inline Song read(const QString& fileName) { return TagHelperIface::self()->read(fileName); }
+inline QList<Song> read(const QStringList& fileNames) { return TagHelperIface::self()->read(fileNames); }
 inline QImage readImage(const QString& fileName) { return TagHelperIface::self()->readImage(fileName); }
 inline QString readLyrics(const QString& fileName) { return TagHelperIface::self()->readLyrics(fileName); }
 inline QString readComment(const QString& fileName) { return TagHelperIface::self()->readComment(fileName); }
@@ -0,0 +1,234 @@
+/*
+ * Cantata
+ *
+ * Copyright (c) 2011-2022 Craig Drummond <craig.p.drummond@gmail.com>
+ *
+ * ----
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+// Checks how PartialDownload resumes an episode download, against a local HTTP server that serves a single
+// file and honours Range / If-Range as a real server would - or is told to ignore the range, or to reply with
+// a range other than the one asked for.
+
+#include "online/partialdownload.h"
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QFile>
+#include <QNetworkAccessManager>
+#include <QNetworkProxy>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <stdio.h>
+
+class Server : public QTcpServer {
+public:
+	enum Mode {
+		Honour,
+		IgnoreRange,
+		WrongRange
+	};
+
+	Server()
+		: mode(Honour)
+	{
+		for (int i = 0; i < 100000; ++i) {
+			content += char('a' + (i % 26));
+		}
+		etag = "\"v1\"";
+		connect(this, &QTcpServer::newConnection, this, [this]() {
+			while (hasPendingConnections()) {
+				QTcpSocket* sock = nextPendingConnection();
+				connect(sock, &QTcpSocket::readyRead, sock, [this, sock]() { handle(sock); });
+				connect(sock, &QTcpSocket::disconnected, sock, &QObject::deleteLater);
+			}
+		});
+	}
+
+	QByteArray content;
+	QByteArray etag;
+	Mode mode;
+	QByteArray lastRange;
+
+private:
+	void handle(QTcpSocket* sock)
+	{
+		QByteArray req = sock->property("req").toByteArray() + sock->readAll();
+		sock->setProperty("req", req);
+		if (!req.contains("\r\n\r\n")) {
+			return;
+		}
+
+		QByteArray range;
+		QByteArray ifRange;
+		for (const QByteArray& line : req.split('\n')) {
+			QByteArray l = line.trimmed();
+			if (l.toLower().startsWith("range:")) {
+				range = l.mid(6).trimmed();
+			}
+			else if (l.toLower().startsWith("if-range:")) {
+				ifRange = l.mid(9).trimmed();
+			}
+		}
+		lastRange = range;
+
+		qint64 start = 0;
+		bool partial = false;
+		if (range.startsWith("bytes=")) {
+			if (WrongRange == mode) {
+				// Always send from the start of the file, but as a 206
+				partial = true;
+			}
+			else if (Honour == mode && (ifRange.isEmpty() || ifRange == etag)) {
+				start = range.mid(6, range.indexOf('-') - 6).toLongLong();
+				partial = true;
+			}
+		}
+
+		QByteArray reply;
+		if (partial && start >= content.size()) {
+			reply = "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */" + QByteArray::number(content.size()) + "\r\n";
+		}
+		else if (partial) {
+			reply = "HTTP/1.1 206 Partial Content\r\nContent-Range: bytes " + QByteArray::number(start) + '-' + QByteArray::number(content.size() - 1) + '/' + QByteArray::number(content.size()) + "\r\n";
+		}
+		else {
+			reply = "HTTP/1.1 200 OK\r\n";
+		}
+		QByteArray body = reply.startsWith("HTTP/1.1 416") ? QByteArray() : content.mid(start);
+		reply += "ETag: " + etag + "\r\nContent-Length: " + QByteArray::number(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+		sock->write(reply);
+		sock->disconnectFromHost();
+	}
+};
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+	printf("%s: %s\n", ok ? "PASS" : "FAIL", what);
+	if (!ok) {
+		++failures;
+	}
+}
+
+static QByteArray readFile(const QString& name)
+{
+	QFile f(name);
+	return f.open(QIODevice::ReadOnly) ? f.readAll() : QByteArray();
+}
+
+static void writeFile(const QString& name, const QByteArray& data)
+{
+	QFile f(name);
+	if (f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		f.write(data);
+	}
+}
+
+// Download as PodcastService does - resume from the partial file, check the first data, append, and complete.
+// Returns false if PartialDownload::start() rejected the reply.
+static bool download(QNetworkAccessManager& nam, const QUrl& url, const QString& dest, qint64& offset, int& status)
+{
+	QNetworkRequest req(url);
+	offset = PartialDownload::prepare(dest, req);
+	QNetworkReply* reply = nam.get(req);
+	QEventLoop loop;
+	QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+	QTimer::singleShot(10000, &loop, &QEventLoop::quit);
+	loop.exec();
+	status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+	bool ok = false;
+	if (200 == status || 206 == status) {
+		if (PartialDownload::start(dest, reply)) {
+			ok = PartialDownload::append(dest, reply, reply->bytesAvailable()) && PartialDownload::complete(dest);
+		}
+	}
+	else if (416 == status) {
+		PartialDownload::remove(dest);
+	}
+	reply->deleteLater();
+	return ok;
+}
+
+int main(int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+	QTemporaryDir tmp;
+	Server server;
+	if (!tmp.isValid() || !server.listen(QHostAddress::LocalHost)) {
+		printf("FAIL: could not start server\n");
+		return 1;
+	}
+
+	QNetworkAccessManager nam;
+	nam.setProxy(QNetworkProxy::NoProxy);
+	QUrl url(QString("http://127.0.0.1:%1/episode.mp3").arg(server.serverPort()));
+	QString dest = tmp.path() + "/episode.mp3";
+	QString partial = PartialDownload::fileName(dest);
+	QString validator = dest + ".partial-validator";
+	const QByteArray& content = server.content;
+	qint64 offset = 0;
+	int status = 0;
+
+	// Whole file, then an interrupted download is resumed with a 206
+	check(download(nam, url, dest, offset, status) && 200 == status && readFile(dest) == content, "first download is complete");
+	writeFile(partial, content.left(30000));
+	writeFile(validator, server.etag);
+	check(download(nam, url, dest, offset, status) && 206 == status && 30000 == offset, "resume is sent Range/If-Range and gets 206");
+	check(server.lastRange == "bytes=30000-", "resume asks for the missing part");
+	check(readFile(dest) == content, "resumed file matches");
+	check(!QFile::exists(partial) && !QFile::exists(validator), "partial and validator removed once complete");
+
+	// Server ignores the range, and sends the whole file - partial file must be replaced, not appended to
+	server.mode = Server::IgnoreRange;
+	writeFile(partial, content.left(30000));
+	writeFile(validator, server.etag);
+	check(download(nam, url, dest, offset, status) && 200 == status && readFile(dest) == content, "200 after Range replaces partial file");
+
+	// File has changed on the server, so If-Range no longer matches and the whole (new) file is sent
+	server.mode = Server::Honour;
+	server.content[0] = 'Z';
+	server.etag = "\"v2\"";
+	writeFile(partial, content.left(30000));
+	writeFile(validator, "\"v1\"");
+	check(download(nam, url, dest, offset, status) && 200 == status && readFile(dest) == server.content, "changed validator downloads new file");
+
+	// 206 that does not start at the end of the partial file is rejected, and the partial file removed
+	server.mode = Server::WrongRange;
+	writeFile(partial, server.content.left(30000));
+	writeFile(validator, server.etag);
+	check(!download(nam, url, dest, offset, status) && 206 == status && !QFile::exists(partial), "206 at wrong offset discards partial file");
+
+	// Partial file without a validator cannot be resumed
+	server.mode = Server::Honour;
+	writeFile(partial, server.content.left(30000));
+	QFile::remove(validator);
+	check(download(nam, url, dest, offset, status) && 0 == offset && server.lastRange.isEmpty() && readFile(dest) == server.content,
+	      "partial file without validator is downloaded again");
+
+	// Partial file is as large as the file - 416, and it is discarded
+	writeFile(partial, server.content + "extra");
+	writeFile(validator, server.etag);
+	check(!download(nam, url, dest, offset, status) && 416 == status && !QFile::exists(partial), "416 discards partial file");
+
+	return failures ? 1 : 0;
+}
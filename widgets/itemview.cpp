@@ -690,7 +690,7 @@ ItemView::ItemView(QWidget* p)
 	  ,
 	  categorizedView(nullptr)
 	  ,
-	  spinner(nullptr), msgOverlay(nullptr), performedSearch(false), searchResetLevel(0), openFirstLevelAfterSearch(false), initialised(false), minSearchDebounce(250)
+	  spinner(nullptr), msgOverlay(nullptr), performedSearch(false), searchResetLevel(0), openFirstLevelAfterSearch(false), initialised(false), minSearchDebounce(250), prefetchTimer(nullptr)
 {
 	setupUi(this);
 	if (!backAction) {
@@ -733,6 +733,7 @@ ItemView::ItemView(QWidget* p)
 	connect(title, SIGNAL(addToPlayQueue()), this, SLOT(addTitleButtonClicked()));
 	connect(title, SIGNAL(replacePlayQueue()), this, SLOT(replaceTitleButtonClicked()));
 	connect(Covers::self(), SIGNAL(loaded(Song, int)), this, SLOT(coverLoaded(Song, int)));
+	connect(listView->verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(startPrefetchTimer()));
 	searchWidget->setVisible(false);
 #ifdef Q_OS_MAC
 	treeView->setAttribute(Qt::WA_MacShowFocusRect, 0);
@@ -1762,16 +1763,93 @@ void ItemView::replaceTitleButtonClicked()
 
 void ItemView::coverLoaded(const Song& song, int size)
 {
-	Q_UNUSED(song)
-
 	if (Mode_BasicTree == mode || Mode_GroupedTree == mode || !isVisible() || (Mode_IconTop == mode && size != zoomedSize(listView, gridCoverSize)) || (Mode_IconTop != mode && Mode_Categorized != mode && size != listCoverSize)
 	    || (Mode_Categorized == mode && size != zoomedSize(categorizedView, gridCoverSize))
 	) {
 		return;
 	}
+
+	// Only repaint the items using this cover, if these can be determined
+	int first = 0;
+	int last = 0;
+	if (view() == listView && visibleRows(first, last)) {
+		bool iconMode = Mode_IconTop == mode;
+		QModelIndex root = listView->rootIndex();
+		for (int r = first; r <= last; ++r) {
+			QModelIndex idx = listView->model()->index(r, 0, root);
+			if (!iconMode && !idx.data(Cantata::Role_ListImage).toBool()) {
+				continue;
+			}
+			Song cSong = idx.data(iconMode ? Cantata::Role_GridCoverSong : Cantata::Role_CoverSong).value<Song>();
+			if (!cSong.isEmpty() && Covers::sameCover(cSong, song)) {
+				listView->update(idx);
+			}
+		}
+		return;
+	}
 	view()->viewport()->update();
 }
 
+bool ItemView::visibleRows(int& first, int& last) const
+{
+	if (!listView->model()) {
+		return false;
+	}
+	QRect r = listView->viewport()->rect();
+	QModelIndex top = listView->indexAt(r.topLeft() + QPoint(1, 1));
+	if (!top.isValid()) {
+		return false;
+	}
+	QModelIndex bottom = listView->indexAt(r.bottomRight() - QPoint(1, 1));
+	if (!bottom.isValid()) {// Last row of grid may not be full...
+		bottom = listView->indexAt(r.bottomLeft() + QPoint(1, -1));
+	}
+	first = top.row();
+	last = bottom.isValid() ? bottom.row() : (listView->model()->rowCount(listView->rootIndex()) - 1);
+	return last >= first;
+}
+
+void ItemView::startPrefetchTimer()
+{
+	if (!prefetchTimer) {
+		prefetchTimer = new QTimer(this);
+		prefetchTimer->setSingleShot(true);
+		connect(prefetchTimer, SIGNAL(timeout()), this, SLOT(prefetchCovers()));
+	}
+	prefetchTimer->start(100);
+}
+
+// Request the covers of a page of items either side of those visible, so that these have been
+// loaded (in the background) by the time they are scrolled into view.
+void ItemView::prefetchCovers()
+{
+	int first = 0;
+	int last = 0;
+	if (!isVisible() || view() != listView || !visibleRows(first, last)) {
+		return;
+	}
+
+	bool iconMode = Mode_IconTop == mode;
+	int size = iconMode ? zoomedSize(listView, gridCoverSize) : listCoverSize;
+	int page = (last - first) + 1;
+	QAbstractItemModel* model = listView->model();
+	QModelIndex root = listView->rootIndex();
+	int rowCount = model->rowCount(root);
+	for (int r = qMax(0, first - page); r < qMin(rowCount, last + page + 1); ++r) {
+		if (r >= first && r <= last) {
+			continue;
+		}
+		QModelIndex idx = model->index(r, 0, root);
+		if (!iconMode && !idx.data(Cantata::Role_ListImage).toBool()) {
+			continue;
+		}
+		Song cSong = idx.data(iconMode ? Cantata::Role_GridCoverSong : Cantata::Role_CoverSong).value<Song>();
+		if (!cSong.isEmpty()) {
+			Covers::self()->prefetch(cSong, size);
+		}
+	}
+}
+
 void ItemView::zoomIn()
 {
 	if (listView->isVisible() && Mode_IconTop == mode) {
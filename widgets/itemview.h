@@ -189,6 +189,8 @@ private Q_SLOTS:
 	void addTitleButtonClicked();
 	void replaceTitleButtonClicked();
 	void coverLoaded(const Song& song, int size);
+	void startPrefetchTimer();
+	void prefetchCovers();
 	void zoomIn();
 	void zoomOut();
 
@@ -196,6 +198,7 @@ private:
 	QAction* getAction(const QModelIndex& index);
 	void setTitle();
 	void controlViewFrame();
+	bool visibleRows(int& first, int& last) const;
 
 private:
 	QTimer* searchTimer;
@@ -216,6 +219,7 @@ private:
 	bool openFirstLevelAfterSearch;
 	bool initialised;
 	unsigned int minSearchDebounce;
+	QTimer* prefetchTimer;
 };
 
 #endif
@@ -49,7 +49,10 @@
 #include <QToolButton>
 #include <QToolTip>
 
-static const int constPollMpd = 5;// Poll every X seconds when playing
+// Position is calculated locally from the last status, and MPD informs us (via idle) of any player
+// changes, so status is only re-read occasionally to correct any drift...
+static const int constPollMpd = 60;// Poll every X seconds when playing
+static const int constEndSlack = 2;// ...or if we appear to have gone this many seconds past the end
 static const char* constUserSettingProp = "user-setting";
 
 class PosSliderProxyStyle : public QProxyStyle {
@@ -251,7 +254,7 @@ void PosSlider::setRange(int min, int max)
 }
 
 NowPlayingWidget::NowPlayingWidget(QWidget* p)
-	: QWidget(p), timer(nullptr), lastVal(0), pollCount(0)
+	: QWidget(p), timer(nullptr), lastVal(0), pollCount(0), polledAtEnd(false)
 {
 	track = new SqueezedTextLabel(this);
 	artist = new SqueezedTextLabel(this);
@@ -327,6 +330,7 @@ NowPlayingWidget::NowPlayingWidget(QWidget* p)
 void NowPlayingWidget::update(const Song& song)
 {
 	currentSongFile = song.file;
+	polledAtEnd = false;
 	ratingWidget->setEnabled(!song.isEmpty() && Song::Standard == song.type);
 	ratingWidget->setValue(0);
 	updateInfo();
@@ -417,10 +421,14 @@ void NowPlayingWidget::updateTimes()
 void NowPlayingWidget::updatePos()
 {
 	quint16 elapsed = (elapsedTimer.elapsed() / 1000.0) + 0.5;
-	slider->setValue(lastVal + elapsed);
-	MPDStatus::self()->setGuessedElapsed(lastVal + elapsed);
-	if (++pollCount >= constPollMpd) {
+	int pos = lastVal + elapsed;
+	slider->setValue(pos);
+	MPDStatus::self()->setGuessedElapsed(pos);
+	// If the song should have finished, but we have not been told of a new one, then check once
+	bool pastEnd = !polledAtEnd && slider->maximum() > 0 && pos > slider->maximum() + constEndSlack;
+	if (pastEnd || ++pollCount >= constPollMpd) {
 		pollCount = 0;
+		polledAtEnd = polledAtEnd || pastEnd;
 		emit mpdPoll();
 	}
 }
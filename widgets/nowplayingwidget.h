@@ -104,6 +104,7 @@ private:
 	QString currentSongFile;
 	int lastVal;
 	int pollCount;
+	bool polledAtEnd;
 };
 
 #endif